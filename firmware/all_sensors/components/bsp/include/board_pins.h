@@ -28,6 +28,16 @@
 #define BSP_ADC_ATTEN           ADC_ATTEN_DB_12
 #define BSP_ADC_WIDTH           ADC_BITWIDTH_9
 
+/* =========================================================================
+	SECTION: ADC (Battery)
+	========================================================================= */
+// Sampled together with the soil probe, same unit. Battery through a 1:1
+// divider (100k/100k), so the pin sees half the cell voltage.
+#define BSP_ADC_BATT_PIN        GPIO_NUM_35
+#define BSP_ADC_BATT_CHANNEL    ADC_CHANNEL_7
+#define BSP_ADC_BATT_ATTEN      ADC_ATTEN_DB_12
+#define BSP_BATT_DIVIDER_MUL    2U
+
 /* =========================================================================
 	SECTION: Buttons
 	========================================================================= */
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/i2c_master.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Backend (Types)
+   ========================================================================= */
+#define BSP_BUS_ADC 0xFFU   // target.bus for ADC reads; target.addr is the channel
+
+typedef enum {
+    BSP_BUS_OP_PROBE = 0,
+    BSP_BUS_OP_WRITE,
+    BSP_BUS_OP_READ,
+    BSP_BUS_OP_WRITE_READ,
+    BSP_BUS_OP_ADC,
+    BSP_BUS_OP_ADC_DMA,
+} bsp_bus_op_t;
+
+// What a transfer is aimed at, resolved by the BSP before the backend runs,
+// so a backend never has to look inside driver handles.
+typedef struct {
+    uint8_t bus;            // bsp_i2c_bus_id_t or BSP_BUS_ADC
+    uint16_t addr;          // 7-bit I2C address or ADC channel
+    uint32_t scl_speed_hz;  // 0 when unknown (probe) or ADC
+} bsp_bus_target_t;
+
+// Every driver transfer goes through one of these. The hardware backend
+// calls the ESP-IDF drivers; others can wrap it (recorder) or replace it
+// (scripted device models on a host build).
+typedef struct {
+    esp_err_t (*i2c_probe)(void *ctx, i2c_master_bus_handle_t bus, const bsp_bus_target_t *target, int timeout_ms);
+    // tx_len == 0: plain read, rx_len == 0: plain write, both: write then read.
+    esp_err_t (*i2c_transfer)(void *ctx,
+                              i2c_master_dev_handle_t dev,
+                              const bsp_bus_target_t *target,
+                              const uint8_t *tx_buf,
+                              size_t tx_len,
+                              uint8_t *rx_buf,
+                              size_t rx_len,
+                              int timeout_ms);
+    esp_err_t (*adc_read)(void *ctx, adc_oneshot_unit_handle_t unit, adc_channel_t channel, int *out_raw);
+    esp_err_t (*adc_dma_read)(void *ctx,
+                              adc_continuous_handle_t handle,
+                              uint8_t *buf,
+                              uint32_t len,
+                              uint32_t *out_len,
+                              uint32_t timeout_ms);
+    void *ctx;
+} bsp_bus_backend_t;
+
+/* =========================================================================
+   SECTION: Recorder (Types)
+   ========================================================================= */
+typedef struct {
+    uint32_t t_us;      // recorder clock when the transfer started
+    uint32_t bus_us;    // estimated wire time at the device clock, 0 for ADC
+    uint16_t addr;
+    uint16_t tx_len;
+    uint16_t rx_len;
+    uint8_t bus;
+    uint8_t op;         // bsp_bus_op_t
+    int32_t err;
+} bsp_bus_record_t;
+
+typedef uint32_t (*bsp_bus_clock_fn_t)(void);
+
+typedef struct {
+    bsp_bus_backend_t backend;      // install this one
+    const bsp_bus_backend_t *inner; // where transfers are forwarded
+    bsp_bus_clock_fn_t now_us;      // NULL: esp_timer; a host build passes a virtual clock
+    bsp_bus_record_t *records;
+    size_t capacity;
+    size_t count;
+    uint32_t dropped;               // transfers past capacity, still in the totals
+    uint32_t total_transfers;
+    uint32_t total_bytes;
+    uint32_t total_bus_us;
+    portMUX_TYPE lock;              // display and sensor tasks record concurrently
+} bsp_bus_recorder_t;
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+const bsp_bus_backend_t *bsp_bus_hw_backend(void);
+const bsp_bus_backend_t *bsp_bus_get_backend(void);
+// NULL restores the hardware backend. Swap only while no transfer is running.
+void bsp_bus_set_backend(const bsp_bus_backend_t *backend);
+
+esp_err_t bsp_adc_read(adc_oneshot_unit_handle_t unit, adc_channel_t channel, int *out_raw);
+esp_err_t bsp_adc_dma_read(adc_continuous_handle_t handle,
+                           uint8_t *buf,
+                           uint32_t len,
+                           uint32_t *out_len,
+                           uint32_t timeout_ms);
+
+// Records into `records` and forwards to `inner` (NULL: hardware).
+void bsp_bus_recorder_init(bsp_bus_recorder_t *rec,
+                           const bsp_bus_backend_t *inner,
+                           bsp_bus_record_t *records,
+                           size_t capacity,
+                           bsp_bus_clock_fn_t now_us);
+void bsp_bus_recorder_reset(bsp_bus_recorder_t *rec);
+// One "S" summary line and one "T" line per record, read by
+// scripts/bus_trace/compare_bus_trace.py.
+void bsp_bus_recorder_dump(bsp_bus_recorder_t *rec);
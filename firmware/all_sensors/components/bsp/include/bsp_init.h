@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
 #include "driver/i2c_master.h"
 #include "esp_err.h"
 
@@ -8,8 +10,49 @@
 #endif
 
 /* =========================================================================
-   SECTION: I2C Helpers (Disposable Buses)
+   SECTION: I2C Bus Manager (Types)
    ========================================================================= */
-esp_err_t bsp_i2c_create_display_bus(i2c_master_bus_handle_t *out_bus);
-esp_err_t bsp_i2c_create_sensors_bus(i2c_master_bus_handle_t *out_bus);
-esp_err_t bsp_i2c_del_bus(i2c_master_bus_handle_t bus);
+typedef enum {
+    BSP_I2C_BUS_DISPLAY = 0,
+    BSP_I2C_BUS_SENSORS,
+    BSP_I2C_BUS_COUNT
+} bsp_i2c_bus_id_t;
+
+// Counters since boot; they survive the bus being deleted and re-created.
+typedef struct {
+    uint32_t creates;       // times the bus was brought up
+    uint32_t transactions;  // transfers and address probes
+    uint32_t bytes;         // payload written + read
+    uint32_t errors;        // transfers that did not return ESP_OK
+} bsp_i2c_stats_t;
+
+/* =========================================================================
+   SECTION: I2C Bus Manager (API)
+   ========================================================================= */
+// Creates the bus manager lock. Call once at boot, before any task touches a
+// bus; app_context_init does it.
+esp_err_t bsp_init(void);
+
+// Refcounted: the first acquire creates the bus, the last release deletes it
+// together with every device attached to it.
+esp_err_t bsp_i2c_bus_acquire(bsp_i2c_bus_id_t id, i2c_master_bus_handle_t *out_bus);
+esp_err_t bsp_i2c_bus_release(bsp_i2c_bus_id_t id);
+
+// Device handles are owned by the manager and stay attached while the bus
+// lives; callers never remove them.
+esp_err_t bsp_i2c_device_get(i2c_master_bus_handle_t bus,
+                             uint16_t addr,
+                             uint32_t scl_speed_hz,
+                             i2c_master_dev_handle_t *out_dev);
+
+esp_err_t bsp_i2c_probe(i2c_master_bus_handle_t bus, uint16_t addr, int timeout_ms);
+esp_err_t bsp_i2c_transmit(i2c_master_dev_handle_t dev, const uint8_t *buf, size_t len, int timeout_ms);
+esp_err_t bsp_i2c_receive(i2c_master_dev_handle_t dev, uint8_t *buf, size_t len, int timeout_ms);
+esp_err_t bsp_i2c_transmit_receive(i2c_master_dev_handle_t dev,
+                                   const uint8_t *tx_buf,
+                                   size_t tx_len,
+                                   uint8_t *rx_buf,
+                                   size_t rx_len,
+                                   int timeout_ms);
+
+esp_err_t bsp_i2c_get_stats(bsp_i2c_bus_id_t id, bsp_i2c_stats_t *out_stats);
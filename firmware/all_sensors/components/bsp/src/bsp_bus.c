@@ -0,0 +1,288 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "bsp_bus.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define BSP_BUS_BITS_PER_BYTE    9U   // 8 data + ACK
+#define BSP_BUS_BITS_START_STOP  2U
+
+/* =========================================================================
+   SECTION: Static Data
+   ========================================================================= */
+static const char *TAG = "BUS_TRACE";
+
+/* =========================================================================
+   SECTION: Hardware Backend
+   ========================================================================= */
+static esp_err_t hw_i2c_probe(void *ctx, i2c_master_bus_handle_t bus, const bsp_bus_target_t *target, int timeout_ms)
+{
+    (void)ctx;
+    return i2c_master_probe(bus, target->addr, timeout_ms);
+}
+
+static esp_err_t hw_i2c_transfer(void *ctx,
+                                 i2c_master_dev_handle_t dev,
+                                 const bsp_bus_target_t *target,
+                                 const uint8_t *tx_buf,
+                                 size_t tx_len,
+                                 uint8_t *rx_buf,
+                                 size_t rx_len,
+                                 int timeout_ms)
+{
+    (void)ctx;
+    (void)target;
+    if (rx_len == 0U) {
+        return i2c_master_transmit(dev, tx_buf, tx_len, timeout_ms);
+    }
+    if (tx_len == 0U) {
+        return i2c_master_receive(dev, rx_buf, rx_len, timeout_ms);
+    }
+    return i2c_master_transmit_receive(dev, tx_buf, tx_len, rx_buf, rx_len, timeout_ms);
+}
+
+static esp_err_t hw_adc_read(void *ctx, adc_oneshot_unit_handle_t unit, adc_channel_t channel, int *out_raw)
+{
+    (void)ctx;
+    return adc_oneshot_read(unit, channel, out_raw);
+}
+
+static esp_err_t hw_adc_dma_read(void *ctx,
+                                 adc_continuous_handle_t handle,
+                                 uint8_t *buf,
+                                 uint32_t len,
+                                 uint32_t *out_len,
+                                 uint32_t timeout_ms)
+{
+    (void)ctx;
+    return adc_continuous_read(handle, buf, len, out_len, timeout_ms);
+}
+
+static const bsp_bus_backend_t s_hw_backend = {
+    .i2c_probe = hw_i2c_probe,
+    .i2c_transfer = hw_i2c_transfer,
+    .adc_read = hw_adc_read,
+    .adc_dma_read = hw_adc_dma_read,
+    .ctx = NULL,
+};
+
+static const bsp_bus_backend_t *s_backend = &s_hw_backend;
+
+/* =========================================================================
+   SECTION: Recorder Backend
+   ========================================================================= */
+static uint32_t rec_now_us(const bsp_bus_recorder_t *rec)
+{
+    return (rec->now_us != NULL) ? rec->now_us() : (uint32_t)esp_timer_get_time();
+}
+
+// Wire time of an I2C transaction: address byte per (repeated) START plus
+// payload, 9 clocks per byte.
+static uint32_t rec_wire_us(const bsp_bus_target_t *target, bsp_bus_op_t op, size_t tx_len, size_t rx_len)
+{
+    if ((target->scl_speed_hz == 0U) || (op >= BSP_BUS_OP_ADC)) {
+        return 0U;
+    }
+
+    uint32_t bits = 0;
+    switch (op) {
+        case BSP_BUS_OP_PROBE:
+            bits = BSP_BUS_BITS_PER_BYTE + BSP_BUS_BITS_START_STOP;
+            break;
+        case BSP_BUS_OP_WRITE_READ:
+            bits = (uint32_t)(2U + tx_len + rx_len) * BSP_BUS_BITS_PER_BYTE + BSP_BUS_BITS_START_STOP + 1U;
+            break;
+        default:
+            bits = (uint32_t)(1U + tx_len + rx_len) * BSP_BUS_BITS_PER_BYTE + BSP_BUS_BITS_START_STOP;
+            break;
+    }
+    return (uint32_t)(((uint64_t)bits * 1000000ULL + target->scl_speed_hz - 1U) / target->scl_speed_hz);
+}
+
+static void rec_add(bsp_bus_recorder_t *rec,
+                    uint32_t t_us,
+                    const bsp_bus_target_t *target,
+                    bsp_bus_op_t op,
+                    size_t tx_len,
+                    size_t rx_len,
+                    esp_err_t err)
+{
+    const bsp_bus_record_t rec_new = {
+        .t_us = t_us,
+        .bus_us = rec_wire_us(target, op, tx_len, rx_len),
+        .addr = target->addr,
+        .tx_len = (uint16_t)tx_len,
+        .rx_len = (uint16_t)rx_len,
+        .bus = target->bus,
+        .op = (uint8_t)op,
+        .err = (int32_t)err,
+    };
+
+    taskENTER_CRITICAL(&rec->lock);
+    rec->total_transfers++;
+    rec->total_bytes += (uint32_t)(tx_len + rx_len);
+    rec->total_bus_us += rec_new.bus_us;
+    if (rec->count < rec->capacity) {
+        rec->records[rec->count++] = rec_new;
+    } else {
+        rec->dropped++;
+    }
+    taskEXIT_CRITICAL(&rec->lock);
+}
+
+static esp_err_t rec_i2c_probe(void *ctx, i2c_master_bus_handle_t bus, const bsp_bus_target_t *target, int timeout_ms)
+{
+    bsp_bus_recorder_t *rec = ctx;
+    const uint32_t t_us = rec_now_us(rec);
+    esp_err_t err = rec->inner->i2c_probe(rec->inner->ctx, bus, target, timeout_ms);
+    rec_add(rec, t_us, target, BSP_BUS_OP_PROBE, 0, 0, err);
+    return err;
+}
+
+static esp_err_t rec_i2c_transfer(void *ctx,
+                                  i2c_master_dev_handle_t dev,
+                                  const bsp_bus_target_t *target,
+                                  const uint8_t *tx_buf,
+                                  size_t tx_len,
+                                  uint8_t *rx_buf,
+                                  size_t rx_len,
+                                  int timeout_ms)
+{
+    bsp_bus_recorder_t *rec = ctx;
+    const uint32_t t_us = rec_now_us(rec);
+    esp_err_t err = rec->inner->i2c_transfer(rec->inner->ctx, dev, target, tx_buf, tx_len, rx_buf, rx_len, timeout_ms);
+
+    bsp_bus_op_t op = BSP_BUS_OP_WRITE_READ;
+    if (rx_len == 0U) {
+        op = BSP_BUS_OP_WRITE;
+    } else if (tx_len == 0U) {
+        op = BSP_BUS_OP_READ;
+    }
+    rec_add(rec, t_us, target, op, tx_len, rx_len, err);
+    return err;
+}
+
+static esp_err_t rec_adc_read(void *ctx, adc_oneshot_unit_handle_t unit, adc_channel_t channel, int *out_raw)
+{
+    bsp_bus_recorder_t *rec = ctx;
+    const bsp_bus_target_t target = { .bus = BSP_BUS_ADC, .addr = (uint16_t)channel };
+    const uint32_t t_us = rec_now_us(rec);
+    esp_err_t err = rec->inner->adc_read(rec->inner->ctx, unit, channel, out_raw);
+    rec_add(rec, t_us, &target, BSP_BUS_OP_ADC, 0, sizeof(uint16_t), err);
+    return err;
+}
+
+static esp_err_t rec_adc_dma_read(void *ctx,
+                                  adc_continuous_handle_t handle,
+                                  uint8_t *buf,
+                                  uint32_t len,
+                                  uint32_t *out_len,
+                                  uint32_t timeout_ms)
+{
+    bsp_bus_recorder_t *rec = ctx;
+    const bsp_bus_target_t target = { .bus = BSP_BUS_ADC, .addr = 0xFFFFU };
+    const uint32_t t_us = rec_now_us(rec);
+    esp_err_t err = rec->inner->adc_dma_read(rec->inner->ctx, handle, buf, len, out_len, timeout_ms);
+    rec_add(rec, t_us, &target, BSP_BUS_OP_ADC_DMA, 0, (err == ESP_OK) ? *out_len : 0U, err);
+    return err;
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+const bsp_bus_backend_t *bsp_bus_hw_backend(void)
+{
+    return &s_hw_backend;
+}
+
+const bsp_bus_backend_t *bsp_bus_get_backend(void)
+{
+    return s_backend;
+}
+
+void bsp_bus_set_backend(const bsp_bus_backend_t *backend)
+{
+    s_backend = (backend != NULL) ? backend : &s_hw_backend;
+}
+
+esp_err_t bsp_adc_read(adc_oneshot_unit_handle_t unit, adc_channel_t channel, int *out_raw)
+{
+    return s_backend->adc_read(s_backend->ctx, unit, channel, out_raw);
+}
+
+esp_err_t bsp_adc_dma_read(adc_continuous_handle_t handle,
+                           uint8_t *buf,
+                           uint32_t len,
+                           uint32_t *out_len,
+                           uint32_t timeout_ms)
+{
+    return s_backend->adc_dma_read(s_backend->ctx, handle, buf, len, out_len, timeout_ms);
+}
+
+void bsp_bus_recorder_init(bsp_bus_recorder_t *rec,
+                           const bsp_bus_backend_t *inner,
+                           bsp_bus_record_t *records,
+                           size_t capacity,
+                           bsp_bus_clock_fn_t now_us)
+{
+    if (rec == NULL) {
+        return;
+    }
+
+    memset(rec, 0, sizeof(*rec));
+    portMUX_INITIALIZE(&rec->lock);
+    rec->backend = (bsp_bus_backend_t){
+        .i2c_probe = rec_i2c_probe,
+        .i2c_transfer = rec_i2c_transfer,
+        .adc_read = rec_adc_read,
+        .adc_dma_read = rec_adc_dma_read,
+        .ctx = rec,
+    };
+    rec->inner = (inner != NULL) ? inner : &s_hw_backend;
+    rec->now_us = now_us;
+    rec->records = records;
+    rec->capacity = (records != NULL) ? capacity : 0U;
+}
+
+void bsp_bus_recorder_reset(bsp_bus_recorder_t *rec)
+{
+    if (rec == NULL) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&rec->lock);
+    rec->count = 0;
+    rec->dropped = 0;
+    rec->total_transfers = 0;
+    rec->total_bytes = 0;
+    rec->total_bus_us = 0;
+    taskEXIT_CRITICAL(&rec->lock);
+}
+
+void bsp_bus_recorder_dump(bsp_bus_recorder_t *rec)
+{
+    if (rec == NULL) {
+        return;
+    }
+
+    // Records are append-only, so the first `count` stay valid after the snapshot.
+    taskENTER_CRITICAL(&rec->lock);
+    const size_t count = rec->count;
+    const uint32_t transfers = rec->total_transfers;
+    const uint32_t bytes = rec->total_bytes;
+    const uint32_t bus_us = rec->total_bus_us;
+    const uint32_t dropped = rec->dropped;
+    taskEXIT_CRITICAL(&rec->lock);
+
+    // WARN, not INFO: the production and fast boot profiles build with a
+    // WARN default (production also caps the compiled level there), and the
+    // dump must survive both.
+    ESP_LOGW(TAG, "S,%u,%u,%u,%u", (unsigned)transfers, (unsigned)bytes, (unsigned)bus_us, (unsigned)dropped);
+    for (size_t i = 0; i < count; ++i) {
+        const bsp_bus_record_t *r = &rec->records[i];
+        ESP_LOGW(TAG, "T,%u,%u,0x%02X,%u,%u,%u,%u,%d", (unsigned)r->t_us, (unsigned)r->bus, (unsigned)r->addr,
+                 (unsigned)r->op, (unsigned)r->tx_len, (unsigned)r->rx_len, (unsigned)r->bus_us, (int)r->err);
+    }
+}
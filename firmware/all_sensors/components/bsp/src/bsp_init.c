@@ -1,54 +1,311 @@
 #include "board_pins.h"
 #include "bsp_init.h"
+#include "bsp_bus.h"
 #include "esp_log.h"
 #include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define BSP_I2C_MAX_DEVICES      4
+#define BSP_I2C_LOCK_TIMEOUT     pdMS_TO_TICKS(1000)
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef struct {
+    i2c_master_dev_handle_t handle;
+    uint16_t addr;
+    uint32_t scl_speed_hz;
+} bsp_i2c_dev_slot_t;
+
+typedef struct {
+    i2c_port_t port;
+    gpio_num_t sda;
+    gpio_num_t scl;
+    i2c_master_bus_handle_t handle;
+    uint32_t refs;
+    bsp_i2c_dev_slot_t devs[BSP_I2C_MAX_DEVICES];
+    bsp_i2c_stats_t stats;
+} bsp_i2c_bus_slot_t;
+
+/* =========================================================================
+   SECTION: Static Data
+   ========================================================================= */
 static const char *TAG = "BSP_INIT";
 
-static esp_err_t create_master_bus(gpio_num_t sda,
-                                   gpio_num_t scl,
-                                   i2c_port_t port,
-                                   i2c_master_bus_handle_t *out_bus)
+static bsp_i2c_bus_slot_t s_buses[BSP_I2C_BUS_COUNT] = {
+    [BSP_I2C_BUS_DISPLAY] = { .port = BSP_I2C_NUM_DISPLAY, .sda = BSP_I2C0_SDA_PIN, .scl = BSP_I2C0_SCL_PIN },
+    [BSP_I2C_BUS_SENSORS] = { .port = BSP_I2C_NUM_SENSORS, .sda = BSP_I2C1_SDA_PIN, .scl = BSP_I2C1_SCL_PIN },
+};
+
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static bool bsp_i2c_lock(void)
 {
-    if (out_bus == NULL) {
-        return ESP_ERR_INVALID_ARG;
+    if (s_lock == NULL) {
+        ESP_LOGE(TAG, "bsp_init not called");
+        return false;
+    }
+    return xSemaphoreTake(s_lock, BSP_I2C_LOCK_TIMEOUT) == pdTRUE;
+}
+
+static void bsp_i2c_unlock(void)
+{
+    (void)xSemaphoreGive(s_lock);
+}
+
+static bsp_i2c_bus_slot_t *bsp_i2c_find_bus(i2c_master_bus_handle_t bus)
+{
+    for (size_t i = 0; i < BSP_I2C_BUS_COUNT; ++i) {
+        if ((bus != NULL) && (s_buses[i].handle == bus)) {
+            return &s_buses[i];
+        }
     }
+    return NULL;
+}
 
-    ESP_LOGI(TAG, "Creating I2C master bus: port=%d sda=%d scl=%d pullups=%d", (int)port, (int)sda, (int)scl, (int)BSP_I2C_PULLUP_ENABLE);
+// Transfers are serialised per bus by the driver, and each bus has one user
+// task at a time, so plain increments are enough.
+static esp_err_t bsp_i2c_count(bsp_i2c_bus_slot_t *slot, size_t bytes, esp_err_t err)
+{
+    if (slot != NULL) {
+        slot->stats.transactions++;
+        slot->stats.bytes += (uint32_t)bytes;
+        if (err != ESP_OK) {
+            slot->stats.errors++;
+        }
+    }
+    return err;
+}
+
+// Fills in the backend target; the bus slot is NULL for a handle the
+// manager does not own.
+static bsp_i2c_bus_slot_t *bsp_i2c_find_dev(i2c_master_dev_handle_t dev, bsp_bus_target_t *out_target)
+{
+    for (size_t i = 0; i < BSP_I2C_BUS_COUNT; ++i) {
+        for (size_t d = 0; d < BSP_I2C_MAX_DEVICES; ++d) {
+            const bsp_i2c_dev_slot_t *slot = &s_buses[i].devs[d];
+            if ((dev != NULL) && (slot->handle == dev)) {
+                out_target->bus = (uint8_t)i;
+                out_target->addr = slot->addr;
+                out_target->scl_speed_hz = slot->scl_speed_hz;
+                return &s_buses[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t bsp_i2c_transfer(i2c_master_dev_handle_t dev,
+                                  const uint8_t *tx_buf,
+                                  size_t tx_len,
+                                  uint8_t *rx_buf,
+                                  size_t rx_len,
+                                  int timeout_ms)
+{
+    bsp_bus_target_t target = { .bus = BSP_I2C_BUS_COUNT };
+    bsp_i2c_bus_slot_t *slot = bsp_i2c_find_dev(dev, &target);
+    const bsp_bus_backend_t *backend = bsp_bus_get_backend();
+    esp_err_t err = backend->i2c_transfer(backend->ctx, dev, &target, tx_buf, tx_len, rx_buf, rx_len, timeout_ms);
+    return bsp_i2c_count(slot, tx_len + rx_len, err);
+}
+
+static esp_err_t create_master_bus(bsp_i2c_bus_slot_t *slot)
+{
+    ESP_LOGI(TAG, "Creating I2C master bus: port=%d sda=%d scl=%d pullups=%d",
+             (int)slot->port, (int)slot->sda, (int)slot->scl, (int)BSP_I2C_PULLUP_ENABLE);
 
     i2c_master_bus_config_t cfg = {
-        .i2c_port = port,
-        .sda_io_num = sda,
-        .scl_io_num = scl,
+        .i2c_port = slot->port,
+        .sda_io_num = slot->sda,
+        .scl_io_num = slot->scl,
         .clk_source = I2C_CLK_SRC_DEFAULT,
         .flags.enable_internal_pullup = BSP_I2C_PULLUP_ENABLE,
         .glitch_ignore_cnt = 7
     };
 
-    return i2c_new_master_bus(&cfg, out_bus);
+    esp_err_t err = i2c_new_master_bus(&cfg, &slot->handle);
+    if (err == ESP_OK) {
+        slot->stats.creates++;
+    }
+    return err;
 }
 
-esp_err_t bsp_i2c_create_display_bus(i2c_master_bus_handle_t *out_bus)
+static void delete_master_bus(bsp_i2c_bus_slot_t *slot)
 {
-    ESP_LOGI(TAG, "Createing display bus");
-    return create_master_bus(BSP_I2C0_SDA_PIN,
-                             BSP_I2C0_SCL_PIN,
-                             BSP_I2C_NUM_DISPLAY,
-                             out_bus);
+    for (size_t d = 0; d < BSP_I2C_MAX_DEVICES; ++d) {
+        if (slot->devs[d].handle != NULL) {
+            (void)i2c_master_bus_rm_device(slot->devs[d].handle);
+            slot->devs[d].handle = NULL;
+        }
+    }
+    (void)i2c_del_master_bus(slot->handle);
+    slot->handle = NULL;
 }
 
-esp_err_t bsp_i2c_create_sensors_bus(i2c_master_bus_handle_t *out_bus)
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+esp_err_t bsp_init(void)
 {
-    return create_master_bus(BSP_I2C1_SDA_PIN,
-                             BSP_I2C1_SCL_PIN,
-                             BSP_I2C_NUM_SENSORS,
-                             out_bus);
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_i2c_bus_acquire(bsp_i2c_bus_id_t id, i2c_master_bus_handle_t *out_bus)
+{
+    if ((id >= BSP_I2C_BUS_COUNT) || (out_bus == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!bsp_i2c_lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    bsp_i2c_bus_slot_t *slot = &s_buses[id];
+    esp_err_t err = ESP_OK;
+    if (slot->handle == NULL) {
+        err = create_master_bus(slot);
+    }
+    if (err == ESP_OK) {
+        slot->refs++;
+        *out_bus = slot->handle;
+    }
+
+    bsp_i2c_unlock();
+    return err;
 }
 
-esp_err_t bsp_i2c_del_bus(i2c_master_bus_handle_t bus)
+esp_err_t bsp_i2c_bus_release(bsp_i2c_bus_id_t id)
+{
+    if (id >= BSP_I2C_BUS_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!bsp_i2c_lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    bsp_i2c_bus_slot_t *slot = &s_buses[id];
+    esp_err_t err = ESP_OK;
+    if (slot->refs == 0U) {
+        err = ESP_ERR_INVALID_STATE;
+    } else if (--slot->refs == 0U) {
+        ESP_LOGI(TAG, "Deleting I2C master bus: port=%d", (int)slot->port);
+        delete_master_bus(slot);
+    }
+
+    bsp_i2c_unlock();
+    return err;
+}
+
+esp_err_t bsp_i2c_device_get(i2c_master_bus_handle_t bus,
+                             uint16_t addr,
+                             uint32_t scl_speed_hz,
+                             i2c_master_dev_handle_t *out_dev)
+{
+    if ((bus == NULL) || (out_dev == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!bsp_i2c_lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t err = ESP_ERR_NO_MEM;
+    bsp_i2c_bus_slot_t *slot = bsp_i2c_find_bus(bus);
+    bsp_i2c_dev_slot_t *free_dev = NULL;
+    if (slot == NULL) {
+        err = ESP_ERR_INVALID_STATE;
+        goto out;
+    }
+
+    for (size_t d = 0; d < BSP_I2C_MAX_DEVICES; ++d) {
+        bsp_i2c_dev_slot_t *dev = &slot->devs[d];
+        if (dev->handle == NULL) {
+            if (free_dev == NULL) {
+                free_dev = dev;
+            }
+            continue;
+        }
+        if (dev->addr == addr) {
+            if (dev->scl_speed_hz != scl_speed_hz) {
+                ESP_LOGW(TAG, "0x%02X already attached at %u Hz", (unsigned)addr, (unsigned)dev->scl_speed_hz);
+            }
+            *out_dev = dev->handle;
+            err = ESP_OK;
+            goto out;
+        }
+    }
+
+    if (free_dev != NULL) {
+        i2c_device_config_t dev_cfg = {
+            .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+            .device_address = addr,
+            .scl_speed_hz = scl_speed_hz,
+        };
+        err = i2c_master_bus_add_device(bus, &dev_cfg, &free_dev->handle);
+        if (err == ESP_OK) {
+            free_dev->addr = addr;
+            free_dev->scl_speed_hz = scl_speed_hz;
+            *out_dev = free_dev->handle;
+            ESP_LOGI(TAG, "device 0x%02X attached at %u Hz", (unsigned)addr, (unsigned)scl_speed_hz);
+        } else {
+            free_dev->handle = NULL;
+        }
+    }
+
+out:
+    bsp_i2c_unlock();
+    return err;
+}
+
+esp_err_t bsp_i2c_probe(i2c_master_bus_handle_t bus, uint16_t addr, int timeout_ms)
 {
     if (bus == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    return i2c_del_master_bus(bus);
+
+    bsp_i2c_bus_slot_t *slot = bsp_i2c_find_bus(bus);
+    const bsp_bus_target_t target = {
+        .bus = (slot != NULL) ? (uint8_t)(slot - s_buses) : (uint8_t)BSP_I2C_BUS_COUNT,
+        .addr = addr,
+    };
+    const bsp_bus_backend_t *backend = bsp_bus_get_backend();
+    return bsp_i2c_count(slot, 0, backend->i2c_probe(backend->ctx, bus, &target, timeout_ms));
+}
+
+esp_err_t bsp_i2c_transmit(i2c_master_dev_handle_t dev, const uint8_t *buf, size_t len, int timeout_ms)
+{
+    return bsp_i2c_transfer(dev, buf, len, NULL, 0, timeout_ms);
+}
+
+esp_err_t bsp_i2c_receive(i2c_master_dev_handle_t dev, uint8_t *buf, size_t len, int timeout_ms)
+{
+    return bsp_i2c_transfer(dev, NULL, 0, buf, len, timeout_ms);
+}
+
+esp_err_t bsp_i2c_transmit_receive(i2c_master_dev_handle_t dev,
+                                   const uint8_t *tx_buf,
+                                   size_t tx_len,
+                                   uint8_t *rx_buf,
+                                   size_t rx_len,
+                                   int timeout_ms)
+{
+    return bsp_i2c_transfer(dev, tx_buf, tx_len, rx_buf, rx_len, timeout_ms);
+}
+
+esp_err_t bsp_i2c_get_stats(bsp_i2c_bus_id_t id, bsp_i2c_stats_t *out_stats)
+{
+    if ((id >= BSP_I2C_BUS_COUNT) || (out_stats == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_stats = s_buses[id].stats;
+    return ESP_OK;
 }
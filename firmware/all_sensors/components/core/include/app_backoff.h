@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+// Wake-counted exponential backoff. Meant to live in RTC memory so a link
+// that keeps failing is probed at growing intervals instead of every wake.
+typedef struct {
+    uint16_t failures;      // consecutive failed attempts
+    uint16_t skip_left;     // wakes still to skip before the next probe
+} app_backoff_t;
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Consumes one skipped wake. Returns true when this wake should not try.
+static inline bool app_backoff_should_skip(app_backoff_t *io_backoff)
+{
+    if (io_backoff->skip_left == 0U) {
+        return false;
+    }
+    io_backoff->skip_left--;
+    return true;
+}
+
+static inline void app_backoff_on_success(app_backoff_t *io_backoff)
+{
+    io_backoff->failures = 0U;
+    io_backoff->skip_left = 0U;
+}
+
+// The first `threshold` failures are retried on the next wake, after that the
+// number of skipped wakes doubles up to `max_skip`.
+static inline void app_backoff_on_failure(app_backoff_t *io_backoff, uint16_t threshold, uint16_t max_skip)
+{
+    if (io_backoff->failures < UINT16_MAX) {
+        io_backoff->failures++;
+    }
+    if (io_backoff->failures < threshold) {
+        io_backoff->skip_left = 0U;
+        return;
+    }
+
+    const uint16_t exp = (uint16_t)(io_backoff->failures - threshold);
+    const uint32_t skip = (exp >= 15U) ? max_skip : (1UL << exp);
+    io_backoff->skip_left = (skip > max_skip) ? max_skip : (uint16_t)skip;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef enum {
+    APP_BOOT_MARK_APP_MAIN = 0,    // app_main entered (app startup done)
+    APP_BOOT_MARK_NVS_READY,       // NVS mounted
+    APP_BOOT_MARK_FSM_READY,       // FSM loop running, INIT about to be entered
+    APP_BOOT_MARK_FIRST_SENSOR,    // first sensor read starts
+    APP_BOOT_MARK_COUNT
+} app_boot_mark_t;
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Records the esp_timer time of a boot milestone; only the first call per
+// mark counts. Reaching APP_BOOT_MARK_FIRST_SENSOR logs the breakdown.
+void app_boot_profile_mark(app_boot_mark_t mark);
+
+// ms since app startup (esp_timer start) at which the mark was reached,
+// 0 if not reached yet. Does not include ROM and bootloader.
+uint32_t app_boot_profile_get_ms(app_boot_mark_t mark);
+
+// Approximate ROM + bootloader time before app startup. Derived from the
+// cycle counter at the app CPU clock, so it is a lower bound: ROM and
+// bootloader run at a lower clock. Time them on a scope for exact numbers.
+uint32_t app_boot_profile_get_pre_app_ms(void);
@@ -0,0 +1,16 @@
+#pragma once
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// With CONFIG_APP_BUS_TRACE, installs a recording bus backend so every I2C and
+// ADC transfer of the wake is kept; otherwise does nothing.
+void app_bus_trace_start(void);
+
+// Logs per-bus counters and, when tracing, the recorded transfers. Called
+// once per wake, just before deep sleep.
+void app_bus_trace_report(void);
@@ -19,10 +19,12 @@ typedef struct {
     config_t config;             // provisioned configuration
     bool wifi_connected;         // WiFi link state
     bool time_synced;            // SNTP sync status
+    int32_t upload_slot_s;       // server-assigned second within sleep interval, -1 = none
     uint32_t data_block_seq;     // rolling sensor block number
     sensor_data_t sensor_data;   // latest sensor readout
-    i2c_master_bus_handle_t bus_display;  // disposable bus handle for display
-    i2c_master_bus_handle_t bus_sensors;  // disposable bus handle for sensors
+    sensor_stats_t sensor_stats; // burst spread of the latest readout, zeroed without burst
+    i2c_master_bus_handle_t bus_display;  // display bus, one reference held while the panel is up
+    i2c_master_bus_handle_t bus_sensors;  // sensors bus, one reference held for the wake
     ssd1306_handle_t display;             // shared display handle
     soil_sensor_handle_t soil_sensor;     // shared soil sensor handle
 } app_context_t;
@@ -41,11 +43,16 @@ bool app_context_is_wifi_connected(void);
 void app_context_set_time_synced(bool synced);
 bool app_context_is_time_synced(void);
 
+void app_context_set_upload_slot(int32_t slot_s);
+int32_t app_context_get_upload_slot(void);
+
 uint32_t app_context_next_data_block_seq(void);
 uint32_t app_context_peek_data_block_seq(void);
 
 esp_err_t app_context_set_sensor_data(const sensor_data_t *data);
 esp_err_t app_context_get_sensor_data(sensor_data_t *out);
+esp_err_t app_context_set_sensor_stats(const sensor_stats_t *stats);
+esp_err_t app_context_get_sensor_stats(sensor_stats_t *out);
 
 esp_err_t app_context_set_display_bus(i2c_master_bus_handle_t bus);
 esp_err_t app_context_set_sensors_bus(i2c_master_bus_handle_t bus);
@@ -54,7 +61,9 @@ i2c_master_bus_handle_t app_context_get_sensors_bus(void);
 
 esp_err_t app_context_set_display_handle(ssd1306_handle_t handle);
 ssd1306_handle_t app_context_get_display_handle(void);
+// Both wait for the display task (app_display.h) to go idle first.
 ssd1306_handle_t app_context_ensure_display(void);
+void app_context_release_display(void);  // panel off, handle destroyed, bus reference dropped
 
 esp_err_t app_context_set_soil_sensor(soil_sensor_handle_t handle);
 soil_sensor_handle_t app_context_get_soil_sensor(void);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+#define APP_DISPLAY_LINES     4
+#define APP_DISPLAY_LINE_LEN  24
+
+// A text screen; line i goes to page 2 * i, empty lines are left blank.
+typedef struct {
+    char line[APP_DISPLAY_LINES][APP_DISPLAY_LINE_LEN];
+} app_display_frame_t;
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Creates the lock and idle flag. Called once from app_context_init, before
+// any task can post; the display task itself starts on the first frame.
+esp_err_t app_display_init(void);
+
+// Renders on the display task and returns at once. A frame still waiting
+// when the next one arrives is replaced, so only the newest is drawn.
+esp_err_t app_display_show(const app_display_frame_t *frame);
+
+// Queues panel off + release behind whatever is drawing or still waiting,
+// so a frame posted just before it is still put on the panel.
+esp_err_t app_display_release(void);
+
+// Waits until the display task has nothing left to do. Callers that draw on
+// the panel directly go through this first (app_context_ensure_display does).
+esp_err_t app_display_sync(uint32_t timeout_ms);
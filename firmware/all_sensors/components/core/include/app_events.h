@@ -44,6 +44,11 @@ typedef enum {
 
    // Idle
    APP_EVENT_IDLE_TIMEOUT,
+   APP_EVENT_IDLE_STAY_CONNECTED,   // short interval: light sleep instead of deep sleep
+   APP_EVENT_SAMPLE_TIMER,          // connected sleep interval elapsed
+
+   // Supervision
+   APP_EVENT_WAKE_BUDGET_EXPIRED,   // wake took longer than CONFIG_APP_WAKE_BUDGET_MS
 
     // Interrupts
     APP_EVENT_BTN1_SHORT,       // primary button  
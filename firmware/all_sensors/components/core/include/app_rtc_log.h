@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "app_rtc_log_ids.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+#define APP_RTC_LOG_ID(name, fmt) APP_RLOG_##name,
+typedef enum {
+    APP_RTC_LOG_TABLE(APP_RTC_LOG_ID)
+    APP_RLOG_COUNT
+} app_rtc_log_id_t;
+#undef APP_RTC_LOG_ID
+
+#define APP_RTC_LOG_MAX_ARGS 3
+
+// Wire format of a dump as well: little endian, 20 bytes, no padding.
+typedef struct {
+    uint16_t id;          // app_rtc_log_id_t
+    uint16_t boot;        // boot counter, tells wakes apart
+    uint32_t ms;          // ms since reset
+    uint32_t args[APP_RTC_LOG_MAX_ARGS];
+} app_rtc_log_rec_t;
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Appends a record to the ring in RTC memory, overwriting the oldest one.
+// No formatting happens on the device; unused arguments are ignored.
+void app_rtc_log_write(app_rtc_log_id_t id, uint32_t a0, uint32_t a1, uint32_t a2);
+
+// Copies the newest max_items records (or all), oldest first. Returns the
+// number copied.
+size_t app_rtc_log_snapshot(app_rtc_log_rec_t *out_recs, size_t max_items);
+
+void app_rtc_log_clear(void);
+
+static inline uint32_t app_rtc_log_float_bits(float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+#define APP_RLOG_F(value) app_rtc_log_float_bits((float)(value))
+#define APP_RLOG(name, a0, a1, a2) \
+    app_rtc_log_write(APP_RLOG_##name, (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2))
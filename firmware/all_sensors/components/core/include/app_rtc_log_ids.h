@@ -0,0 +1,31 @@
+#pragma once
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Binary Log Message Table
+   ========================================================================= */
+// X(name, format). Up to three 32-bit arguments per entry:
+//   %u %d %x  integers
+//   %f        float, pass it through APP_RLOG_F()
+//   %S        app_state_t, printed by name
+// Ids are positional, so only append. The host decoder
+// (scripts/rtc_log/decode_rtc_log.py) parses this table directly.
+#define APP_RTC_LOG_TABLE(X)                                                \
+    X(BOOT,           "boot wake_cause=%u")                                 \
+    X(FSM_TRANSITION, "fsm %S -> %S")                                       \
+    X(MQTT_PUBLISH,   "mqtt publish topic=%u len=%u msg_id=%d")             \
+    X(MQTT_ACK,       "mqtt ack msg_id=%d")                                 \
+    X(MQTT_DISCONNECT,"mqtt disconnected fails=%u")                         \
+    X(MQTT_DRAIN,     "mqtt drain sent=%u left=%u")                         \
+    X(WIFI_LINK,      "wifi rssi=%d retries=%u tx_qdbm=%u")                 \
+    X(WIFI_FAIL,      "wifi connect failed retries=%u")                     \
+    X(BME280,         "bme280 t=%f C p=%f Pa")                              \
+    X(VEML7700,       "veml7700 cfg=0x%x lux=%f")                           \
+    X(SOIL,           "soil raw=%u moisture=%u")                            \
+    X(WAKE_OVERRUN,   "wake budget expired in %S after %u ms hard=%u")       \
+    X(SENSOR_FAULT,   "sensor mask=0x%x failed fails=%u cycles_since_ok=%u") \
+    X(BATTERY,        "battery mv=%u tier %u -> %u")                        \
+    X(BME280_FIXED,   "bme280 t=%d cC p=%u cPa")
@@ -19,6 +19,7 @@ typedef enum {
 
     STATE_FACTORY_RESET,
     STATE_IDLE,
+    STATE_CONNECTED_SLEEP,
     STATE_DEEP_SLEEP
 } app_state_t;
 
@@ -39,6 +40,7 @@ static inline const char* app_state_str(app_state_t s) {
         case STATE_FLASH_STORE: return "FLASH_STORE";
         case STATE_FACTORY_RESET: return "RESET";
         case STATE_IDLE: return "IDLE";
+        case STATE_CONNECTED_SLEEP: return "CONN_SLEEP";
         case STATE_DEEP_SLEEP: return "SLEEP";
         default: return "UNKNOWN";
     }
@@ -18,10 +18,44 @@ typedef struct {
     uint32_t timestamp;     // unix timestamp
     uint16_t lux_level;     // 0/1/2
     uint8_t soil_moisture;  // ADC value or %
+    uint8_t flags;          // SENSOR_FLAG_*, fills former padding
     uint16_t temperature;   // deci-Kelvin
-    float pressure;         // hPa
+    uint16_t battery_mv;    // battery voltage, 0 = not measured; fills former padding
+    uint32_t pressure_cpa;  // 0.01 Pa, as the BME280 integer path returns it; was hPa float
 } sensor_data_t;
 
+// Also the flash record layout; nvs_manager converts samples stored by older builds.
+_Static_assert(sizeof(sensor_data_t) == 16, "sensor_data_t layout changed");
+
+#define SENSOR_PRESSURE_CPA_PER_HPA  10000U
+
+// Field carried over from an earlier wake instead of measured in this one.
+#define SENSOR_FLAG_LUX_STALE   0x01U
+#define SENSOR_FLAG_ENV_STALE   0x02U   // temperature and pressure
+#define SENSOR_FLAG_SOIL_STALE  0x04U
+// Sensor failing: its last attempt failed and it is being re-probed with backoff.
+#define SENSOR_FLAG_LUX_FAULT   0x10U
+#define SENSOR_FLAG_ENV_FAULT   0x20U
+#define SENSOR_FLAG_SOIL_FAULT  0x40U
+
+// Spread of one field over a burst (CONFIG_APP_SENSOR_BURST_COUNT readings per
+// wake); the mean is what sensor_data_t carries. min/max are in the field's
+// unit (lux, dK, 0.1 hPa, %), sd10 is the standard deviation x10 in that unit.
+typedef struct {
+    uint16_t min;
+    uint16_t max;
+    uint16_t sd10;
+    uint8_t n;              // readings taken, 0 = field not measured this wake
+    uint8_t reserved;
+} sensor_stat_t;
+
+typedef struct {
+    sensor_stat_t lux;
+    sensor_stat_t temperature;
+    sensor_stat_t pressure;
+    sensor_stat_t soil;
+} sensor_stats_t;
+
 // Configuration structure
 typedef struct {
     char ssid[32];
@@ -0,0 +1,79 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "app_boot_profile.h"
+
+static const char *TAG = "BOOT";
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static int64_t s_marks_us[APP_BOOT_MARK_COUNT];
+static uint32_t s_pre_app_ms;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static uint32_t boot_profile_ms(app_boot_mark_t mark)
+{
+    return (uint32_t)((s_marks_us[mark] + 999) / 1000);
+}
+
+static void boot_profile_report(void)
+{
+#if CONFIG_APP_FAST_BOOT
+    const int fast = 1;
+#else
+    const int fast = 0;
+#endif
+    // Deltas show which step a profile change actually moved. The pre-app
+    // part is an estimate, see app_boot_profile_get_pre_app_ms().
+    ESP_LOGI(TAG, "rom+bootloader ~%u ms (approx.), startup %u ms, nvs +%u, fsm +%u, first sensor +%u, "
+                  "app total %u ms (fast_boot=%d)",
+             (unsigned)s_pre_app_ms,
+             (unsigned)boot_profile_ms(APP_BOOT_MARK_APP_MAIN),
+             (unsigned)(boot_profile_ms(APP_BOOT_MARK_NVS_READY) - boot_profile_ms(APP_BOOT_MARK_APP_MAIN)),
+             (unsigned)(boot_profile_ms(APP_BOOT_MARK_FSM_READY) - boot_profile_ms(APP_BOOT_MARK_NVS_READY)),
+             (unsigned)(boot_profile_ms(APP_BOOT_MARK_FIRST_SENSOR) - boot_profile_ms(APP_BOOT_MARK_FSM_READY)),
+             (unsigned)boot_profile_ms(APP_BOOT_MARK_FIRST_SENSOR), fast);
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+void app_boot_profile_mark(app_boot_mark_t mark)
+{
+    if ((mark >= APP_BOOT_MARK_COUNT) || (s_marks_us[mark] != 0)) {
+        return;
+    }
+
+    // esp_timer starts early in app startup and does not depend on the CPU
+    // clock, so the app-side marks are exact.
+    const int64_t now_us = esp_timer_get_time();
+    s_marks_us[mark] = (now_us > 0) ? now_us : 1;
+
+    if (mark == APP_BOOT_MARK_APP_MAIN) {
+        // Nothing times ROM and bootloader. The early log timestamp divides
+        // the cycle count since reset by the app CPU clock, but ROM and
+        // bootloader run slower, so this under-reports them.
+        const uint32_t early_ms = esp_log_early_timestamp();
+        const uint32_t app_ms = boot_profile_ms(APP_BOOT_MARK_APP_MAIN);
+        s_pre_app_ms = (early_ms > app_ms) ? (early_ms - app_ms) : 0U;
+    }
+
+    if (mark == APP_BOOT_MARK_FIRST_SENSOR) {
+        boot_profile_report();
+    }
+}
+
+uint32_t app_boot_profile_get_ms(app_boot_mark_t mark)
+{
+    return ((mark < APP_BOOT_MARK_COUNT) && (s_marks_us[mark] != 0)) ? boot_profile_ms(mark) : 0U;
+}
+
+uint32_t app_boot_profile_get_pre_app_ms(void)
+{
+    return s_pre_app_ms;
+}
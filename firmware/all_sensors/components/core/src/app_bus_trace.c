@@ -0,0 +1,47 @@
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "bsp_init.h"
+#include "bsp_bus.h"
+#include "app_bus_trace.h"
+
+static const char *TAG = "BUS";
+
+// The dump is logged at WARN (2); a build that compiles that out records for nothing.
+#if CONFIG_APP_BUS_TRACE && (CONFIG_LOG_MAXIMUM_LEVEL < 2)
+#warning "CONFIG_APP_BUS_TRACE needs CONFIG_LOG_MAXIMUM_LEVEL at WARN or above"
+#endif
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+#if CONFIG_APP_BUS_TRACE
+static bsp_bus_record_t s_records[CONFIG_APP_BUS_TRACE_LEN];
+static bsp_bus_recorder_t s_recorder;
+#endif
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+void app_bus_trace_start(void)
+{
+#if CONFIG_APP_BUS_TRACE
+    bsp_bus_recorder_init(&s_recorder, bsp_bus_hw_backend(), s_records, CONFIG_APP_BUS_TRACE_LEN, NULL);
+    bsp_bus_set_backend(&s_recorder.backend);
+    ESP_LOGI(TAG, "bus trace on (%u records)", (unsigned)CONFIG_APP_BUS_TRACE_LEN);
+#endif
+}
+
+void app_bus_trace_report(void)
+{
+    for (int i = 0; i < BSP_I2C_BUS_COUNT; ++i) {
+        bsp_i2c_stats_t st = {0};
+        if (bsp_i2c_get_stats((bsp_i2c_bus_id_t)i, &st) == ESP_OK) {
+            ESP_LOGD(TAG, "i2c%d: creates=%u xfers=%u bytes=%u errors=%u", i, (unsigned)st.creates,
+                     (unsigned)st.transactions, (unsigned)st.bytes, (unsigned)st.errors);
+        }
+    }
+
+#if CONFIG_APP_BUS_TRACE
+    bsp_bus_recorder_dump(&s_recorder);
+#endif
+}
@@ -1,12 +1,17 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "esp_check.h"
 #include "esp_log.h"
 #include "bsp_init.h"
 #include "app_context.h"
+#include "app_display.h"
 
 static const char *TAG = "APP_CTX";
 
+// Longest wait for the display task before touching the panel directly.
+#define APP_CTX_DISPLAY_SYNC_MS 2000U
+
 /* =========================================================================
    SECTION: Static State
    ========================================================================= */
@@ -41,7 +46,11 @@ esp_err_t app_context_init(void)
         return ESP_OK;
     }
 
+    ESP_RETURN_ON_ERROR(bsp_init(), TAG, "bsp init failed");
+    ESP_RETURN_ON_ERROR(app_display_init(), TAG, "display init failed");
+
     memset(&s_ctx, 0, sizeof(s_ctx));
+    s_ctx.upload_slot_s = -1;
     s_ctx_mutex = xSemaphoreCreateMutex();
     if (s_ctx_mutex == NULL) {
         ESP_LOGE(TAG, "Failed to create mutex");
@@ -126,6 +135,28 @@ bool app_context_is_time_synced(void)
     return synced;
 }
 
+void app_context_set_upload_slot(int32_t slot_s)
+{
+    if (!s_initialized || !lock_ctx(pdMS_TO_TICKS(20))) {
+        return;
+    }
+    s_ctx.upload_slot_s = (slot_s < 0) ? -1 : slot_s;
+    unlock_ctx();
+}
+
+int32_t app_context_get_upload_slot(void)
+{
+    int32_t slot_s = -1;
+    if (!s_initialized) {
+        return -1;
+    }
+    if (lock_ctx(pdMS_TO_TICKS(20))) {
+        slot_s = s_ctx.upload_slot_s;
+        unlock_ctx();
+    }
+    return slot_s;
+}
+
 uint32_t app_context_next_data_block_seq(void)
 {
     uint32_t val = 0;
@@ -183,6 +214,36 @@ esp_err_t app_context_get_sensor_data(sensor_data_t *out)
     return ESP_OK;
 }
 
+esp_err_t app_context_set_sensor_stats(const sensor_stats_t *stats)
+{
+    if (!s_initialized || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!lock_ctx(pdMS_TO_TICKS(50))) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    s_ctx.sensor_stats = *stats;
+    unlock_ctx();
+    return ESP_OK;
+}
+
+esp_err_t app_context_get_sensor_stats(sensor_stats_t *out)
+{
+    if (!s_initialized || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!lock_ctx(pdMS_TO_TICKS(50))) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    *out = s_ctx.sensor_stats;
+    unlock_ctx();
+    return ESP_OK;
+}
+
 esp_err_t app_context_set_display_bus(i2c_master_bus_handle_t bus)
 {
     if (!s_initialized) {
@@ -294,10 +355,16 @@ soil_sensor_handle_t app_context_get_soil_sensor(void)
 
 ssd1306_handle_t app_context_ensure_display(void)
 {
+    // The display task still owns the panel; drawing now would interleave with it.
+    if (app_display_sync(APP_CTX_DISPLAY_SYNC_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "display busy, skipping draw");
+        return NULL;
+    }
+
     i2c_master_bus_handle_t bus = app_context_get_display_bus();
     if (bus == NULL) {
-        if (bsp_i2c_create_display_bus(&bus) != ESP_OK) {
-            ESP_LOGW(TAG, "display bus create failed");
+        if (bsp_i2c_bus_acquire(BSP_I2C_BUS_DISPLAY, &bus) != ESP_OK) {
+            ESP_LOGW(TAG, "display bus acquire failed");
             return NULL;
         }
         (void)app_context_set_display_bus(bus);
@@ -313,3 +380,25 @@ ssd1306_handle_t app_context_ensure_display(void)
     }
     return disp;
 }
+
+void app_context_release_display(void)
+{
+    // Leave it to the display task to release once it is done with the panel.
+    if (app_display_sync(APP_CTX_DISPLAY_SYNC_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "display busy, release queued");
+        (void)app_display_release();
+        return;
+    }
+
+    ssd1306_handle_t disp = app_context_get_display_handle();
+    if (disp != NULL) {
+        (void)ssd1306_power_off(disp);
+        ssd1306_destroy(disp);
+        (void)app_context_set_display_handle(NULL);
+    }
+
+    if (app_context_get_display_bus() != NULL) {
+        (void)bsp_i2c_bus_release(BSP_I2C_BUS_DISPLAY);
+        (void)app_context_set_display_bus(NULL);
+    }
+}
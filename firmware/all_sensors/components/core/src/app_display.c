@@ -0,0 +1,200 @@
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "ssd1306.h"
+#include "app_context.h"
+#include "app_display.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define APP_DISPLAY_TASK_STACK   3072
+// Below the FSM event task (4): drawing runs while the FSM waits on sensors or the radio.
+#define APP_DISPLAY_TASK_PRIO    3
+#define APP_DISPLAY_LOCK_TIMEOUT pdMS_TO_TICKS(1000)
+#define APP_DISPLAY_IDLE_BIT     BIT0
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+// One slot per command kind, run in the order they were posted: a frame
+// posted before a release is drawn first, one posted after it redraws.
+typedef struct {
+    bool release;
+    bool has_frame;
+    bool release_last;     // release posted after the pending frame
+    app_display_frame_t frame;
+} app_display_mailbox_t;
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static const char *TAG = "APP_DISPLAY";
+
+static TaskHandle_t s_task;
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+static EventGroupHandle_t s_events;
+static StaticEventGroup_t s_events_buf;
+
+// Two frame buffers: callers fill the mailbox while the task draws its own copy.
+static app_display_mailbox_t s_mail;   // under s_lock
+static app_display_frame_t s_render;   // display task only
+static uint32_t s_coalesced;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void app_display_draw(const app_display_frame_t *frame)
+{
+    // A repeated frame is cheap: the driver only sends bytes that changed.
+    ssd1306_handle_t disp = app_context_ensure_display();
+    if (disp == NULL) {
+        return;
+    }
+
+    (void)ssd1306_clear(disp);
+    for (uint8_t i = 0; i < APP_DISPLAY_LINES; ++i) {
+        if (frame->line[i][0] != '\0') {
+            (void)ssd1306_draw_text(disp, frame->line[i], 0, (uint8_t)(2U * i));
+        }
+    }
+    (void)ssd1306_flush(disp);
+}
+
+static void app_display_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        for (;;) {
+            (void)xSemaphoreTake(s_lock, portMAX_DELAY);
+            const bool release = s_mail.release;
+            const bool has_frame = s_mail.has_frame;
+            const bool release_last = s_mail.release_last;
+            if (has_frame) {
+                s_render = s_mail.frame;
+            }
+            s_mail.release = false;
+            s_mail.has_frame = false;
+            s_mail.release_last = false;
+            if (!release && !has_frame) {
+                (void)xEventGroupSetBits(s_events, APP_DISPLAY_IDLE_BIT);
+            }
+            (void)xSemaphoreGive(s_lock);
+
+            if (!release && !has_frame) {
+                break;
+            }
+
+            if (release && !release_last) {
+                app_context_release_display();
+            }
+            if (has_frame) {
+                app_display_draw(&s_render);
+            }
+            if (release && release_last) {
+                app_context_release_display();
+            }
+        }
+    }
+}
+
+static bool app_display_lock(void)
+{
+    if (s_lock == NULL) {
+        ESP_LOGE(TAG, "app_display_init not called");
+        return false;
+    }
+    return xSemaphoreTake(s_lock, APP_DISPLAY_LOCK_TIMEOUT) == pdTRUE;
+}
+
+// Called with s_lock held; the task is created on first use.
+static esp_err_t app_display_kick_locked(void)
+{
+    if (s_task == NULL) {
+        if (xTaskCreate(app_display_task, "display", APP_DISPLAY_TASK_STACK, NULL,
+                        APP_DISPLAY_TASK_PRIO, &s_task) != pdPASS) {
+            s_task = NULL;
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    (void)xEventGroupClearBits(s_events, APP_DISPLAY_IDLE_BIT);
+    (void)xTaskNotifyGive(s_task);
+    return ESP_OK;
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+esp_err_t app_display_init(void)
+{
+    if (s_lock != NULL) {
+        return ESP_OK;
+    }
+
+    // Static storage: neither call can fail once the buffers are given.
+    s_events = xEventGroupCreateStatic(&s_events_buf);
+    (void)xEventGroupSetBits(s_events, APP_DISPLAY_IDLE_BIT);
+    s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    return ESP_OK;
+}
+
+esp_err_t app_display_show(const app_display_frame_t *frame)
+{
+    if (frame == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!app_display_lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (s_mail.has_frame) {
+        s_coalesced++;
+        ESP_LOGD(TAG, "frame replaced before drawing (%u)", (unsigned)s_coalesced);
+    }
+    s_mail.frame = *frame;
+    s_mail.has_frame = true;
+    s_mail.release_last = false;
+    esp_err_t err = app_display_kick_locked();
+
+    (void)xSemaphoreGive(s_lock);
+    return err;
+}
+
+esp_err_t app_display_release(void)
+{
+    if (!app_display_lock()) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // A waiting frame is still drawn first; the FSM usually leaves the state
+    // that posted it before this task gets the CPU.
+    s_mail.release = true;
+    s_mail.release_last = true;
+    esp_err_t err = app_display_kick_locked();
+
+    (void)xSemaphoreGive(s_lock);
+    return err;
+}
+
+esp_err_t app_display_sync(uint32_t timeout_ms)
+{
+    // Nothing was ever posted, or the display task itself is drawing.
+    if ((s_task == NULL) || (xTaskGetCurrentTaskHandle() == s_task)) {
+        return ESP_OK;
+    }
+
+    const EventBits_t bits = xEventGroupWaitBits(s_events, APP_DISPLAY_IDLE_BIT, pdFALSE, pdTRUE,
+                                                 pdMS_TO_TICKS(timeout_ms));
+    if ((bits & APP_DISPLAY_IDLE_BIT) == 0U) {
+        ESP_LOGW(TAG, "display task still busy after %u ms", (unsigned)timeout_ms);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
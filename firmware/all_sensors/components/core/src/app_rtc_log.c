@@ -0,0 +1,114 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "app_rtc_log.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+// 20 bytes each; 96 records take ~2 KB of the 8 KB RTC slow memory.
+#ifndef APP_RTC_LOG_CAPACITY
+#define APP_RTC_LOG_CAPACITY 96U
+#endif
+#define APP_RTC_LOG_MAGIC    0x524C4731UL   // "RLG1"
+
+_Static_assert(sizeof(app_rtc_log_rec_t) == 20, "dump format changed, update the decoder");
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef struct {
+    uint32_t magic;
+    uint16_t head;        // next slot to write
+    uint16_t count;
+    uint16_t boot;
+    app_rtc_log_rec_t recs[APP_RTC_LOG_CAPACITY];
+} app_rtc_log_ring_t;
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+RTC_DATA_ATTR static app_rtc_log_ring_t s_rtc_ring;
+static portMUX_TYPE s_ring_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_boot_logged;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void ring_push_locked(app_rtc_log_id_t id, uint32_t ms, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+    app_rtc_log_rec_t *rec = &s_rtc_ring.recs[s_rtc_ring.head];
+    rec->id = (uint16_t)id;
+    rec->boot = s_rtc_ring.boot;
+    rec->ms = ms;
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+
+    s_rtc_ring.head = (uint16_t)((s_rtc_ring.head + 1U) % APP_RTC_LOG_CAPACITY);
+    if (s_rtc_ring.count < APP_RTC_LOG_CAPACITY) {
+        s_rtc_ring.count++;
+    }
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+void app_rtc_log_write(app_rtc_log_id_t id, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+    if (id >= APP_RLOG_COUNT) {
+        return;
+    }
+
+    const uint32_t ms = esp_log_timestamp();
+    // Read outside the lock, it may call into the sleep driver.
+    const uint32_t cause = s_boot_logged ? 0U : (uint32_t)esp_sleep_get_wakeup_cause();
+
+    taskENTER_CRITICAL(&s_ring_lock);
+    if (s_rtc_ring.magic != APP_RTC_LOG_MAGIC) {
+        memset(&s_rtc_ring, 0, sizeof(s_rtc_ring));
+        s_rtc_ring.magic = APP_RTC_LOG_MAGIC;
+    }
+    if (!s_boot_logged) {
+        // First record of this boot opens a new boot number.
+        s_boot_logged = true;
+        s_rtc_ring.boot++;
+        ring_push_locked(APP_RLOG_BOOT, ms, cause, 0U, 0U);
+    }
+    ring_push_locked(id, ms, a0, a1, a2);
+    taskEXIT_CRITICAL(&s_ring_lock);
+}
+
+size_t app_rtc_log_snapshot(app_rtc_log_rec_t *out_recs, size_t max_items)
+{
+    if ((out_recs == NULL) || (max_items == 0U)) {
+        return 0U;
+    }
+
+    taskENTER_CRITICAL(&s_ring_lock);
+    size_t n = 0U;
+    if (s_rtc_ring.magic == APP_RTC_LOG_MAGIC) {
+        n = (s_rtc_ring.count < max_items) ? s_rtc_ring.count : max_items;
+        // Oldest record sits `count` slots behind head; skip the ones that do not fit.
+        size_t idx = (s_rtc_ring.head + APP_RTC_LOG_CAPACITY - s_rtc_ring.count + (s_rtc_ring.count - n))
+                     % APP_RTC_LOG_CAPACITY;
+        for (size_t i = 0; i < n; ++i) {
+            out_recs[i] = s_rtc_ring.recs[idx];
+            idx = (idx + 1U) % APP_RTC_LOG_CAPACITY;
+        }
+    }
+    taskEXIT_CRITICAL(&s_ring_lock);
+    return n;
+}
+
+void app_rtc_log_clear(void)
+{
+    taskENTER_CRITICAL(&s_ring_lock);
+    s_rtc_ring.head = 0U;
+    s_rtc_ring.count = 0U;
+    taskEXIT_CRITICAL(&s_ring_lock);
+}
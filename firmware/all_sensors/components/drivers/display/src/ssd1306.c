@@ -4,6 +4,7 @@
 #include "esp_check.h"
 #include "esp_log.h"
 #include "driver/i2c_master.h"
+#include "bsp_init.h"
 #include "ssd1306.h"
 #include "ssd1306_font.h"
 
@@ -11,22 +12,40 @@
    SECTION: Constants
    ========================================================================= */
 #define SSD1306_I2C_ADDRESS           0x3C
-#define SSD1306_I2C_CLOCK_HZ          100000
+#ifndef SSD1306_I2C_CLOCK_HZ
+#define SSD1306_I2C_CLOCK_HZ          400000  // 2.5 us minimum SCL cycle
+#endif
 #define SSD1306_CONTROL_BYTE_COMMAND  0x00
 #define SSD1306_CONTROL_BYTE_DATA     0x40
 #define SSD1306_BUFFER_SIZE          ((SSD1306_WIDTH * SSD1306_HEIGHT / 8) + 1)
 #define SSD1306_MUTEX_TIMEOUT        pdMS_TO_TICKS(500)
 #define SSD1306_I2C_TIMEOUT_MS       100
+#define SSD1306_PAGES                (SSD1306_HEIGHT / 8)
+// Fixed cost of one flush window on the wire: column/page command
+// transaction (7 bytes + address) and the data transaction's address and
+// control byte.
+#define SSD1306_WINDOW_OVERHEAD      10U
 
 /* =========================================================================
    SECTION: Types
    ========================================================================= */
+// Columns [x0, x1) of a page changed since the last flush; x1 == 0 is clean.
+typedef struct {
+    uint8_t x0;
+    uint8_t x1;
+} ssd1306_dirty_t;
+
 struct ssd1306 {
     i2c_master_bus_handle_t bus;
     i2c_master_dev_handle_t dev;
     SemaphoreHandle_t lock;
     bool need_reinit;
+    bool shown_valid;                    // `shown` matches the panel RAM
+    ssd1306_dirty_t dirty[SSD1306_PAGES];
     uint8_t buffer[SSD1306_BUFFER_SIZE];
+    // Last flushed frame. Screens are redrawn as clear + draw, which touches
+    // bytes that end up unchanged; flush trims those off against this.
+    uint8_t shown[SSD1306_PAGES * SSD1306_WIDTH];
 };
 
 /* =========================================================================
@@ -74,22 +93,139 @@ static esp_err_t ssd1306_send_commands(ssd1306_t *ctx, const uint8_t *cmds, size
     if (len == 0) {
         return ESP_OK;
     }
-    return i2c_master_transmit(ctx->dev, cmds, len, SSD1306_I2C_TIMEOUT_MS);
+    return bsp_i2c_transmit(ctx->dev, cmds, len, SSD1306_I2C_TIMEOUT_MS);
+}
+
+static void ssd1306_mark_all_dirty(ssd1306_t *ctx) {
+    for (size_t page = 0; page < SSD1306_PAGES; ++page) {
+        ctx->dirty[page].x0 = 0;
+        ctx->dirty[page].x1 = SSD1306_WIDTH;
+    }
+    ctx->shown_valid = false;
+}
+
+// Narrows a page's dirty range to the columns that differ from the panel.
+static void ssd1306_trim_dirty(ssd1306_t *ctx, uint8_t page) {
+    ssd1306_dirty_t *d = &ctx->dirty[page];
+    if (!ctx->shown_valid || (d->x1 == 0U)) {
+        return;
+    }
+
+    const uint8_t *now = &ctx->buffer[((size_t)page * SSD1306_WIDTH) + 1U];
+    const uint8_t *was = &ctx->shown[(size_t)page * SSD1306_WIDTH];
+    while ((d->x0 < d->x1) && (now[d->x0] == was[d->x0])) {
+        ++d->x0;
+    }
+    while ((d->x1 > d->x0) && (now[d->x1 - 1U] == was[d->x1 - 1U])) {
+        --d->x1;
+    }
+    if (d->x0 == d->x1) {
+        d->x0 = 0;
+        d->x1 = 0;
+    }
 }
 
-static esp_err_t ssd1306_reset_cursor(ssd1306_t *ctx) {
+// Every framebuffer write goes through here, so a byte that does not change
+// costs nothing at flush time.
+static inline void ssd1306_put_locked(ssd1306_t *ctx, uint8_t page, uint8_t x, uint8_t value) {
+    uint8_t *cell = &ctx->buffer[((size_t)page * SSD1306_WIDTH) + x + 1U];
+    if (*cell == value) {
+        return;
+    }
+    *cell = value;
+
+    ssd1306_dirty_t *d = &ctx->dirty[page];
+    if (d->x1 == 0U) {
+        d->x0 = x;
+        d->x1 = (uint8_t)(x + 1U);
+    } else if (x < d->x0) {
+        d->x0 = x;
+    } else if (x >= d->x1) {
+        d->x1 = (uint8_t)(x + 1U);
+    }
+}
+
+// Pages [page0, page1], columns [x0, x1). The data is one contiguous run of
+// the framebuffer: a single page, or full-width pages.
+static esp_err_t ssd1306_send_window(ssd1306_t *ctx, uint8_t page0, uint8_t page1, uint8_t x0, uint8_t x1) {
     const uint8_t cmds[] = {
         SSD1306_CONTROL_BYTE_COMMAND,
-        0x21, 0x00, 0x7F, // Column address
-        0x22, 0x00, 0x07  // Page address
+        0x21, x0, (uint8_t)(x1 - 1U),  // Column address
+        0x22, page0, page1             // Page address
     };
-    return ssd1306_send_commands(ctx, cmds, sizeof(cmds));
+    esp_err_t err = ssd1306_send_commands(ctx, cmds, sizeof(cmds));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // The byte in front of the run stands in for the control byte while it is sent.
+    const size_t start = ((size_t)page0 * SSD1306_WIDTH) + x0 + 1U;
+    const size_t len = ((size_t)(page1 - page0) * SSD1306_WIDTH) + (x1 - x0);
+    const uint8_t saved = ctx->buffer[start - 1U];
+    ctx->buffer[start - 1U] = SSD1306_CONTROL_BYTE_DATA;
+    err = bsp_i2c_transmit(ctx->dev, &ctx->buffer[start - 1U], len + 1U, SSD1306_I2C_TIMEOUT_MS);
+    ctx->buffer[start - 1U] = saved;
+    if (err == ESP_OK) {
+        for (uint8_t page = page0; page <= page1; ++page) {
+            const size_t off = ((size_t)page * SSD1306_WIDTH) + x0;
+            memcpy(&ctx->shown[off], &ctx->buffer[off + 1U], (size_t)(x1 - x0));
+        }
+    }
+    return err;
+}
+
+// Each run of consecutive dirty pages goes out either page by page, over the
+// dirty columns only, or as one full-width window when that is fewer bytes.
+static esp_err_t ssd1306_flush_dirty(ssd1306_t *ctx) {
+    size_t sent = 0;
+    for (uint8_t page = 0; page < SSD1306_PAGES; ++page) {
+        ssd1306_trim_dirty(ctx, page);
+    }
+
+    uint8_t page = 0;
+    while (page < SSD1306_PAGES) {
+        if (ctx->dirty[page].x1 == 0U) {
+            ++page;
+            continue;
+        }
+
+        uint8_t end = page;
+        size_t per_page = 0;
+        while ((end < SSD1306_PAGES) && (ctx->dirty[end].x1 != 0U)) {
+            per_page += (size_t)(ctx->dirty[end].x1 - ctx->dirty[end].x0) + SSD1306_WINDOW_OVERHEAD;
+            ++end;
+        }
+        const size_t full = ((size_t)(end - page) * SSD1306_WIDTH) + SSD1306_WINDOW_OVERHEAD;
+
+        if (full <= per_page) {
+            ESP_RETURN_ON_ERROR(ssd1306_send_window(ctx, page, (uint8_t)(end - 1U), 0, SSD1306_WIDTH), TAG, "flush");
+            sent += full;
+        } else {
+            for (uint8_t p = page; p < end; ++p) {
+                ESP_RETURN_ON_ERROR(ssd1306_send_window(ctx, p, p, ctx->dirty[p].x0, ctx->dirty[p].x1), TAG, "flush");
+            }
+            sent += per_page;
+        }
+        for (uint8_t p = page; p < end; ++p) {
+            ctx->dirty[p].x0 = 0;
+            ctx->dirty[p].x1 = 0;
+        }
+        page = end;
+    }
+    ctx->shown_valid = true;
+
+    if (sent != 0U) {
+        ESP_LOGD(TAG, "flush ~%u bytes", (unsigned)sent);
+    }
+    return ESP_OK;
 }
 
 static esp_err_t ssd1306_try_recover(ssd1306_t *ctx) {
     esp_err_t err = ssd1306_send_commands(ctx, s_init_sequence, sizeof(s_init_sequence));
     if (err == ESP_OK) {
         ctx->need_reinit = false;
+        // Panel RAM is unknown after a reset.
+        ssd1306_mark_all_dirty(ctx);
         vTaskDelay(pdMS_TO_TICKS(50));
     }
     return err;
@@ -101,14 +237,11 @@ static inline void ssd1306_draw_pixel_locked(ssd1306_t *ctx, uint8_t x, uint8_t
     }
 
     uint8_t page = y / 8U;
-    uint8_t bit_index = y % 8U;
-    size_t buffer_index = (page * SSD1306_WIDTH) + x + 1U;
+    uint8_t bit = (uint8_t)(1U << (y % 8U));
+    uint8_t value = ctx->buffer[((size_t)page * SSD1306_WIDTH) + x + 1U];
 
-    if (color) {
-        ctx->buffer[buffer_index] |= (1U << bit_index);
-    } else {
-        ctx->buffer[buffer_index] &= (uint8_t)~(1U << bit_index);
-    }
+    value = color ? (uint8_t)(value | bit) : (uint8_t)(value & (uint8_t)~bit);
+    ssd1306_put_locked(ctx, page, x, value);
 }
 
 static int ssd1306_decode_utf8(const char *text, uint32_t *codepoint_out) {
@@ -130,13 +263,8 @@ static int ssd1306_decode_utf8(const char *text, uint32_t *codepoint_out) {
 }
 
 static esp_err_t ssd1306_init_device(ssd1306_t *ctx, i2c_master_bus_handle_t bus) {
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = SSD1306_I2C_ADDRESS,
-        .scl_speed_hz = SSD1306_I2C_CLOCK_HZ,
-    };
-
-    ESP_RETURN_ON_ERROR(i2c_master_bus_add_device(bus, &dev_cfg, &ctx->dev), TAG, "add device failed");
+    ESP_RETURN_ON_ERROR(bsp_i2c_device_get(bus, SSD1306_I2C_ADDRESS, SSD1306_I2C_CLOCK_HZ, &ctx->dev),
+                        TAG, "add device failed");
     vTaskDelay(pdMS_TO_TICKS(20)); // allow display power-up
 
     esp_err_t err = ESP_FAIL;
@@ -155,6 +283,7 @@ static esp_err_t ssd1306_init_device(ssd1306_t *ctx, i2c_master_bus_handle_t bus
     }
 
     ctx->need_reinit = false;
+    ssd1306_mark_all_dirty(ctx);
     return ESP_OK;
 }
 
@@ -200,10 +329,8 @@ esp_err_t ssd1306_create(i2c_master_bus_handle_t bus, ssd1306_handle_t *out_hand
 void ssd1306_destroy(ssd1306_handle_t handle) {
     ssd1306_t *ctx = handle ? handle : &s_ctx;
 
-    if (ctx->dev != NULL) {
-        i2c_master_bus_rm_device(ctx->dev);
-        ctx->dev = NULL;
-    }
+    // The device handle belongs to the bus manager and goes away with the bus.
+    ctx->dev = NULL;
     if (ctx->lock != NULL) {
         vSemaphoreDelete(ctx->lock);
         ctx->lock = NULL;
@@ -234,8 +361,11 @@ esp_err_t ssd1306_clear(ssd1306_handle_t handle) {
     if (!ssd1306_lock(ctx)) {
         return ESP_ERR_TIMEOUT;
     }
-    memset(ctx->buffer, 0, sizeof(ctx->buffer));
-    ctx->buffer[0] = SSD1306_CONTROL_BYTE_DATA;
+    for (uint8_t page = 0; page < SSD1306_PAGES; ++page) {
+        for (uint8_t x = 0; x < SSD1306_WIDTH; ++x) {
+            ssd1306_put_locked(ctx, page, x, 0);
+        }
+    }
     ssd1306_unlock(ctx);
     return ESP_OK;
 }
@@ -321,12 +451,11 @@ esp_err_t ssd1306_draw_text(ssd1306_handle_t handle, const char *text, uint8_t x
         }
 
         const uint8_t *glyph = ssd1306_font_get_glyph(codepoint);
-        size_t base_index = ((size_t)cursor_page * SSD1306_WIDTH) + cursor_x + 1U;
         for (uint8_t col = 0; col < SSD1306_FONT_WIDTH; ++col) {
             if ((uint16_t)cursor_x + col >= SSD1306_WIDTH) {
                 break;
             }
-            ctx->buffer[base_index + col] = glyph[col];
+            ssd1306_put_locked(ctx, cursor_page, (uint8_t)(cursor_x + col), glyph[col]);
         }
 
         cursor_x = (uint8_t)(cursor_x + SSD1306_FONT_WIDTH);
@@ -404,14 +533,8 @@ esp_err_t ssd1306_flush(ssd1306_handle_t handle) {
         }
     }
 
-    esp_err_t err = ssd1306_reset_cursor(ctx);
-    if (err != ESP_OK) {
-        ctx->need_reinit = true;
-        ssd1306_unlock(ctx);
-        return err;
-    }
-
-    err = i2c_master_transmit(ctx->dev, ctx->buffer, sizeof(ctx->buffer), SSD1306_I2C_TIMEOUT_MS);
+    // Pages not yet sent stay dirty; a failed transfer re-inits and resends everything.
+    esp_err_t err = ssd1306_flush_dirty(ctx);
     if (err != ESP_OK) {
         ctx->need_reinit = true;
     }
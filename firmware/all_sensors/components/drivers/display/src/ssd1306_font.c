@@ -5,7 +5,7 @@
    ========================================================================= */
 #define SSD1306_FONT_ASCII_OFFSET 32
 #define SSD1306_FONT_ASCII_COUNT 95
-#define SSD1306_FONT_SPECIAL_COUNT 19
+#define SSD1306_FONT_SPECIAL_COUNT 20   // 19 Polish/degree glyphs + fallback box
 #define SSD1306_FONT_TABLE_SIZE (SSD1306_FONT_ASCII_COUNT + SSD1306_FONT_SPECIAL_COUNT)
 #define SSD1306_FONT_FALLBACK_INDEX (SSD1306_FONT_TABLE_SIZE - 1)
 
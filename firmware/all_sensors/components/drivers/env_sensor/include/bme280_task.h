@@ -12,3 +12,10 @@
    ========================================================================= */
 esp_err_t bme280_read_once(sensor_task_context_t *shared_ctx);
 esp_err_t bme280_debug_loop(sensor_task_context_t *shared_ctx, uint32_t interval_ms);
+
+// Burst: begin once, then trigger/collect per reading with other work in
+// between; the sensor sleeps by itself after each forced conversion, so there
+// is no end call. Outputs are the Bosch integer units (0.01 degC, 0.01 Pa).
+esp_err_t bme280_burst_begin(sensor_task_context_t *shared_ctx);
+esp_err_t bme280_burst_trigger(void);
+esp_err_t bme280_burst_collect(int32_t *out_temp_centi_c, uint32_t *out_pressure_centi_pa);
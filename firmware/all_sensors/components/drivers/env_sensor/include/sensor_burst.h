@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include "app_types.h"
+#include "sensor_schedule.h"
+#include "sensor_task_context.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Takes `count` readings of every sensor in `due`, interleaved: the BME280
+// converts and the soil ADC samples while the VEML7700 integrates, so a round
+// costs about one light integration period. Means go into shared_ctx->data,
+// the spread into out_stats. Returns the sensors with at least one good reading.
+sensor_mask_t sensor_burst_run(sensor_task_context_t *shared_ctx,
+                               sensor_mask_t due,
+                               uint8_t count,
+                               sensor_stats_t *out_stats);
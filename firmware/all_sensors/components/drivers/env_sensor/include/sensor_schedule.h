@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include "app_types.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef uint8_t sensor_mask_t;
+#define SENSOR_MASK_SOIL    ((sensor_mask_t)0x01)
+#define SENSOR_MASK_LUX     ((sensor_mask_t)0x02)
+#define SENSOR_MASK_ENV     ((sensor_mask_t)0x04)   // BME280: temperature and pressure
+#define SENSOR_MASK_ALL     ((sensor_mask_t)0x07)
+#define SENSOR_MASK_I2C     (SENSOR_MASK_LUX | SENSOR_MASK_ENV)
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Advances the sampling cycle and returns the sensors due in it. Everything is
+// due on the first cycle after power-on or a non-timer wake, and for any
+// sensor without a reading yet. A failing sensor is left out while its
+// re-probe backoff runs, except on a non-timer wake.
+sensor_mask_t sensor_schedule_begin(void);
+
+// Records success (in `fresh`) or failure of each sensor in `due`, keeps the
+// fresh fields for later cycles and fills the others from the last good
+// reading. Sets SENSOR_FLAG_*_STALE and SENSOR_FLAG_*_FAULT in io_data->flags.
+void sensor_schedule_finish(sensor_data_t *io_data, sensor_mask_t due, sensor_mask_t fresh);
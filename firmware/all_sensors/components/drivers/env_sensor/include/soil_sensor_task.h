@@ -11,3 +11,7 @@
    SECTION: API
    ========================================================================= */
 esp_err_t soil_sensor_read_once(sensor_task_context_t *shared_ctx);
+// One reading without touching the shared context, for burst mode.
+esp_err_t soil_sensor_sample(uint16_t *out_raw, uint8_t *out_moisture);
+// Battery voltage sampled alongside the last soil reading (CONFIG_APP_BATTERY_MONITOR).
+esp_err_t soil_sensor_battery_mv(uint16_t *out_mv);
@@ -83,6 +83,8 @@
                                      VEML7700_ALS_PERS_1 | VEML7700_ALS_INT_DISABLE | \
                                      VEML7700_ALS_POWER_ON)
 
+#define VEML7700_RANGE_COUNT        9
+
 typedef enum {
     VEML7700_LIGHT_WARM,
     VEML7700_LIGHT_NEUTRAL,
@@ -109,6 +111,7 @@ esp_err_t veml7700_enable_interrupt(i2c_master_dev_handle_t dev_handle, bool ena
 
 float veml7700_raw_to_lux(uint16_t raw_als, uint16_t config);
 float veml7700_get_resolution(uint16_t config);
+uint16_t veml7700_range_config(uint8_t range);
 veml7700_color_temp_t veml7700_get_color_temp(uint16_t als, uint16_t white);
 float veml7700_get_als_white_ratio(uint16_t als, uint16_t white);
 
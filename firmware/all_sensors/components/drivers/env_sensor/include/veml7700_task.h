@@ -11,3 +11,10 @@
    SECTION: API
    ========================================================================= */
 esp_err_t veml7700_read_once(sensor_task_context_t *shared_ctx);
+uint16_t veml7700_lux_level(float lux);  // 0/1/2 as stored in sensor_data_t
+
+// Burst: begin auto-ranges and returns the first reading, leaving the ALS
+// integrating; each sample waits for the next full integration period.
+esp_err_t veml7700_burst_begin(sensor_task_context_t *shared_ctx, float *out_lux);
+esp_err_t veml7700_burst_sample(float *out_lux);
+void veml7700_burst_end(void);
@@ -2,8 +2,11 @@
 #include <stdlib.h>
 #include "esp_log.h"
 #include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "driver/i2c_master.h"
+#include "bsp_init.h"
 #include "app_context.h"
+#include "app_rtc_log.h"
 #include "bme280.h"
 #include "bme280_defs.h"
 #include "bme280_task.h"
@@ -14,18 +17,40 @@
    SECTION: Constants
    ========================================================================= */
 #define BME280_I2C_ADDR_PRIMARY    0x76
-#define BME280_I2C_SPEED_HZ        100000
+#ifndef BME280_I2C_SPEED_HZ
+#define BME280_I2C_SPEED_HZ        400000  // fast mode; the part allows up to 3.4 MHz
+#endif
 #define BME280_TIMEOUT_MS          2000
+#define BME280_PROBE_TIMEOUT_MS      50    // address ACK check before the slow path
 #define BME280_TASK_STACK          4096
 #define BME280_READ_ATTEMPTS        3
 #define BME280_READ_DELAY_MS       50
 #define BME280_DEBUG_INTERVAL_MS  500
+#define BME280_SPIN_MAX_US         500     // shorter waits are not worth a context switch
+#define BME280_MEAS_EXTRA_POLLS      3     // ticks to wait past the datasheet maximum
+#define BME280_CENTI_C_ZERO_K      27315   // 0 K in 0.01 degC
+
+// The conversions below take the library's integer output (0.01 degC,
+// 0.01 Pa); the double build would hand them floating point instead.
+#ifdef BME280_DOUBLE_ENABLE
+#error "bme280_task expects the integer compensation path (BME280_DOUBLE_ENABLE unset)"
+#endif
 
 /* =========================================================================
    SECTION: Static Data
    ========================================================================= */
 static const char *TAG = "BME_TASK";
 
+// Open device between begin and end; read_once opens and closes it around one reading.
+typedef struct {
+    i2c_master_dev_handle_t dev_handle;
+    struct bme280_dev dev;
+    uint32_t meas_delay_us;
+    int64_t trigger_us;
+} bme280_session_t;
+
+static bme280_session_t s_session;
+
 /* =========================================================================
    SECTION: I2C Callbacks
    ========================================================================= */
@@ -36,12 +61,12 @@ static int8_t bme280_i2c_read_cb(uint8_t reg_addr, uint8_t *reg_data, uint32_t l
     }
 
     i2c_master_dev_handle_t handle = *((i2c_master_dev_handle_t *)intf_ptr);
-    esp_err_t err = i2c_master_transmit_receive(handle,
-                                                &reg_addr,
-                                                1,
-                                                reg_data,
-                                                len,
-                                                BME280_TIMEOUT_MS);
+    esp_err_t err = bsp_i2c_transmit_receive(handle,
+                                             &reg_addr,
+                                             1,
+                                             reg_data,
+                                             len,
+                                             BME280_TIMEOUT_MS);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "I2C read failed (%s)", esp_err_to_name(err));
         return BME280_E_COMM_FAIL;
@@ -63,10 +88,10 @@ static int8_t bme280_i2c_write_cb(uint8_t reg_addr, const uint8_t *reg_data, uin
         memcpy(&write_buf[1], reg_data, len);
     }
 
-    esp_err_t err = i2c_master_transmit(handle,
-                                        write_buf,
-                                        len + 1U,
-                                        BME280_TIMEOUT_MS);
+    esp_err_t err = bsp_i2c_transmit(handle,
+                                     write_buf,
+                                     len + 1U,
+                                     BME280_TIMEOUT_MS);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "I2C write failed (%s)", esp_err_to_name(err));
         return BME280_E_COMM_FAIL;
@@ -75,46 +100,78 @@ static int8_t bme280_i2c_write_cb(uint8_t reg_addr, const uint8_t *reg_data, uin
     return BME280_OK;
 }
 
+// Millisecond waits block the task so the idle task (and automatic light
+// sleep) runs while the sensor converts; only sub-tick waits spin.
 static void bme280_delay_us_cb(uint32_t period, void *intf_ptr)
 {
     (void)intf_ptr;
-    esp_rom_delay_us(period);
-}
 
-static void bme280_wait_measurement(struct bme280_dev *dev)
-{
-    if (dev == NULL) {
+    if (period < BME280_SPIN_MAX_US) {
+        esp_rom_delay_us(period);
         return;
     }
 
-    struct bme280_settings settings = {0};
-    uint32_t delay_us = 0;
-    if (BME280_OK == bme280_get_sensor_settings(&settings, dev)) {
-        (void)bme280_cal_meas_delay(&delay_us, &settings);
-    }
+    // vTaskDelay(n) may return up to one tick early.
+    const uint32_t tick_us = portTICK_PERIOD_MS * 1000U;
+    vTaskDelay((TickType_t)((period + tick_us - 1U) / tick_us) + 1U);
+}
 
-    if (delay_us < 10000U) {
-        delay_us = 10000U;
+// Forced conversion, split so a burst can do other work while it runs.
+static esp_err_t bme280_trigger(bme280_session_t *session)
+{
+    if (BME280_OK != bme280_set_sensor_mode(BME280_POWERMODE_FORCED, &session->dev)) {
+        return ESP_FAIL;
     }
-
-    dev->delay_us(delay_us + 5000U, dev->intf_ptr);
+    session->trigger_us = esp_timer_get_time();
+    return ESP_OK;
 }
 
-
-static void bme280_force_measurement(struct bme280_dev *dev)
+// Sleeps out whatever is left of the precomputed conversion time, then reads
+// all data registers in one burst.
+static esp_err_t bme280_collect(bme280_session_t *session, struct bme280_data *out_data)
 {
-    if (dev == NULL) {
-        return;
+    struct bme280_dev *dev = &session->dev;
+    const int64_t elapsed_us = esp_timer_get_time() - session->trigger_us;
+    if (elapsed_us < (int64_t)session->meas_delay_us) {
+        dev->delay_us((uint32_t)((int64_t)session->meas_delay_us - elapsed_us), dev->intf_ptr);
+    }
+
+    uint8_t status = 0;
+    for (uint32_t i = 0; i < BME280_MEAS_EXTRA_POLLS; ++i) {
+        if (BME280_OK != bme280_get_regs(BME280_REG_STATUS, &status, 1, dev)) {
+            return ESP_FAIL;
+        }
+        if ((status & BME280_STATUS_MEAS_DONE) == 0U) {
+            break;
+        }
+        vTaskDelay(1);
+    }
+    // Still converting: the data registers hold the previous result.
+    if ((status & BME280_STATUS_MEAS_DONE) != 0U) {
+        ESP_LOGW(TAG, "bme280 still measuring after %u polls", (unsigned)BME280_MEAS_EXTRA_POLLS);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (BME280_OK != bme280_get_sensor_data(BME280_PRESS | BME280_TEMP, out_data, dev)) {
+        return ESP_FAIL;
+    }
+    if ((out_data->temperature == 0) && (out_data->pressure == 0U)) {
+        ESP_LOGW(TAG, "bme280 data zero");
+        return ESP_FAIL;
     }
 
-    (void)bme280_set_sensor_mode(BME280_POWERMODE_FORCED, dev);
-    bme280_wait_measurement(dev);
+    ESP_LOGD(TAG, "raw temp=%d cC press=%u cPa", (int)out_data->temperature, (unsigned)out_data->pressure);
+    APP_RLOG(BME280_FIXED, (uint32_t)out_data->temperature, out_data->pressure, 0);
+    return ESP_OK;
 }
 
 /* =========================================================================
    SECTION: Helpers
    ========================================================================= */
-static esp_err_t bme280_setup(struct bme280_dev *dev)
+// Datasheet "weather monitoring" profile: 1x oversampling, IIR filter off
+// (it only averages across conversions, and we take one per wake). Still
+// 0.026 hPa / 0.005 C resolution, far finer than what telemetry carries.
+static esp_err_t bme280_setup(struct bme280_dev *dev, uint32_t *out_meas_delay_us)
 {
     if (BME280_OK != bme280_init(dev)) {
         ESP_LOGW(TAG, "bme280_init failed");
@@ -122,30 +179,26 @@ static esp_err_t bme280_setup(struct bme280_dev *dev)
     }
 
     struct bme280_settings settings = {
-        .osr_p = BME280_OVERSAMPLING_16X,
-        .osr_t = BME280_OVERSAMPLING_2X,
+        .osr_p = BME280_OVERSAMPLING_1X,
+        .osr_t = BME280_OVERSAMPLING_1X,
         .osr_h = BME280_NO_OVERSAMPLING,
-        .filter = BME280_FILTER_COEFF_16,
-        .standby_time = BME280_STANDBY_TIME_62_5_MS,
+        .filter = BME280_FILTER_COEFF_OFF,
     };
 
     uint8_t settings_sel = BME280_SEL_OSR_PRESS |
                            BME280_SEL_OSR_TEMP |
-                           BME280_SEL_FILTER |
-                           BME280_SEL_STANDBY;
+                           BME280_SEL_FILTER;
 
     if (BME280_OK != bme280_set_sensor_settings(settings_sel, &settings, dev)) {
         ESP_LOGE(TAG, "bme280_set_sensor_settings failed");
         return ESP_FAIL;
     }
 
-    if (BME280_OK != bme280_set_sensor_mode(BME280_POWERMODE_NORMAL, dev)) {
-        ESP_LOGE(TAG, "bme280_set_sensor_mode failed");
+    if (BME280_OK != bme280_cal_meas_delay(out_meas_delay_us, &settings)) {
+        ESP_LOGE(TAG, "bme280_cal_meas_delay failed");
         return ESP_FAIL;
     }
 
-    bme280_wait_measurement(dev);
-
     return ESP_OK;
 }
 
@@ -161,47 +214,28 @@ static void bme280_log_chip_id(struct bme280_dev *dev)
     }
 }
 
-static uint16_t temp_c_to_dk(float temp_c)
+// Bosch integer output: 0.01 degC, clamped by the library to -40..85 degC,
+// so the sum is always positive and fits 16 bits.
+static uint16_t temp_centi_c_to_dk(int32_t temp_centi_c)
 {
-    float temp_dk_f = (temp_c + 273.15f) * 10.0f;
-    if (temp_dk_f < 0.0f) {
-        return 0U;
-    }
-    if (temp_dk_f > 65535.0f) {
-        return 65535U;
-    }
-    return (uint16_t)(temp_dk_f + 0.5f);
+    return (uint16_t)(((uint32_t)(temp_centi_c + BME280_CENTI_C_ZERO_K) + 5U) / 10U);
 }
 
-static void bme280_update_context(const sensor_task_context_t *shared, float temp_c, float pressure_pa)
+static void bme280_update_context(const sensor_task_context_t *shared, const struct bme280_data *data)
 {
     if (shared == NULL || shared->data == NULL) {
         return;
     }
 
-    shared->data->temperature = temp_c_to_dk(temp_c);
-    shared->data->pressure = pressure_pa / 100.0f;
-}
-
-static void bme280_comp_to_float(const struct bme280_data *data, float *out_temp_c, float *out_pressure_pa)
-{
-    if (data == NULL || out_temp_c == NULL || out_pressure_pa == NULL) {
-        return;
-    }
-
-#ifdef BME280_DOUBLE_ENABLE
-    *out_temp_c = (float)data->temperature;
-    *out_pressure_pa = (float)data->pressure;
-#else
-    *out_temp_c = (float)data->temperature / 100.0f;
-    *out_pressure_pa = (float)data->pressure / 100.0f;
-#endif
+    shared->data->temperature = temp_centi_c_to_dk(data->temperature);
+    // Pa x 100 from the 64-bit path is already the sensor_data_t unit.
+    shared->data->pressure_cpa = data->pressure;
 }
 
 /* =========================================================================
    SECTION: Task
    ========================================================================= */
-static esp_err_t bme280_read_impl(sensor_task_context_t *shared_ctx)
+static esp_err_t bme280_open(sensor_task_context_t *shared_ctx)
 {
     if (shared_ctx == NULL || shared_ctx->bus == NULL) {
         ESP_LOGW(TAG, "shared context missing");
@@ -211,47 +245,51 @@ static esp_err_t bme280_read_impl(sensor_task_context_t *shared_ctx)
     i2c_master_bus_handle_t bus = shared_ctx->bus;
     ESP_LOGI(TAG, "bus=%p", (void *)bus);
 
-    i2c_master_dev_handle_t dev_handle = NULL;
-    struct bme280_dev dev = {0};
-    i2c_device_config_t dev_config = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = BME280_I2C_ADDR_PRIMARY,
-        .scl_speed_hz = BME280_I2C_SPEED_HZ,
-    };
+    bme280_session_t *session = &s_session;
+    memset(session, 0, sizeof(*session));
 
-    if (i2c_master_bus_add_device(bus, &dev_config, &dev_handle) != ESP_OK) {
-        ESP_LOGW(TAG, "device add failed");
-        goto cleanup;
+    // A missing sensor NACKs its address; fail here, not after init timeouts and retries.
+    if (bsp_i2c_probe(bus, BME280_I2C_ADDR_PRIMARY, BME280_PROBE_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "no ACK at 0x%02X", BME280_I2C_ADDR_PRIMARY);
+        return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "device added addr=0x%02X", BME280_I2C_ADDR_PRIMARY);
+    // The handle stays attached to the bus between reads; nothing to remove here.
+    if (bsp_i2c_device_get(bus, BME280_I2C_ADDR_PRIMARY, BME280_I2C_SPEED_HZ, &session->dev_handle) != ESP_OK) {
+        ESP_LOGW(TAG, "device add failed");
+        return ESP_FAIL;
+    }
 
-    dev.intf = BME280_I2C_INTF;
-    dev.read = bme280_i2c_read_cb;
-    dev.write = bme280_i2c_write_cb;
-    dev.delay_us = bme280_delay_us_cb;
-    dev.intf_ptr = &dev_handle;
+    session->dev.intf = BME280_I2C_INTF;
+    session->dev.read = bme280_i2c_read_cb;
+    session->dev.write = bme280_i2c_write_cb;
+    session->dev.delay_us = bme280_delay_us_cb;
+    session->dev.intf_ptr = &session->dev_handle;
 
-    if (bme280_setup(&dev) != ESP_OK) {
+    if (bme280_setup(&session->dev, &session->meas_delay_us) != ESP_OK) {
         ESP_LOGW(TAG, "bme280 setup failed");
-        goto cleanup;
+        return ESP_FAIL;
     }
 
-    bme280_log_chip_id(&dev);
+    bme280_log_chip_id(&session->dev);
+    return ESP_OK;
+}
+
+static esp_err_t bme280_read_impl(sensor_task_context_t *shared_ctx)
+{
+    esp_err_t ret = ESP_FAIL;
+    if (bme280_open(shared_ctx) != ESP_OK) {
+        goto cleanup;
+    }
 
     struct bme280_data comp_data = {0};
     bool read_ok = false;
     for (uint32_t i = 0; i < BME280_READ_ATTEMPTS; ++i) {
-        bme280_force_measurement(&dev);
-        if (BME280_OK == bme280_get_sensor_data(BME280_PRESS | BME280_TEMP, &comp_data, &dev)) {
-            if (!((comp_data.temperature == 0.0f) && (comp_data.pressure == 0.0f))) {
-                read_ok = true;
-                break;
-            }
-            ESP_LOGW(TAG, "bme280 data zero (attempt %u)", (unsigned)(i + 1U));
-        } else {
-            ESP_LOGW(TAG, "bme280_get_sensor_data failed (attempt %u)", (unsigned)(i + 1U));
+        if ((bme280_trigger(&s_session) == ESP_OK) && (bme280_collect(&s_session, &comp_data) == ESP_OK)) {
+            read_ok = true;
+            break;
         }
+        ESP_LOGW(TAG, "bme280 forced measurement failed (attempt %u)", (unsigned)(i + 1U));
 
         vTaskDelay(pdMS_TO_TICKS(BME280_READ_DELAY_MS));
     }
@@ -261,22 +299,13 @@ static esp_err_t bme280_read_impl(sensor_task_context_t *shared_ctx)
         goto cleanup;
     }
 
-    float temp_c = 0.0f;
-    float pressure_pa = 0.0f;
-    bme280_comp_to_float(&comp_data, &temp_c, &pressure_pa);
-
-    ESP_LOGI(TAG, "raw temp=%.2fC press=%.2fPa", temp_c, pressure_pa);
-
-    bme280_update_context(shared_ctx, temp_c, pressure_pa);
-    (void)bme280_set_sensor_mode(BME280_POWERMODE_SLEEP, &dev);
+    // Forced mode drops back to sleep by itself after the conversion.
+    bme280_update_context(shared_ctx, &comp_data);
+    ret = ESP_OK;
 
 cleanup:
-    if (dev_handle != NULL) {
-        (void)i2c_master_bus_rm_device(dev_handle);
-    }
-
     ESP_LOGI(TAG, "bme280 task done");
-    return ESP_OK;
+    return ret;
 }
 
 /* =========================================================================
@@ -287,3 +316,28 @@ esp_err_t bme280_read_once(sensor_task_context_t *shared_ctx)
     return bme280_read_impl(shared_ctx);
     
 }
+
+esp_err_t bme280_burst_begin(sensor_task_context_t *shared_ctx)
+{
+    return bme280_open(shared_ctx);
+}
+
+esp_err_t bme280_burst_trigger(void)
+{
+    return bme280_trigger(&s_session);
+}
+
+esp_err_t bme280_burst_collect(int32_t *out_temp_centi_c, uint32_t *out_pressure_centi_pa)
+{
+    if ((out_temp_centi_c == NULL) || (out_pressure_centi_pa == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct bme280_data comp_data = {0};
+    esp_err_t err = bme280_collect(&s_session, &comp_data);
+    if (err == ESP_OK) {
+        *out_temp_centi_c = comp_data.temperature;
+        *out_pressure_centi_pa = comp_data.pressure;
+    }
+    return err;
+}
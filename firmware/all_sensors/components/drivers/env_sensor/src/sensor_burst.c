@@ -0,0 +1,200 @@
+#include <stdint.h>
+#include <string.h>
+#include "esp_log.h"
+#include "bme280_task.h"
+#include "veml7700_task.h"
+#include "soil_sensor_task.h"
+#include "sensor_burst.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define BURST_CENTI_C_ZERO_K   27315   // 0 K in 0.01 degC
+#define BURST_U16_MAX          65535U
+#define BURST_LUX_MAX          1000000U  // above the VEML7700 range, keeps the sums in 64 bits
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+// Integer sums keep the variance exact; up to 255 readings of 24-bit values
+// (pressure in 0.01 Pa) fit.
+typedef struct {
+    uint32_t n;
+    uint64_t sum;
+    uint64_t sum_sq;
+    uint32_t min;
+    uint32_t max;
+} burst_acc_t;
+
+/* =========================================================================
+   SECTION: Static Data
+   ========================================================================= */
+static const char *TAG = "SENSOR_BURST";
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void acc_add(burst_acc_t *acc, uint32_t value)
+{
+    if ((acc->n == 0U) || (value < acc->min)) {
+        acc->min = value;
+    }
+    if ((acc->n == 0U) || (value > acc->max)) {
+        acc->max = value;
+    }
+    acc->n++;
+    acc->sum += value;
+    acc->sum_sq += (uint64_t)value * value;
+}
+
+static uint32_t acc_mean(const burst_acc_t *acc)
+{
+    return (uint32_t)((acc->sum + (acc->n / 2U)) / acc->n);
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0U) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static uint16_t clamp_u16(uint32_t v)
+{
+    return (v > BURST_U16_MAX) ? (uint16_t)BURST_U16_MAX : (uint16_t)v;
+}
+
+// Accumulated values are `div` times finer than the reported unit.
+static void acc_to_stat(const burst_acc_t *acc, uint32_t div, sensor_stat_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    if (acc->n == 0U) {
+        return;
+    }
+
+    const uint64_t n = acc->n;
+    const uint64_t spread = (n * acc->sum_sq) - (acc->sum * acc->sum);
+    // Only a wildly swinging 24-bit field gets near the top; divide first there.
+    const uint64_t var100 = (spread <= (UINT64_MAX / 100U)) ? ((spread * 100U) / (n * n))
+                                                             : ((spread / (n * n)) * 100U);
+    const uint32_t sd10 = isqrt64(var100);
+
+    out->min = clamp_u16((acc->min + div / 2U) / div);
+    out->max = clamp_u16((acc->max + div / 2U) / div);
+    out->sd10 = clamp_u16((sd10 + div / 2U) / div);
+    out->n = (uint8_t)acc->n;
+}
+
+static uint32_t lux_to_acc(float lux)
+{
+    if (lux <= 0.0f) {
+        return 0U;
+    }
+    return (lux >= (float)BURST_LUX_MAX) ? BURST_LUX_MAX : (uint32_t)(lux + 0.5f);
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+sensor_mask_t sensor_burst_run(sensor_task_context_t *shared_ctx,
+                               sensor_mask_t due,
+                               uint8_t count,
+                               sensor_stats_t *out_stats)
+{
+    if ((shared_ctx == NULL) || (shared_ctx->data == NULL) || (out_stats == NULL) || (count == 0U)) {
+        return 0;
+    }
+
+    burst_acc_t lux = {0};
+    burst_acc_t temp_ck = {0};  // centi-Kelvin
+    burst_acc_t press_cpa = {0};
+    burst_acc_t soil = {0};
+
+    sensor_mask_t active = due;
+    if (shared_ctx->bus == NULL) {
+        active &= (sensor_mask_t)~SENSOR_MASK_I2C;
+    }
+
+    // First light reading comes out of auto-ranging.
+    if (active & SENSOR_MASK_LUX) {
+        float value = 0.0f;
+        if (veml7700_burst_begin(shared_ctx, &value) == ESP_OK) {
+            acc_add(&lux, lux_to_acc(value));
+        } else {
+            active &= (sensor_mask_t)~SENSOR_MASK_LUX;
+        }
+    }
+    if ((active & SENSOR_MASK_ENV) && (bme280_burst_begin(shared_ctx) != ESP_OK)) {
+        active &= (sensor_mask_t)~SENSOR_MASK_ENV;
+    }
+
+    for (uint8_t round = 0; round < count; ++round) {
+        const bool env = (active & SENSOR_MASK_ENV) && (bme280_burst_trigger() == ESP_OK);
+
+        if (active & SENSOR_MASK_SOIL) {
+            uint16_t raw = 0;
+            uint8_t pct = 0;
+            if (soil_sensor_sample(&raw, &pct) == ESP_OK) {
+                acc_add(&soil, pct);
+            }
+        }
+
+        // Round 0 already has its light reading; later ones wait for the next integration.
+        if ((round > 0U) && (active & SENSOR_MASK_LUX)) {
+            float value = 0.0f;
+            if (veml7700_burst_sample(&value) == ESP_OK) {
+                acc_add(&lux, lux_to_acc(value));
+            }
+        }
+
+        if (env) {
+            int32_t temp_centi_c = 0;
+            uint32_t pressure_centi_pa = 0;
+            if (bme280_burst_collect(&temp_centi_c, &pressure_centi_pa) == ESP_OK) {
+                acc_add(&temp_ck, (uint32_t)(temp_centi_c + BURST_CENTI_C_ZERO_K));
+                acc_add(&press_cpa, pressure_centi_pa);
+            }
+        }
+    }
+
+    if (active & SENSOR_MASK_LUX) {
+        veml7700_burst_end();
+    }
+
+    sensor_mask_t fresh = 0;
+    sensor_data_t *data = shared_ctx->data;
+    if (lux.n > 0U) {
+        data->lux_level = veml7700_lux_level((float)acc_mean(&lux));
+        fresh |= SENSOR_MASK_LUX;
+    }
+    if (temp_ck.n > 0U) {
+        data->temperature = clamp_u16((acc_mean(&temp_ck) + 5U) / 10U);
+        data->pressure_cpa = acc_mean(&press_cpa);
+        fresh |= SENSOR_MASK_ENV;
+    }
+    if (soil.n > 0U) {
+        data->soil_moisture = (uint8_t)acc_mean(&soil);
+        fresh |= SENSOR_MASK_SOIL;
+    }
+
+    acc_to_stat(&lux, 1U, &out_stats->lux);
+    acc_to_stat(&temp_ck, 10U, &out_stats->temperature);
+    acc_to_stat(&press_cpa, 1000U, &out_stats->pressure);
+    acc_to_stat(&soil, 1U, &out_stats->soil);
+
+    ESP_LOGI(TAG, "burst x%u: lux n=%u temp n=%u soil n=%u", (unsigned)count,
+             (unsigned)lux.n, (unsigned)temp_ck.n, (unsigned)soil.n);
+    return fresh;
+}
@@ -0,0 +1,179 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "app_backoff.h"
+#include "app_rtc_log.h"
+#include "sensor_schedule.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+// Sampling periods in cycles (wakes, or connected-sleep intervals).
+#ifndef SENSOR_PERIOD_SOIL
+#define SENSOR_PERIOD_SOIL      1U
+#endif
+#ifndef SENSOR_PERIOD_LUX
+#define SENSOR_PERIOD_LUX       2U
+#endif
+#ifndef SENSOR_PERIOD_ENV
+#define SENSOR_PERIOD_ENV       6U
+#endif
+
+// Health: after this many consecutive failures a sensor is skipped for 1, 2,
+// 4 ... cycles between re-probes, up to the max.
+#define SENSOR_FAIL_THRESHOLD   2U
+#define SENSOR_FAIL_MAX_SKIP    64U
+
+#define SENSOR_COUNT            3U
+#define SENSOR_SCHEDULE_MAGIC   0x53534332UL   // "SSC2"
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef struct {
+    app_backoff_t backoff;   // consecutive failures, cycles left to skip
+    uint32_t last_ok_cycle;  // cycle of the last good reading
+} sensor_health_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t cycle;          // sensing cycles since power-on
+    sensor_mask_t have;      // sensors with a reading in `last`
+    sensor_data_t last;      // latest fresh value of each field
+    sensor_health_t health[SENSOR_COUNT];   // indexed by SENSOR_MASK_* bit
+} sensor_schedule_rtc_t;
+
+/* =========================================================================
+   SECTION: Static Data
+   ========================================================================= */
+static const char *TAG = "SENSOR_SCHED";
+static bool s_boot_cycle_done;
+
+RTC_DATA_ATTR static sensor_schedule_rtc_t s_rtc_sched;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static bool sensor_schedule_hit(uint32_t cycle, uint32_t period)
+{
+    return (period <= 1U) || ((cycle % period) == 0U);
+}
+
+static void sensor_health_update(sensor_mask_t due, sensor_mask_t fresh)
+{
+    const uint32_t cycle = s_rtc_sched.cycle - 1U;
+    for (uint32_t i = 0; i < SENSOR_COUNT; ++i) {
+        const sensor_mask_t bit = (sensor_mask_t)(1U << i);
+        if ((due & bit) == 0U) {
+            continue;
+        }
+
+        sensor_health_t *health = &s_rtc_sched.health[i];
+        if (fresh & bit) {
+            if (health->backoff.failures != 0U) {
+                ESP_LOGI(TAG, "sensor 0x%02x back after %u failures", (unsigned)bit, (unsigned)health->backoff.failures);
+            }
+            app_backoff_on_success(&health->backoff);
+            health->last_ok_cycle = cycle;
+            continue;
+        }
+
+        app_backoff_on_failure(&health->backoff, SENSOR_FAIL_THRESHOLD, SENSOR_FAIL_MAX_SKIP);
+        ESP_LOGW(TAG, "sensor 0x%02x failed %u times, skipping %u cycles",
+                 (unsigned)bit, (unsigned)health->backoff.failures, (unsigned)health->backoff.skip_left);
+        APP_RLOG(SENSOR_FAULT, bit, health->backoff.failures, cycle - health->last_ok_cycle);
+    }
+}
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+sensor_mask_t sensor_schedule_begin(void)
+{
+    if (s_rtc_sched.magic != SENSOR_SCHEDULE_MAGIC) {
+        memset(&s_rtc_sched, 0, sizeof(s_rtc_sched));
+        s_rtc_sched.magic = SENSOR_SCHEDULE_MAGIC;
+    }
+
+    const uint32_t cycle = s_rtc_sched.cycle++;
+    sensor_mask_t due = 0;
+    if (sensor_schedule_hit(cycle, SENSOR_PERIOD_SOIL)) {
+        due |= SENSOR_MASK_SOIL;
+    }
+    if (sensor_schedule_hit(cycle, SENSOR_PERIOD_LUX)) {
+        due |= SENSOR_MASK_LUX;
+    }
+    if (sensor_schedule_hit(cycle, SENSOR_PERIOD_ENV)) {
+        due |= SENSOR_MASK_ENV;
+    }
+
+    due |= (sensor_mask_t)(SENSOR_MASK_ALL & ~s_rtc_sched.have);
+
+    // Someone pressed a button and is looking at the display: show fresh
+    // values, and re-probe failing sensors in case the wiring was fixed.
+    if (!s_boot_cycle_done && (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER)) {
+        due = SENSOR_MASK_ALL;
+    } else {
+        for (uint32_t i = 0; i < SENSOR_COUNT; ++i) {
+            const sensor_mask_t bit = (sensor_mask_t)(1U << i);
+            if ((due & bit) && app_backoff_should_skip(&s_rtc_sched.health[i].backoff)) {
+                due &= (sensor_mask_t)~bit;
+            }
+        }
+    }
+    s_boot_cycle_done = true;
+
+    ESP_LOGD(TAG, "cycle %u due=0x%02x", (unsigned)cycle, (unsigned)due);
+    return due;
+}
+
+void sensor_schedule_finish(sensor_data_t *io_data, sensor_mask_t due, sensor_mask_t fresh)
+{
+    if (io_data == NULL) {
+        return;
+    }
+
+    sensor_health_update(due, fresh);
+
+    sensor_data_t *last = &s_rtc_sched.last;
+    uint8_t flags = 0;
+
+    if (fresh & SENSOR_MASK_SOIL) {
+        last->soil_moisture = io_data->soil_moisture;
+    } else {
+        io_data->soil_moisture = last->soil_moisture;
+        flags |= SENSOR_FLAG_SOIL_STALE;
+    }
+
+    if (fresh & SENSOR_MASK_LUX) {
+        last->lux_level = io_data->lux_level;
+    } else {
+        io_data->lux_level = last->lux_level;
+        flags |= SENSOR_FLAG_LUX_STALE;
+    }
+
+    if (fresh & SENSOR_MASK_ENV) {
+        last->temperature = io_data->temperature;
+        last->pressure_cpa = io_data->pressure_cpa;
+    } else {
+        io_data->temperature = last->temperature;
+        io_data->pressure_cpa = last->pressure_cpa;
+        flags |= SENSOR_FLAG_ENV_STALE;
+    }
+
+    if (s_rtc_sched.health[0].backoff.failures != 0U) {
+        flags |= SENSOR_FLAG_SOIL_FAULT;
+    }
+    if (s_rtc_sched.health[1].backoff.failures != 0U) {
+        flags |= SENSOR_FLAG_LUX_FAULT;
+    }
+    if (s_rtc_sched.health[2].backoff.failures != 0U) {
+        flags |= SENSOR_FLAG_ENV_FAULT;
+    }
+
+    s_rtc_sched.have |= fresh;
+    io_data->flags = flags;
+}
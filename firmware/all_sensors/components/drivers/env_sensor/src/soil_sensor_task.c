@@ -1,8 +1,10 @@
 #include <string.h>
 #include <stdlib.h>
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "board_pins.h"
 #include "app_context.h"
+#include "app_rtc_log.h"
 #include "soil_sensor.h"
 #include "soil_sensor_task.h"
 
@@ -36,6 +38,11 @@ static soil_sensor_handle_t ensure_soil_sensor(void)
         .power_active_high = true,
         .sample_count = 0,
         .settle_ms = 0,
+#if CONFIG_APP_BATTERY_MONITOR
+        .aux_enable = true,
+        .aux_channel = BSP_ADC_BATT_CHANNEL,
+        .aux_atten = BSP_ADC_BATT_ATTEN,
+#endif
     };
 
     if (soil_sensor_create(&cfg, &handle) != ESP_OK) {
@@ -73,13 +80,8 @@ static void update_context(const sensor_task_context_t *shared, uint8_t moisture
 /* =========================================================================
    SECTION: Task
    ========================================================================= */
-static esp_err_t soil_read_impl(sensor_task_context_t *shared_ctx)
+static esp_err_t soil_sample_impl(uint16_t *out_raw, uint8_t *out_moisture)
 {
-    if (shared_ctx == NULL) {
-        ESP_LOGW(TAG, "shared context missing");
-        return ESP_ERR_INVALID_ARG;
-    }
-
     soil_sensor_handle_t handle = ensure_soil_sensor();
     if (handle == NULL) {
         ESP_LOGW(TAG, "soil sensor unavailable");
@@ -90,24 +92,40 @@ static esp_err_t soil_read_impl(sensor_task_context_t *shared_ctx)
 
     apply_calibration(handle);
 
-    uint8_t moisture = 0;
-    uint16_t raw = 0;
-    if (soil_sensor_probe(handle, &raw, &moisture) != ESP_OK) {
+    if (soil_sensor_probe(handle, out_raw, out_moisture) != ESP_OK) {
         ESP_LOGW(TAG, "soil probe failed");
         return ESP_FAIL;
     }
 
-    update_context(shared_ctx, moisture);
     config_t cfg = {0};
     if (app_context_get_config(&cfg) == ESP_OK) {
-        ESP_LOGI(TAG, "soil raw=%u dry=%u wet=%u moisture=%u%%",
-                 (unsigned)raw,
+        ESP_LOGD(TAG, "soil raw=%u dry=%u wet=%u moisture=%u%%",
+                 (unsigned)*out_raw,
                  (unsigned)cfg.soil_adc_dry,
                  (unsigned)cfg.soil_adc_wet,
-                 (unsigned)moisture);
+                 (unsigned)*out_moisture);
     } else {
-        ESP_LOGI(TAG, "soil raw=%u moisture=%u%%", (unsigned)raw, (unsigned)moisture);
+        ESP_LOGD(TAG, "soil raw=%u moisture=%u%%", (unsigned)*out_raw, (unsigned)*out_moisture);
     }
+    APP_RLOG(SOIL, *out_raw, *out_moisture, 0);
+    return ESP_OK;
+}
+
+static esp_err_t soil_read_impl(sensor_task_context_t *shared_ctx)
+{
+    if (shared_ctx == NULL) {
+        ESP_LOGW(TAG, "shared context missing");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t moisture = 0;
+    uint16_t raw = 0;
+    esp_err_t err = soil_sample_impl(&raw, &moisture);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    update_context(shared_ctx, moisture);
     return ESP_OK;
 }
 
@@ -118,3 +136,29 @@ esp_err_t soil_sensor_read_once(sensor_task_context_t *shared_ctx)
 {
     return soil_read_impl(shared_ctx);
 }
+
+esp_err_t soil_sensor_sample(uint16_t *out_raw, uint8_t *out_moisture)
+{
+    if ((out_raw == NULL) || (out_moisture == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return soil_sample_impl(out_raw, out_moisture);
+}
+
+esp_err_t soil_sensor_battery_mv(uint16_t *out_mv)
+{
+    if (out_mv == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    soil_sensor_handle_t handle = app_context_get_soil_sensor();
+    uint32_t pin_mv = 0;
+    if ((handle == NULL) || (soil_sensor_get_aux_mv(handle, &pin_mv) != ESP_OK)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const uint32_t mv = pin_mv * BSP_BATT_DIVIDER_MUL;
+    *out_mv = (mv > UINT16_MAX) ? UINT16_MAX : (uint16_t)mv;
+    ESP_LOGD(TAG, "battery %u mV (pin %u mV)", (unsigned)*out_mv, (unsigned)pin_mv);
+    return ESP_OK;
+}
@@ -1,8 +1,12 @@
 #include <string.h>
 #include <stdlib.h>
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/i2c_master.h"
+#include "bsp_init.h"
 #include "app_context.h"
+#include "app_rtc_log.h"
 #include "veml7700.h"
 #include "veml7700_task.h"
 #include "freertos/FreeRTOS.h"
@@ -12,19 +16,48 @@
    SECTION: Constants
    ========================================================================= */
 #define VEML7700_I2C_ADDR       0x10
-#define VEML7700_I2C_SPEED_HZ   100000
+#ifndef VEML7700_I2C_SPEED_HZ
+#define VEML7700_I2C_SPEED_HZ   400000  // fast mode, the part maximum
+#endif
 #define VEML7700_TIMEOUT_MS     500
+#define VEML7700_PROBE_TIMEOUT_MS 50
 #define VEML7700_TASK_STACK     4096
 #define VEML7700_TASK_PRIO      5
 
 #define LUX_LOW_THRESHOLD       300.0f
 #define LUX_HIGH_THRESHOLD      1000.0f
 
+// Auto-range: counts outside [UNDERFLOW, SATURATION] trigger a range step.
+#define VEML7700_RAW_SATURATION 60000U
+#define VEML7700_RAW_UNDERFLOW  100U
+#define VEML7700_RAW_TARGET     400U    // expected counts when stepping up
+#define VEML7700_RANGE_DEFAULT  2U      // gain x1, 25ms: ~1.8 lux/count
+#define VEML7700_STARTUP_MS     3U      // power-on / config change settling
+#define VEML7700_RANGE_MAGIC    0x564DU // "VM"
+
 /* =========================================================================
    SECTION: Static Data
    ========================================================================= */
 static const char *TAG = "VEML_TASK";
 
+// Range of the last good reading; light rarely changes a full step between wakes.
+typedef struct {
+    uint16_t magic;
+    uint8_t range;
+} veml7700_rtc_range_t;
+
+RTC_DATA_ATTR static veml7700_rtc_range_t s_rtc_range;
+
+// Burst state: the ALS keeps integrating at the auto-ranged config between samples.
+typedef struct {
+    i2c_master_dev_handle_t dev_handle;
+    uint16_t cfg;
+    uint32_t period_us;
+    int64_t last_read_us;
+} veml7700_burst_t;
+
+static veml7700_burst_t s_burst;
+
 /* =========================================================================
    SECTION: Helpers
    ========================================================================= */
@@ -69,10 +102,84 @@ static uint32_t veml7700_get_integration_ms(uint16_t config)
     }
 }
 
+static uint8_t veml7700_start_range(void)
+{
+    if ((s_rtc_range.magic != VEML7700_RANGE_MAGIC) || (s_rtc_range.range >= VEML7700_RANGE_COUNT)) {
+        return VEML7700_RANGE_DEFAULT;
+    }
+    return s_rtc_range.range;
+}
+
+// Least sensitive step at which `raw`, measured at `range`, would reach the target.
+static uint8_t veml7700_range_for_raw(uint8_t range, uint16_t raw)
+{
+    const float counts_lux = (float)raw * veml7700_get_resolution(veml7700_range_config(range));
+    for (uint8_t next = (uint8_t)(range + 1U); next < VEML7700_RANGE_COUNT; ++next) {
+        if (counts_lux >= (float)VEML7700_RAW_TARGET * veml7700_get_resolution(veml7700_range_config(next))) {
+            return next;
+        }
+    }
+    return VEML7700_RANGE_COUNT - 1U;
+}
+
+static uint32_t veml7700_wait_ms(uint16_t cfg)
+{
+    const uint32_t it_ms = veml7700_get_integration_ms(cfg);
+    return it_ms + (it_ms / 10U) + VEML7700_STARTUP_MS;
+}
+
+static esp_err_t veml7700_measure(i2c_master_dev_handle_t dev_handle, uint16_t cfg, uint16_t *out_raw)
+{
+    esp_err_t err = veml7700_init(dev_handle, cfg);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(veml7700_wait_ms(cfg)) + 1U);
+
+    return veml7700_read_als(dev_handle, out_raw);
+}
+
+// Starts from the last wake's range and only moves on saturation (straight
+// to the least sensitive step) or underflow (to the step the reading predicts).
+static esp_err_t veml7700_auto_range(i2c_master_dev_handle_t dev_handle, uint16_t *out_cfg, float *out_lux)
+{
+    uint8_t range = veml7700_start_range();
+    uint16_t cfg = veml7700_range_config(range);
+    uint16_t raw = 0;
+
+    for (uint32_t step = 0; step < VEML7700_RANGE_COUNT; ++step) {
+        cfg = veml7700_range_config(range);
+        esp_err_t err = veml7700_measure(dev_handle, cfg, &raw);
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        uint8_t next = range;
+        if ((raw >= VEML7700_RAW_SATURATION) && (range > 0U)) {
+            next = 0U;
+        } else if ((raw < VEML7700_RAW_UNDERFLOW) && (range < (VEML7700_RANGE_COUNT - 1U))) {
+            next = veml7700_range_for_raw(range, raw);
+        }
+        if (next == range) {
+            break;
+        }
+        ESP_LOGD(TAG, "range %u -> %u (raw=%u)", (unsigned)range, (unsigned)next, (unsigned)raw);
+        range = next;
+    }
+
+    s_rtc_range.magic = VEML7700_RANGE_MAGIC;
+    s_rtc_range.range = range;
+
+    *out_cfg = cfg;
+    *out_lux = veml7700_raw_to_lux(raw, cfg);
+    return ESP_OK;
+}
+
 /* =========================================================================
    SECTION: Task
    ========================================================================= */
-static esp_err_t veml7700_read_impl(sensor_task_context_t *shared_ctx)
+static esp_err_t veml7700_open(const sensor_task_context_t *shared_ctx, i2c_master_dev_handle_t *out_dev)
 {
     if (shared_ctx == NULL || shared_ctx->bus == NULL) {
         ESP_LOGW(TAG, "shared context missing");
@@ -82,54 +189,45 @@ static esp_err_t veml7700_read_impl(sensor_task_context_t *shared_ctx)
     i2c_master_bus_handle_t bus = shared_ctx->bus;
     ESP_LOGI(TAG, "bus=%p", (void *)bus);
 
-    i2c_master_dev_handle_t dev_handle = NULL;
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = VEML7700_I2C_ADDR,
-        .scl_speed_hz = VEML7700_I2C_SPEED_HZ,
-    };
-
-    if (i2c_master_bus_add_device(bus, &dev_cfg, &dev_handle) != ESP_OK) {
-        ESP_LOGW(TAG, "device add failed");
-        goto cleanup_lock;
+    if (bsp_i2c_probe(bus, VEML7700_I2C_ADDR, VEML7700_PROBE_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "no ACK at 0x%02X", VEML7700_I2C_ADDR);
+        return ESP_FAIL;
     }
-    ESP_LOGI(TAG, "device added addr=0x%02X", VEML7700_I2C_ADDR);
 
-    uint16_t cfg = VEML7700_DEFAULT_CONFIG;
-    if (veml7700_init(dev_handle, cfg) != ESP_OK) {
-        ESP_LOGW(TAG, "veml7700 init failed");
-        goto cleanup;
-    }
-
-    if (veml7700_read_config(dev_handle, &cfg) != ESP_OK) {
-        ESP_LOGW(TAG, "veml7700 read config failed");
-        cfg = VEML7700_DEFAULT_CONFIG;
+    if (bsp_i2c_device_get(bus, VEML7700_I2C_ADDR, VEML7700_I2C_SPEED_HZ, out_dev) != ESP_OK) {
+        ESP_LOGW(TAG, "device add failed");
+        return ESP_FAIL;
     }
+    return ESP_OK;
+}
 
-    uint32_t wait_ms = veml7700_get_integration_ms(cfg) + 10U;
-    if (wait_ms < 150U) {
-        wait_ms = 150U;
+static esp_err_t veml7700_read_impl(sensor_task_context_t *shared_ctx)
+{
+    esp_err_t ret = ESP_FAIL;
+    i2c_master_dev_handle_t dev_handle = NULL;
+    if (veml7700_open(shared_ctx, &dev_handle) != ESP_OK) {
+        goto cleanup_lock;
     }
-    vTaskDelay(pdMS_TO_TICKS(wait_ms));
 
+    uint16_t cfg = 0;
     float lux = 0.0f;
-    if (veml7700_read_lux(dev_handle, &lux) != ESP_OK) {
+    if (veml7700_auto_range(dev_handle, &cfg, &lux) != ESP_OK) {
         ESP_LOGW(TAG, "veml7700 read lux failed");
         goto cleanup;
     }
 
-    ESP_LOGI(TAG, "cfg=0x%04X lux=%.2f", (unsigned)cfg, lux);
+    ESP_LOGD(TAG, "cfg=0x%04X lux=%.2f", (unsigned)cfg, lux);
+    APP_RLOG(VEML7700, cfg, APP_RLOG_F(lux), 0);
     veml7700_update_context(shared_ctx, lux);
+    ret = ESP_OK;
 
 cleanup:
-    if (dev_handle != NULL) {
-        (void)veml7700_shutdown(dev_handle);
-        (void)i2c_master_bus_rm_device(dev_handle);
-    }
+    // Handle stays attached to the bus; only put the sensor back to sleep.
+    (void)veml7700_shutdown(dev_handle);
 
 cleanup_lock:
     ESP_LOGI(TAG, "veml7700 task done");
-    return ESP_OK;
+    return ret;
 }
 
 /* =========================================================================
@@ -139,3 +237,65 @@ esp_err_t veml7700_read_once(sensor_task_context_t *shared_ctx)
 {
     return veml7700_read_impl(shared_ctx);
 }
+
+uint16_t veml7700_lux_level(float lux)
+{
+    return lux_to_level(lux);
+}
+
+esp_err_t veml7700_burst_begin(sensor_task_context_t *shared_ctx, float *out_lux)
+{
+    if (out_lux == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(&s_burst, 0, sizeof(s_burst));
+    esp_err_t err = veml7700_open(shared_ctx, &s_burst.dev_handle);
+    if (err != ESP_OK) {
+        s_burst.dev_handle = NULL;
+        return err;
+    }
+
+    err = veml7700_auto_range(s_burst.dev_handle, &s_burst.cfg, out_lux);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "veml7700 read lux failed");
+        veml7700_burst_end();
+        return err;
+    }
+
+    s_burst.period_us = veml7700_wait_ms(s_burst.cfg) * 1000U;
+    s_burst.last_read_us = esp_timer_get_time();
+    APP_RLOG(VEML7700, s_burst.cfg, APP_RLOG_F(*out_lux), 0);
+    return ESP_OK;
+}
+
+esp_err_t veml7700_burst_sample(float *out_lux)
+{
+    if ((out_lux == NULL) || (s_burst.dev_handle == NULL)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // A result register read before the running integration ends returns the previous one.
+    const int64_t due_us = s_burst.last_read_us + (int64_t)s_burst.period_us;
+    const int64_t now_us = esp_timer_get_time();
+    if (now_us < due_us) {
+        vTaskDelay(pdMS_TO_TICKS((uint32_t)((due_us - now_us + 999) / 1000)) + 1U);
+    }
+
+    uint16_t raw = 0;
+    esp_err_t err = veml7700_read_als(s_burst.dev_handle, &raw);
+    s_burst.last_read_us = esp_timer_get_time();
+    if (err == ESP_OK) {
+        *out_lux = veml7700_raw_to_lux(raw, s_burst.cfg);
+    }
+    return err;
+}
+
+void veml7700_burst_end(void)
+{
+    if (s_burst.dev_handle != NULL) {
+        (void)veml7700_shutdown(s_burst.dev_handle);
+        s_burst.dev_handle = NULL;
+    }
+    ESP_LOGI(TAG, "veml7700 burst done");
+}
@@ -1,4 +1,5 @@
 #include "veml7700.h"
+#include "bsp_init.h"
 #include "esp_log.h"
 
 static const char *TAG = "VEML7700";
@@ -17,6 +18,19 @@ static const float resolution_table[4][6] = {
     {7.3728f, 3.6864f, 1.8432f, 0.9216f, 0.4608f, 0.2304f},
 };
 
+// Auto-range ladder, least to most sensitive
+static const uint16_t range_ladder[VEML7700_RANGE_COUNT] = {
+    VEML7700_ALS_SM_1_8 | VEML7700_ALS_IT_25MS,
+    VEML7700_ALS_SM_1_4 | VEML7700_ALS_IT_25MS,
+    VEML7700_ALS_SM_1   | VEML7700_ALS_IT_25MS,
+    VEML7700_ALS_SM_2   | VEML7700_ALS_IT_25MS,
+    VEML7700_ALS_SM_2   | VEML7700_ALS_IT_50MS,
+    VEML7700_ALS_SM_2   | VEML7700_ALS_IT_100MS,
+    VEML7700_ALS_SM_2   | VEML7700_ALS_IT_200MS,
+    VEML7700_ALS_SM_2   | VEML7700_ALS_IT_400MS,
+    VEML7700_ALS_SM_2   | VEML7700_ALS_IT_800MS,
+};
+
 static int get_gain_index(uint16_t config) {
     uint8_t sm = (config & VEML7700_ALS_SM_MASK) >> VEML7700_ALS_SM_SHIFT;
     return sm;  // 0=x1, 1=x2, 2=x1/8, 3=x1/4
@@ -55,14 +69,21 @@ float veml7700_get_resolution(uint16_t config) {
     return resolution_table[gain_idx][it_idx];
 }
 
+uint16_t veml7700_range_config(uint8_t range) {
+    if (range >= VEML7700_RANGE_COUNT) {
+        range = VEML7700_RANGE_COUNT - 1U;
+    }
+    return range_ladder[range] | VEML7700_ALS_PERS_1 | VEML7700_ALS_INT_DISABLE | VEML7700_ALS_POWER_ON;
+}
+
 esp_err_t veml7700_write_reg(i2c_master_dev_handle_t dev_handle, uint8_t reg, uint16_t value) {
     uint8_t data[3] = {reg, value & 0xFF, (value >> 8) & 0xFF};
-    return i2c_master_transmit(dev_handle, data, 3, 100);
+    return bsp_i2c_transmit(dev_handle, data, 3, 100);
 }
 
 esp_err_t veml7700_read_reg(i2c_master_dev_handle_t dev_handle, uint8_t reg, uint16_t *value) {
     uint8_t data[2];
-    esp_err_t ret = i2c_master_transmit_receive(dev_handle, &reg, 1, data, 2, 100);
+    esp_err_t ret = bsp_i2c_transmit_receive(dev_handle, &reg, 1, data, 2, 100);
     if (ret == ESP_OK) {
         *value = data[0] | (data[1] << 8);
     }
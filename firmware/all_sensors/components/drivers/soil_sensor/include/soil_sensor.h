@@ -15,6 +15,11 @@
    ========================================================================= */
 typedef struct soil_sensor *soil_sensor_handle_t;
 
+typedef enum {
+    SOIL_SENSOR_BACKEND_AUTO = 0,     // DMA burst when available, oneshot otherwise
+    SOIL_SENSOR_BACKEND_ONESHOT,      // sample_count oneshot reads, 10 ms apart
+} soil_sensor_backend_t;
+
 /* Optional power pin control. Use GPIO_NUM_NC when not used. */
 typedef struct {
     adc_unit_t unit;              // ADC unit (ADC_UNIT_1/2)
@@ -23,8 +28,12 @@ typedef struct {
     adc_atten_t atten;            // e.g. ADC_ATTEN_DB_11
     gpio_num_t power_gpio;        // Optional VCC switch; GPIO_NUM_NC to ignore
     bool power_active_high;       // true if high enables power
-    uint8_t sample_count;         // Number of averaged samples (>=1)
-    uint16_t settle_ms;           // Delay after power-on before reading
+    uint8_t sample_count;         // Number of averaged samples (>=1), oneshot backend
+    uint16_t settle_ms;           // Delay after power-on before reading, needs power_gpio
+    soil_sensor_backend_t backend;
+    bool aux_enable;              // also sample aux_channel (same unit) on every read
+    adc_channel_t aux_channel;
+    adc_atten_t aux_atten;
 } soil_sensor_config_t;
 
 /* =========================================================================
@@ -39,7 +48,8 @@ esp_err_t soil_sensor_disable(soil_sensor_handle_t handle);
 /* =========================================================================
    SECTION: Calibration & Measurements
    ========================================================================= */
-// Take an averaged raw ADC sample; requires sensor enabled.
+// Take an averaged raw ADC sample; requires sensor enabled. The DMA backend
+// returns a trimmed mean of 128..512 samples, scaled to cfg.bitwidth.
 esp_err_t soil_sensor_read_raw(soil_sensor_handle_t handle, uint16_t *out_raw);
 
 esp_err_t soil_sensor_calibrate_dry(soil_sensor_handle_t handle, uint16_t raw);
@@ -49,3 +59,7 @@ esp_err_t soil_sensor_compute_moisture(soil_sensor_handle_t handle, uint16_t raw
 
 esp_err_t soil_sensor_probe(soil_sensor_handle_t handle, uint16_t *out_raw, uint8_t *out_pct);
 
+// Pin voltage of the aux channel averaged during the last raw read, in mV.
+// ESP_ERR_INVALID_STATE when aux is off or the last read had no aux samples.
+esp_err_t soil_sensor_get_aux_mv(soil_sensor_handle_t handle, uint32_t *out_mv);
+
@@ -6,6 +6,12 @@
 #include "esp_check.h"
 #include "driver/gpio.h"
 #include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "soc/soc_caps.h"
+#include "sdkconfig.h"
+#include "bsp_bus.h"
 #include "soil_sensor.h"
 
 /* =========================================================================
@@ -14,9 +20,46 @@
 #define SOIL_SENSOR_DEFAULT_SAMPLES   8
 #define SOIL_SENSOR_DEFAULT_SETTLE_MS 50
 
+// DMA backend: ESP32 digital controller, ADC1 only, type1 output (2 bytes).
+#if CONFIG_IDF_TARGET_ESP32
+#define SOIL_SENSOR_HAS_DMA           1
+#else
+#define SOIL_SENSOR_HAS_DMA           0
+#endif
+
+#ifndef SOIL_DMA_SAMPLE_HZ
+#define SOIL_DMA_SAMPLE_HZ            80000U  // 128 samples in 1.6 ms
+#endif
+#define SOIL_DMA_BATCH                128U    // samples per DMA frame
+#define SOIL_DMA_MAX_SAMPLES          512U
+#define SOIL_DMA_READ_TIMEOUT_MS      20U
+#define SOIL_DMA_TRIM_DIV             8U      // drop 1/8 at each end before averaging
+// Keep reading until variance / n (squared standard error, in 12-bit LSB^2)
+// drops to this, or the buffer is full.
+#define SOIL_DMA_TARGET_SEM_SQ        1U
+
+// Aux channel results are kept at 12 bits whatever the probe bitwidth.
+#define SOIL_AUX_BITS                 12U
+// Uncalibrated fallback: nominal full scale at 12 dB attenuation.
+#define SOIL_AUX_FULL_SCALE_MV        3100U
+
+#if SOIL_SENSOR_HAS_DMA
+#define SOIL_DMA_RESULT_BYTES         SOC_ADC_DIGI_RESULT_BYTES
+#define SOIL_DMA_FRAME_BYTES          (SOIL_DMA_BATCH * SOIL_DMA_RESULT_BYTES)
+#endif
+
 struct soil_sensor {
     soil_sensor_config_t cfg;
     adc_oneshot_unit_handle_t unit;
+#if SOIL_SENSOR_HAS_DMA
+    adc_continuous_handle_t dma;
+    bool dma_failed;                              // fell back to oneshot for good
+    uint8_t dma_frame[SOIL_DMA_FRAME_BYTES];
+    uint16_t dma_samples[SOIL_DMA_MAX_SAMPLES];
+#endif
+    adc_cali_handle_t aux_cali;                   // NULL: no eFuse calibration, linear fallback
+    uint32_t aux_sum;
+    uint32_t aux_count;
     bool enabled;
     uint16_t cal_dry;
     uint16_t cal_wet;
@@ -59,7 +102,47 @@ static esp_err_t soil_sensor_configure_power_pin(struct soil_sensor *s)
     return ESP_OK;
 }
 
-static esp_err_t soil_sensor_setup_adc(struct soil_sensor *s)
+static uint32_t soil_sensor_bits(const struct soil_sensor *s)
+{
+    return (s->cfg.bitwidth == ADC_BITWIDTH_DEFAULT) ? SOIL_AUX_BITS : (uint32_t)s->cfg.bitwidth;
+}
+
+static void soil_sensor_aux_add(struct soil_sensor *s, uint32_t raw12)
+{
+    s->aux_sum += raw12;
+    s->aux_count++;
+}
+
+static void soil_sensor_aux_cali_create(struct soil_sensor *s)
+{
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    const adc_cali_line_fitting_config_t cali_cfg = {
+        .unit_id = s->cfg.unit,
+        .atten = s->cfg.aux_atten,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    if (adc_cali_create_scheme_line_fitting(&cali_cfg, &s->aux_cali) != ESP_OK) {
+        ESP_LOGW(TAG, "aux calibration unavailable, using nominal scale");
+        s->aux_cali = NULL;
+    }
+#else
+    (void)s;
+#endif
+}
+
+static void soil_sensor_aux_cali_delete(struct soil_sensor *s)
+{
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    if (s->aux_cali != NULL) {
+        (void)adc_cali_delete_scheme_line_fitting(s->aux_cali);
+        s->aux_cali = NULL;
+    }
+#else
+    (void)s;
+#endif
+}
+
+static esp_err_t soil_sensor_setup_oneshot(struct soil_sensor *s)
 {
     adc_oneshot_unit_init_cfg_t unit_cfg = {
         .unit_id = s->cfg.unit,
@@ -71,12 +154,191 @@ static esp_err_t soil_sensor_setup_adc(struct soil_sensor *s)
         .atten = s->cfg.atten,
     };
     ESP_RETURN_ON_ERROR(adc_oneshot_config_channel(s->unit, s->cfg.channel, &chan_cfg), TAG, "adc chan cfg");
+    if (s->cfg.aux_enable) {
+        const adc_oneshot_chan_cfg_t aux_cfg = {
+            .bitwidth = s->cfg.bitwidth,
+            .atten = s->cfg.aux_atten,
+        };
+        ESP_RETURN_ON_ERROR(adc_oneshot_config_channel(s->unit, s->cfg.aux_channel, &aux_cfg), TAG, "aux chan cfg");
+    }
     s->enabled = true;
     return ESP_OK;
 }
 
+static esp_err_t soil_sensor_read_oneshot(struct soil_sensor *s, uint16_t *out_raw)
+{
+    uint32_t acc = 0;
+    for (uint8_t i = 0; i < s->cfg.sample_count; i++) {
+        int val = 0;
+        ESP_RETURN_ON_ERROR(bsp_adc_read(s->unit, s->cfg.channel, &val), TAG, "adc read");
+        acc += (uint32_t)val;
+        if (s->cfg.aux_enable) {
+            // One extra conversion per sample, inside the wait the probe needs anyway.
+            int aux = 0;
+            if (bsp_adc_read(s->unit, s->cfg.aux_channel, &aux) == ESP_OK) {
+                soil_sensor_aux_add(s, (uint32_t)aux << (SOIL_AUX_BITS - soil_sensor_bits(s)));
+            }
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    *out_raw = (uint16_t)(acc / s->cfg.sample_count);
+    return ESP_OK;
+}
+
+/* =========================================================================
+   SECTION: DMA Backend
+   ========================================================================= */
+#if SOIL_SENSOR_HAS_DMA
+static bool soil_sensor_dma_wanted(const struct soil_sensor *s)
+{
+    return (s->cfg.backend == SOIL_SENSOR_BACKEND_AUTO) && (s->cfg.unit == ADC_UNIT_1) && !s->dma_failed;
+}
+
+static esp_err_t soil_sensor_setup_dma(struct soil_sensor *s)
+{
+    const adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = SOIL_DMA_FRAME_BYTES * 2U,
+        .conv_frame_size = SOIL_DMA_FRAME_BYTES,
+    };
+    ESP_RETURN_ON_ERROR(adc_continuous_new_handle(&handle_cfg, &s->dma), TAG, "dma handle");
+
+    // The aux channel rides along in the same scan, halving the probe's rate.
+    adc_digi_pattern_config_t pattern[2] = {
+        {
+            .atten = s->cfg.atten,
+            .channel = s->cfg.channel,
+            .unit = s->cfg.unit,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        },
+        {
+            .atten = s->cfg.aux_atten,
+            .channel = s->cfg.aux_channel,
+            .unit = s->cfg.unit,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        },
+    };
+    const adc_continuous_config_t dig_cfg = {
+        .pattern_num = s->cfg.aux_enable ? 2U : 1U,
+        .adc_pattern = pattern,
+        .sample_freq_hz = SOIL_DMA_SAMPLE_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    esp_err_t err = adc_continuous_config(s->dma, &dig_cfg);
+    if (err != ESP_OK) {
+        (void)adc_continuous_deinit(s->dma);
+        s->dma = NULL;
+        ESP_LOGW(TAG, "dma config failed (%s)", esp_err_to_name(err));
+        return err;
+    }
+    return ESP_OK;
+}
+
+static int soil_sensor_cmp_u16(const void *a, const void *b)
+{
+    return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+// Appends this channel's conversions from one DMA frame and sums the aux
+// ones; returns the new count.
+static size_t soil_sensor_dma_collect(struct soil_sensor *s, uint32_t len, size_t count)
+{
+    for (uint32_t i = 0; (i + SOIL_DMA_RESULT_BYTES) <= len && count < SOIL_DMA_MAX_SAMPLES; i += SOIL_DMA_RESULT_BYTES) {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&s->dma_frame[i];
+        if (p->type1.channel == (uint32_t)s->cfg.channel) {
+            s->dma_samples[count++] = (uint16_t)p->type1.data;
+        } else if (s->cfg.aux_enable && (p->type1.channel == (uint32_t)s->cfg.aux_channel)) {
+            soil_sensor_aux_add(s, (uint32_t)p->type1.data);
+        }
+    }
+    return count;
+}
+
+// Trimmed mean of the sorted samples; also returns the variance of the kept part.
+static uint32_t soil_sensor_trimmed_mean(uint16_t *samples, size_t count, uint32_t *out_var)
+{
+    qsort(samples, count, sizeof(samples[0]), soil_sensor_cmp_u16);
+
+    const size_t trim = count / SOIL_DMA_TRIM_DIV;
+    const size_t kept = count - 2U * trim;
+    uint64_t sum = 0;
+    uint64_t sum_sq = 0;
+    for (size_t i = trim; i < trim + kept; i++) {
+        sum += samples[i];
+        sum_sq += (uint64_t)samples[i] * samples[i];
+    }
+
+    const uint32_t mean = (uint32_t)((sum + kept / 2U) / kept);
+    const uint64_t mean_sq = (sum * sum) / kept;
+    *out_var = (uint32_t)((sum_sq - mean_sq) / kept);
+    return mean;
+}
+
+static esp_err_t soil_sensor_read_dma(struct soil_sensor *s, uint16_t *out_raw)
+{
+    ESP_RETURN_ON_ERROR(adc_continuous_start(s->dma), TAG, "dma start");
+
+    esp_err_t err = ESP_OK;
+    size_t count = 0;
+    uint32_t mean = 0;
+    uint32_t var = 0;
+    while (count < SOIL_DMA_MAX_SAMPLES) {
+        uint32_t len = 0;
+        err = bsp_adc_dma_read(s->dma, s->dma_frame, SOIL_DMA_FRAME_BYTES, &len, SOIL_DMA_READ_TIMEOUT_MS);
+        if (err != ESP_OK) {
+            break;
+        }
+        count = soil_sensor_dma_collect(s, len, count);
+        if (count < SOIL_DMA_BATCH) {
+            continue;
+        }
+
+        // Sorting in place is fine: later batches are appended and re-sorted.
+        mean = soil_sensor_trimmed_mean(s->dma_samples, count, &var);
+        if ((var / count) <= SOIL_DMA_TARGET_SEM_SQ) {
+            break;
+        }
+    }
+    (void)adc_continuous_stop(s->dma);
+
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (count < SOIL_DMA_BATCH) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Calibration points are stored at cfg.bitwidth, keep the same scale.
+    const uint32_t bits = (s->cfg.bitwidth == ADC_BITWIDTH_DEFAULT) ? SOC_ADC_DIGI_MAX_BITWIDTH : (uint32_t)s->cfg.bitwidth;
+    const uint32_t shift = (bits < SOC_ADC_DIGI_MAX_BITWIDTH) ? (SOC_ADC_DIGI_MAX_BITWIDTH - bits) : 0U;
+    *out_raw = (uint16_t)((mean + ((1U << shift) >> 1)) >> shift);
+    ESP_LOGD(TAG, "dma n=%u var=%u raw=%u", (unsigned)count, (unsigned)var, (unsigned)*out_raw);
+    return ESP_OK;
+}
+#endif
+
+static esp_err_t soil_sensor_setup_adc(struct soil_sensor *s)
+{
+#if SOIL_SENSOR_HAS_DMA
+    if (soil_sensor_dma_wanted(s)) {
+        if (soil_sensor_setup_dma(s) == ESP_OK) {
+            s->enabled = true;
+            return ESP_OK;
+        }
+        s->dma_failed = true;
+    }
+#endif
+    return soil_sensor_setup_oneshot(s);
+}
+
 static esp_err_t soil_sensor_teardown_adc(struct soil_sensor *s)
 {
+#if SOIL_SENSOR_HAS_DMA
+    if (s->dma) {
+        ESP_RETURN_ON_ERROR(adc_continuous_deinit(s->dma), TAG, "dma deinit");
+        s->dma = NULL;
+    }
+#endif
     if (s->unit) {
         ESP_RETURN_ON_ERROR(adc_oneshot_del_unit(s->unit), TAG, "adc unit del");
         s->unit = NULL;
@@ -121,6 +383,9 @@ esp_err_t soil_sensor_create(const soil_sensor_config_t *cfg, soil_sensor_handle
         free(s);
         return err;
     }
+    if (s->cfg.aux_enable) {
+        soil_sensor_aux_cali_create(s);
+    }
 
     *out_handle = s;
     return ESP_OK;
@@ -135,6 +400,7 @@ void soil_sensor_destroy(soil_sensor_handle_t handle)
     if (s->enabled) {
         (void)soil_sensor_disable(handle);
     }
+    soil_sensor_aux_cali_delete(s);
     free(s);
 }
 
@@ -146,7 +412,8 @@ esp_err_t soil_sensor_enable(soil_sensor_handle_t handle)
         return ESP_OK;
     }
     soil_sensor_power_set(s, true);
-    if (s->cfg.settle_ms) {
+    // Without a power switch the probe is always on, nothing to settle.
+    if (gpio_is_valid(s->cfg.power_gpio) && s->cfg.settle_ms) {
         vTaskDelay(pdMS_TO_TICKS(s->cfg.settle_ms));
     }
     return soil_sensor_setup_adc(s);
@@ -168,16 +435,26 @@ esp_err_t soil_sensor_read_raw(soil_sensor_handle_t handle, uint16_t *out_raw)
     struct soil_sensor *s = handle;
     ESP_RETURN_ON_FALSE(s->enabled, ESP_ERR_INVALID_STATE, TAG, "sensor disabled");
 
-    uint32_t acc = 0;
-    for (uint8_t i = 0; i < s->cfg.sample_count; i++) {
-        int val = 0;
-        ESP_RETURN_ON_ERROR(adc_oneshot_read(s->unit, s->cfg.channel, &val), TAG, "adc read");
-        acc += (uint32_t)val;
-        vTaskDelay(pdMS_TO_TICKS(10));
+    s->aux_sum = 0;
+    s->aux_count = 0;
+#if SOIL_SENSOR_HAS_DMA
+    if (s->dma) {
+        esp_err_t err = soil_sensor_read_dma(s, out_raw);
+        if (err == ESP_OK) {
+            return ESP_OK;
+        }
+
+        // DMA is broken on this board/config: oneshot from now on.
+        ESP_LOGW(TAG, "dma read failed (%s), using oneshot", esp_err_to_name(err));
+        (void)adc_continuous_deinit(s->dma);
+        s->dma = NULL;
+        s->dma_failed = true;
+        ESP_RETURN_ON_ERROR(soil_sensor_setup_oneshot(s), TAG, "oneshot fallback");
+        s->aux_sum = 0;
+        s->aux_count = 0;
     }
-    uint16_t avg = (uint16_t)(acc / s->cfg.sample_count);
-    *out_raw = avg;
-    return ESP_OK;
+#endif
+    return soil_sensor_read_oneshot(s, out_raw);
 }
 
 esp_err_t soil_sensor_calibrate_dry(soil_sensor_handle_t handle, uint16_t raw)
@@ -240,3 +517,22 @@ esp_err_t soil_sensor_probe(soil_sensor_handle_t handle, uint16_t *out_raw, uint
     }
     return err;
 }
+
+esp_err_t soil_sensor_get_aux_mv(soil_sensor_handle_t handle, uint32_t *out_mv)
+{
+    ESP_RETURN_ON_FALSE(handle != NULL, ESP_ERR_INVALID_ARG, TAG, "handle null");
+    ESP_RETURN_ON_FALSE(out_mv != NULL, ESP_ERR_INVALID_ARG, TAG, "out null");
+    struct soil_sensor *s = handle;
+    if (!s->cfg.aux_enable || (s->aux_count == 0U)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const uint32_t raw = (s->aux_sum + s->aux_count / 2U) / s->aux_count;
+    int mv = 0;
+    if ((s->aux_cali != NULL) && (adc_cali_raw_to_voltage(s->aux_cali, (int)raw, &mv) == ESP_OK)) {
+        *out_mv = (uint32_t)mv;
+    } else {
+        *out_mv = (raw * SOIL_AUX_FULL_SCALE_MV) / ((1U << SOIL_AUX_BITS) - 1U);
+    }
+    return ESP_OK;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include "esp_err.h"
@@ -36,9 +37,18 @@ typedef struct {
    state_callbacks_t flash_store;
    state_callbacks_t factory_reset;
    state_callbacks_t idle;
+   state_callbacks_t connected_sleep;
    state_callbacks_t deep_sleep;
 } fsm_callbacks_t;
 
+// Wake budget overruns, kept in RTC memory across deep sleep.
+typedef struct {
+   uint32_t count;            // overruns since power-on
+   app_state_t last_state;    // state that was running when the budget ran out
+   uint32_t last_elapsed_ms;  // time awake at that point
+   bool last_hard;            // FSM did not react, the timer forced deep sleep itself
+} fsm_overrun_info_t;
+
 /* =========================================================================
    SECTION: Public API
    ========================================================================= */
@@ -52,3 +62,5 @@ esp_err_t fsm_manager_post_event(app_event_id_t event_id,
 app_state_t fsm_manager_get_state(void);
 
 esp_err_t fsm_manager_set_callbacks(const fsm_callbacks_t *callbacks);
+
+esp_err_t fsm_manager_get_overrun(fsm_overrun_info_t *out_info);
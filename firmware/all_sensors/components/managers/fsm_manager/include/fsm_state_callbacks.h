@@ -45,6 +45,9 @@ void state_factory_reset_on_exit(exit_mode_t mode);
 void state_idle_on_enter(void);
 void state_idle_on_exit(exit_mode_t mode);
 
+void state_connected_sleep_on_enter(void);
+void state_connected_sleep_on_exit(exit_mode_t mode);
+
 void state_deep_sleep_on_enter(void);
 void state_deep_sleep_on_exit(exit_mode_t mode);
 
@@ -1,26 +1,47 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_check.h"
+#include "esp_sleep.h"
+#include "app_boot_profile.h"
+#include "app_rtc_log.h"
 #include "fsm_manager.h"
 #include "fsm_state_callbacks.h"
 #include "app_context.h"
 #include "nvs_manager.h"
-#include "bsp_init.h"
-#include "ssd1306.h"
 #include "ssd1306_images.h"
 #include "buttons_manager.h"
 #include "mqtt_manager.h"
+#include "wifi_manager.h"
+#include "power_manager.h"
 
 ESP_EVENT_DEFINE_BASE(APP_EVENTS);
 
 static const char *TAG = "FSM";
 
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#ifndef CONFIG_APP_WAKE_BUDGET_MS
+#define CONFIG_APP_WAKE_BUDGET_MS 30000
+#endif
+
+// Time the FSM gets to reach deep sleep after the budget event is posted,
+// before the timer callback stops waiting for it and sleeps on its own.
+#define FSM_WAKE_GRACE_MS   3000U
+// The hard stop may only wait briefly for a sample ring write in progress elsewhere.
+#define FSM_HARD_STORE_LOCK_MS 100U
+
+#define FSM_OVERRUN_MAGIC   0x46534F31UL   // "FSO1"
+
 
 /* =========================================================================
    SECTION: Internal Types
@@ -30,30 +51,143 @@ typedef struct {
     esp_event_loop_handle_t loop;
     fsm_callbacks_t callbacks;
     bool initialized;
+    esp_timer_handle_t budget_timer;
+    int64_t budget_start_us;
+    bool budget_fired;       // timer ran out, grace period running
+    bool budget_expired;     // FSM is cutting this wake short
+    bool sample_pending;     // measured but neither published nor stored
 } fsm_context_t;
 
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t last_elapsed_ms;
+    uint8_t last_state;
+    uint8_t last_hard;
+} fsm_rtc_overrun_t;
+
 /* =========================================================================
    SECTION: Static Data
    ========================================================================= */
 static fsm_context_t s_fsm;
 
+RTC_DATA_ATTR static fsm_rtc_overrun_t s_rtc_overrun;
+
 /* =========================================================================
    SECTION: Helpers
    ========================================================================= */
-static void fsm_shutdown_display(void)
+// Fast boot: a timer wake has nobody pressing a button yet, so buttons are
+// set up after the first measurement instead of before it.
+static bool fsm_buttons_deferred(void)
+{
+#if CONFIG_APP_FAST_BOOT
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+#else
+    return false;
+#endif
+}
+
+// Interactive states and connected sleep have their own timeouts; only the
+// measurement cycle is bounded.
+static bool fsm_state_is_budgeted(app_state_t state)
+{
+    switch (state) {
+        case STATE_CALIB_SOIL_DRY:
+        case STATE_CALIB_SOIL_WET:
+        case STATE_PROVISIONING:
+        case STATE_FACTORY_RESET:
+        case STATE_CONNECTED_SLEEP:
+            return false;
+        default:
+            return true;
+    }
+}
+
+static void fsm_wake_budget_start(void)
+{
+    if (s_fsm.budget_timer == NULL) {
+        return;
+    }
+
+    (void)esp_timer_stop(s_fsm.budget_timer);
+    s_fsm.budget_fired = false;
+    s_fsm.budget_expired = false;
+    s_fsm.budget_start_us = esp_timer_get_time();
+    (void)esp_timer_start_once(s_fsm.budget_timer, (uint64_t)CONFIG_APP_WAKE_BUDGET_MS * 1000ULL);
+}
+
+static void fsm_wake_budget_stop(void)
+{
+    if (s_fsm.budget_timer != NULL) {
+        (void)esp_timer_stop(s_fsm.budget_timer);
+    }
+    s_fsm.budget_fired = false;
+}
+
+static void fsm_record_overrun(app_state_t state, bool hard)
+{
+    const uint32_t elapsed_ms = (uint32_t)((esp_timer_get_time() - s_fsm.budget_start_us) / 1000);
+
+    if (s_rtc_overrun.magic != FSM_OVERRUN_MAGIC) {
+        memset(&s_rtc_overrun, 0, sizeof(s_rtc_overrun));
+        s_rtc_overrun.magic = FSM_OVERRUN_MAGIC;
+    }
+    // A hard stop after a soft one is the same overrun.
+    if (!s_fsm.budget_expired) {
+        s_rtc_overrun.count++;
+    }
+    s_rtc_overrun.last_state = (uint8_t)state;
+    s_rtc_overrun.last_elapsed_ms = elapsed_ms;
+    s_rtc_overrun.last_hard = hard ? 1U : 0U;
+
+    ESP_LOGW(TAG, "wake budget expired in %s after %u ms%s",
+             app_state_str(state), (unsigned)elapsed_ms, hard ? ", forcing sleep" : "");
+    APP_RLOG(WAKE_OVERRUN, state, elapsed_ms, hard ? 1U : 0U);
+}
+
+// Same record FLASH_STORE writes; used when the FSM task cannot get there.
+// Runs on the esp_timer task, so the store is skipped rather than racing the
+// FSM or MQTT task mid-update of the sample ring.
+static void fsm_store_pending_sample(void)
+{
+    if (!power_manager_flash_write_allowed()) {
+        return;
+    }
+
+    sensor_sample_t sample = {0};
+    (void)app_context_get_sensor_data(&sample.data);
+    (void)app_context_get_sensor_stats(&sample.stats);
+    if (app_context_is_time_synced() || wifi_manager_time_is_valid()) {
+        sample.timestamp = (uint32_t)time(NULL);
+    }
+    if (nvs_manager_try_store_sample(&sample, FSM_HARD_STORE_LOCK_MS) == ESP_ERR_TIMEOUT) {
+        ESP_LOGW(TAG, "sample ring busy, pending sample dropped");
+    }
+}
+
+static void fsm_wake_budget_cb(void *arg)
 {
-    ssd1306_handle_t disp = app_context_get_display_handle();
-    i2c_master_bus_handle_t bus = app_context_get_display_bus();
+    (void)arg;
 
-    if (disp) {
-        (void)ssd1306_power_off(disp);
-        ssd1306_destroy(disp);
-        (void)app_context_set_display_handle(NULL);
+    if (!s_fsm.budget_fired) {
+        s_fsm.budget_fired = true;
+        (void)esp_timer_start_once(s_fsm.budget_timer, (uint64_t)FSM_WAKE_GRACE_MS * 1000ULL);
+        (void)fsm_manager_post_event(APP_EVENT_WAKE_BUDGET_EXPIRED, NULL, 0, 0);
+        return;
     }
-    if (bus) {
-        (void)bsp_i2c_del_bus(bus);
-        (void)app_context_set_display_bus(NULL);
+
+    // The FSM task is blocked (driver call, full queue), so sleep from here.
+    const app_state_t state = s_fsm.state;
+    fsm_record_overrun(state, true);
+    if (s_fsm.sample_pending && (state != STATE_FLASH_STORE)) {
+        fsm_store_pending_sample();
     }
+
+    power_manager_note_wake_end();
+    (void)esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    (void)buttons_manager_enable_deep_sleep_wakeup();
+    (void)esp_sleep_enable_timer_wakeup((uint64_t)power_manager_get_sleep_s() * 1000000ULL);
+    esp_deep_sleep_start();
 }
 
 static const char *fsm_event_str(app_event_id_t event_id)
@@ -75,6 +209,9 @@ static const char *fsm_event_str(app_event_id_t event_id)
         case APP_EVENT_MQTT_PUBLISHED: return "MQTT_PUBLISHED";
         case APP_EVENT_STORAGE_SAVED: return "STORAGE_SAVED";
         case APP_EVENT_IDLE_TIMEOUT: return "IDLE_TIMEOUT";
+        case APP_EVENT_IDLE_STAY_CONNECTED: return "IDLE_STAY_CONNECTED";
+        case APP_EVENT_SAMPLE_TIMER: return "SAMPLE_TIMER";
+        case APP_EVENT_WAKE_BUDGET_EXPIRED: return "WAKE_BUDGET_EXPIRED";
         case APP_EVENT_BTN1_SHORT: return "BTN1_SHORT";
         case APP_EVENT_BTN1_3S: return "BTN1_3S";
         case APP_EVENT_BTN1_10S: return "BTN1_10S";
@@ -149,6 +286,11 @@ static void fsm_invoke_entry_action(app_state_t state)
                 s_fsm.callbacks.idle.on_enter();
             }
             break;
+        case STATE_CONNECTED_SLEEP:
+            if (s_fsm.callbacks.connected_sleep.on_enter) {
+                s_fsm.callbacks.connected_sleep.on_enter();
+            }
+            break;
         case STATE_DEEP_SLEEP:
             if (s_fsm.callbacks.deep_sleep.on_enter) {
                 s_fsm.callbacks.deep_sleep.on_enter();
@@ -222,6 +364,11 @@ static void fsm_invoke_exit_action(app_state_t state, exit_mode_t mode)
                 s_fsm.callbacks.idle.on_exit(mode);
             }
             break;
+        case STATE_CONNECTED_SLEEP:
+            if (s_fsm.callbacks.connected_sleep.on_exit) {
+                s_fsm.callbacks.connected_sleep.on_exit(mode);
+            }
+            break;
         case STATE_DEEP_SLEEP:
             if (s_fsm.callbacks.deep_sleep.on_exit) {
                 s_fsm.callbacks.deep_sleep.on_exit(mode);
@@ -242,6 +389,16 @@ static void fsm_transition_internal(app_state_t next_state, const char *reason,
     exit_mode_t mode = force ? EXIT_MODE_INTERRUPTED : EXIT_MODE_DEFAULT;
     fsm_invoke_exit_action(s_fsm.state, mode);
     ESP_LOGI(TAG, "State %s -> %s (%s)", app_state_str(s_fsm.state), app_state_str(next_state), reason);
+    APP_RLOG(FSM_TRANSITION, s_fsm.state, next_state, 0);
+
+    const bool was_budgeted = fsm_state_is_budgeted(s_fsm.state);
+    const bool is_budgeted = fsm_state_is_budgeted(next_state);
+    if (!was_budgeted && is_budgeted) {
+        fsm_wake_budget_start();
+    } else if (was_budgeted && !is_budgeted) {
+        fsm_wake_budget_stop();
+    }
+
     s_fsm.state = next_state;
     fsm_invoke_entry_action(next_state);
 }
@@ -256,17 +413,43 @@ static void fsm_transition_force(app_state_t next_state, const char *reason)
     fsm_transition_internal(next_state, reason, true);
 }
 
+static void fsm_handle_wake_budget(void)
+{
+    // Stale event: the cycle ended or the budget restarted after it was posted.
+    if (!s_fsm.budget_fired || s_fsm.budget_expired || !fsm_state_is_budgeted(s_fsm.state)) {
+        return;
+    }
+
+    fsm_record_overrun(s_fsm.state, false);
+    s_fsm.budget_expired = true;
+
+    app_context_release_display();
+    (void)mqtt_manager_stop();
+    wifi_manager_stop();
+
+    if (s_fsm.sample_pending && (s_fsm.state != STATE_FLASH_STORE)) {
+        fsm_transition_force(STATE_FLASH_STORE, "wake budget, store");
+    } else {
+        fsm_transition_force(STATE_DEEP_SLEEP, "wake budget");
+    }
+}
+
 static bool fsm_handle_global_interrupts(app_event_id_t event_id)
 {
+    if (event_id == APP_EVENT_WAKE_BUDGET_EXPIRED) {
+        fsm_handle_wake_budget();
+        return true;
+    }
+
     if (event_id == APP_EVENT_BTN1_10S) {
-        fsm_shutdown_display();
+        app_context_release_display();
         (void)mqtt_manager_stop();
         fsm_transition_force(STATE_FACTORY_RESET, "button 10s");
         return true;
     }
 
     if (event_id == APP_EVENT_BTN1_3S) {
-        fsm_shutdown_display();
+        app_context_release_display();
         (void)mqtt_manager_stop();
         fsm_transition(STATE_PROVISIONING, "button 3s");
         return true;
@@ -366,6 +549,10 @@ static void fsm_handle_state_sensing(app_event_id_t event_id)
 {
     switch (event_id) {
         case APP_EVENT_SENSORS_DATA_READY:
+            if (buttons_manager_init(s_fsm.loop) != ESP_OK) {   // no-op unless deferred
+                ESP_LOGW(TAG, "deferred buttons init failed");
+            }
+            s_fsm.sample_pending = true;
             fsm_transition(STATE_WIFI_CONNECT, "sensing done");
             break;
         default:
@@ -396,6 +583,7 @@ static void fsm_handle_state_mqtt_publish(app_event_id_t event_id)
 {
     switch (event_id) {
         case APP_EVENT_MQTT_PUBLISHED:
+            s_fsm.sample_pending = false;
             fsm_transition(STATE_IDLE, "mqtt published");
             break;
         case APP_EVENT_DECISION_STORAGE:
@@ -414,7 +602,12 @@ static void fsm_handle_state_flash_store(app_event_id_t event_id)
 {
     switch (event_id) {
         case APP_EVENT_STORAGE_SAVED:
-            fsm_transition(STATE_IDLE, "storage saved");
+            s_fsm.sample_pending = false;
+            if (s_fsm.budget_expired) {
+                fsm_transition(STATE_DEEP_SLEEP, "stored after wake budget");
+            } else {
+                fsm_transition(STATE_IDLE, "storage saved");
+            }
             break;
         default:
             ESP_LOGW(TAG, "FLASH_STORE ignoring event %s", fsm_event_str(event_id));
@@ -428,12 +621,30 @@ static void fsm_handle_state_idle(app_event_id_t event_id)
         case APP_EVENT_IDLE_TIMEOUT:
             fsm_transition(STATE_DEEP_SLEEP, "idle timeout");
             break;
+        case APP_EVENT_IDLE_STAY_CONNECTED:
+            fsm_transition(STATE_CONNECTED_SLEEP, "short interval");
+            break;
         default:
             ESP_LOGW(TAG, "IDLE ignoring event %s", fsm_event_str(event_id));
             break;
     }
 }
 
+static void fsm_handle_state_connected_sleep(app_event_id_t event_id)
+{
+    switch (event_id) {
+        case APP_EVENT_SAMPLE_TIMER:
+            fsm_transition(STATE_SENSING, "sample timer");
+            break;
+        case APP_EVENT_WIFI_DISCONNECTED:
+            fsm_transition(STATE_IDLE, "link lost");
+            break;
+        default:
+            ESP_LOGW(TAG, "CONN_SLEEP ignoring event %s", fsm_event_str(event_id));
+            break;
+    }
+}
+
 static void fsm_handle_state_factory_reset(app_event_id_t event_id)
 {
     switch (event_id) {
@@ -483,6 +694,9 @@ static void fsm_dispatch_event(app_event_id_t event_id)
         case STATE_IDLE:
             fsm_handle_state_idle(event_id);
             break;
+        case STATE_CONNECTED_SLEEP:
+            fsm_handle_state_connected_sleep(event_id);
+            break;
         case STATE_DEEP_SLEEP:
             ESP_LOGW(TAG, "DEEP_SLEEP ignoring event %s", fsm_event_str(event_id));
             break;
@@ -546,13 +760,26 @@ esp_err_t fsm_manager_init(const fsm_callbacks_t *callbacks)
         return err;
     }
 
-    err = buttons_manager_init(s_fsm.loop);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Buttons manager init failed (%s)", esp_err_to_name(err));
-        return err;
+    if (!fsm_buttons_deferred()) {
+        err = buttons_manager_init(s_fsm.loop);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Buttons manager init failed (%s)", esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    const esp_timer_create_args_t budget_args = {
+        .callback = fsm_wake_budget_cb,
+        .name = "wake_budget",
+    };
+    if (esp_timer_create(&budget_args, &s_fsm.budget_timer) != ESP_OK) {
+        ESP_LOGW(TAG, "wake budget timer unavailable, wakes are unbounded");
+        s_fsm.budget_timer = NULL;
     }
 
     s_fsm.initialized = true;
+    app_boot_profile_mark(APP_BOOT_MARK_FSM_READY);
+    fsm_wake_budget_start();
     fsm_invoke_entry_action(STATE_INIT);
     ESP_LOGI(TAG, "FSM initialized, state %s", app_state_str(s_fsm.state));
     return ESP_OK;
@@ -590,3 +817,21 @@ esp_err_t fsm_manager_set_callbacks(const fsm_callbacks_t *callbacks)
     s_fsm.callbacks = *callbacks;
     return ESP_OK;
 }
+
+esp_err_t fsm_manager_get_overrun(fsm_overrun_info_t *out_info)
+{
+    if (out_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(out_info, 0, sizeof(*out_info));
+    if (s_rtc_overrun.magic != FSM_OVERRUN_MAGIC) {
+        return ESP_OK;
+    }
+
+    out_info->count = s_rtc_overrun.count;
+    out_info->last_state = (app_state_t)s_rtc_overrun.last_state;
+    out_info->last_elapsed_ms = s_rtc_overrun.last_elapsed_ms;
+    out_info->last_hard = (s_rtc_overrun.last_hard != 0U);
+    return ESP_OK;
+}
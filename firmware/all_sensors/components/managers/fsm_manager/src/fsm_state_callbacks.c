@@ -52,6 +52,10 @@ static const fsm_callbacks_t s_state_callbacks = {
         .on_enter = state_idle_on_enter,
         .on_exit = state_idle_on_exit,
     },
+    .connected_sleep = {
+        .on_enter = state_connected_sleep_on_enter,
+        .on_exit = state_connected_sleep_on_exit,
+    },
     .deep_sleep = {
         .on_enter = state_deep_sleep_on_enter,
         .on_exit = state_deep_sleep_on_exit,
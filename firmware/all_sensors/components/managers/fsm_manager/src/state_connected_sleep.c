@@ -0,0 +1,79 @@
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "app_context.h"
+#include "fsm_manager.h"
+#include "wifi_manager.h"
+#include "mqtt_manager.h"
+#include "power_manager.h"
+#include "fsm_state_callbacks.h"
+
+static const char *TAG = "STATE_CONN_SLEEP";
+static esp_timer_handle_t s_sample_timer;
+static volatile bool s_sample_due;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void sample_timer_cb(void *arg)
+{
+    (void)arg;
+    s_sample_due = true;
+    (void)fsm_manager_post_event(APP_EVENT_SAMPLE_TIMER, NULL, 0, 0);
+}
+
+static esp_err_t sample_timer_start(uint32_t sleep_s)
+{
+    if (s_sample_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = sample_timer_cb,
+            .name = "sample_timer",
+        };
+        esp_err_t err = esp_timer_create(&args, &s_sample_timer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    (void)esp_timer_stop(s_sample_timer);
+    return esp_timer_start_once(s_sample_timer, (uint64_t)sleep_s * 1000000ULL);
+}
+
+/* =========================================================================
+   SECTION: Callbacks
+   ========================================================================= */
+void state_connected_sleep_on_enter(void)
+{
+    ESP_LOGI(TAG, "enter");
+
+    s_sample_due = false;
+    const uint32_t sleep_s = power_manager_get_sleep_s();
+    if (sample_timer_start(sleep_s) != ESP_OK) {
+        ESP_LOGE(TAG, "sample timer failed, falling back to deep sleep");
+        (void)fsm_manager_post_event(APP_EVENT_WIFI_DISCONNECTED, NULL, 0, 0);
+        return;
+    }
+
+    // Modem sleep lets the CPU drop into light sleep between beacons; the
+    // MQTT keepalive and the sample timer wake it up.
+    (void)wifi_manager_set_power_save(true);
+    (void)power_manager_light_sleep_enable();
+    ESP_LOGI(TAG, "next sample in %us", (unsigned)sleep_s);
+}
+
+void state_connected_sleep_on_exit(exit_mode_t mode)
+{
+    if (s_sample_timer) {
+        (void)esp_timer_stop(s_sample_timer);
+    }
+    (void)power_manager_light_sleep_disable();
+    (void)wifi_manager_set_power_save(false);
+
+    // Anything but the sample timer (buttons, link loss) leaves the connected cycle.
+    if (mode == EXIT_MODE_INTERRUPTED || !s_sample_due) {
+        (void)mqtt_manager_stop();
+        wifi_manager_stop();
+    }
+    s_sample_due = false;
+    ESP_LOGI(TAG, "exit");
+}
@@ -1,10 +1,10 @@
 #include <time.h>
 #include "esp_log.h"
 #include "esp_sleep.h"
-#include "bsp_init.h"
-#include "ssd1306.h"
 #include "app_context.h"
+#include "app_bus_trace.h"
 #include "buttons_manager.h"
+#include "power_manager.h"
 #include "fsm_state_callbacks.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -18,31 +18,13 @@ void state_deep_sleep_on_enter(void)
 {
     ESP_LOGI(TAG, "enter");
 
-   
+    const uint32_t sleep_s = power_manager_get_sleep_s();
 
-    config_t cfg = {0};
-    if (app_context_get_config(&cfg) != ESP_OK) {
-        memset(&cfg, 0, sizeof(cfg));
-    }
-
-    uint32_t sleep_s = cfg.sleep_duration;
-    if (sleep_s == 0U) {
-        sleep_s = 60U;
-    }
+    app_context_release_display();
 
-    ssd1306_handle_t disp = app_context_get_display_handle();
-    i2c_master_bus_handle_t bus = app_context_get_display_bus();
-
-    if (disp) {
-        (void)ssd1306_power_off(disp);
-        ssd1306_destroy(disp);
-        (void)app_context_set_display_handle(NULL);
-    }
-    if (bus) {
-        (void)bsp_i2c_del_bus(bus);
-        (void)app_context_set_display_bus(NULL);
-    }
+    app_bus_trace_report();
 
+    power_manager_note_wake_end();
     ESP_LOGI(TAG, "deep sleep %us", (unsigned)sleep_s);
     esp_err_t err = esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
     if (err != ESP_OK) {
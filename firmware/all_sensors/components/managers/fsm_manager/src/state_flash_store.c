@@ -2,6 +2,8 @@
 #include "esp_log.h"
 #include "app_context.h"
 #include "nvs_manager.h"
+#include "wifi_manager.h"
+#include "power_manager.h"
 #include "fsm_manager.h"
 #include "fsm_state_callbacks.h"
 
@@ -14,12 +16,21 @@ void state_flash_store_on_enter(void)
 {
     ESP_LOGI(TAG, "enter");
 
+    if (!power_manager_flash_write_allowed()) {
+        // A brown-out mid-write costs more than the sample.
+        ESP_LOGW(TAG, "battery too low, sample dropped");
+        (void)fsm_manager_post_event(APP_EVENT_STORAGE_SAVED, NULL, 0, 0);
+        return;
+    }
+
     sensor_data_t data = {0};
     (void)app_context_get_sensor_data(&data);
 
     sensor_sample_t sample = {0};
     sample.data = data;
-    if (app_context_is_time_synced()) {
+    (void)app_context_get_sensor_stats(&sample.stats);
+    // RTC-kept time is good enough for offline samples even when a resync is due.
+    if (app_context_is_time_synced() || wifi_manager_time_is_valid()) {
         sample.timestamp = (uint32_t)time(NULL);
     }
 
@@ -1,11 +1,10 @@
 #include "esp_log.h"
 #include "esp_timer.h"
-#include "bsp_init.h"
-#include "ssd1306.h"
 #include "app_context.h"
 #include "fsm_manager.h"
 #include "wifi_manager.h"
 #include "mqtt_manager.h"
+#include "power_manager.h"
 #include "fsm_state_callbacks.h"
 
 /* =========================================================================
@@ -48,22 +47,6 @@ static void idle_timer_stop(void)
     }
 }
 
-static void idle_shutdown_display(void)
-{
-    ssd1306_handle_t disp = app_context_get_display_handle();
-    i2c_master_bus_handle_t bus = app_context_get_display_bus();
-
-    if (disp) {
-        (void)ssd1306_power_off(disp);
-        ssd1306_destroy(disp);
-        (void)app_context_set_display_handle(NULL);
-    }
-    if (bus) {
-        (void)bsp_i2c_del_bus(bus);
-        (void)app_context_set_display_bus(NULL);
-    }
-}
-
 /* =========================================================================
    SECTION: Callbacks
    ========================================================================= */
@@ -71,9 +54,17 @@ void state_idle_on_enter(void)
 {
     ESP_LOGI(TAG, "enter");
 
+    // Short intervals: keep the link and MQTT session, light sleep until the next sample.
+    if (app_context_is_wifi_connected() &&
+        power_manager_select_mode(power_manager_get_interval_s()) == POWER_MODE_CONNECTED) {
+        app_context_release_display();
+        (void)fsm_manager_post_event(APP_EVENT_IDLE_STAY_CONNECTED, NULL, 0, 0);
+        return;
+    }
+
     (void)mqtt_manager_stop();
     wifi_manager_stop();
-    idle_shutdown_display();
+    app_context_release_display();
 
     idle_timer_start();
 }
@@ -1,12 +1,15 @@
+#include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "esp_sleep.h"
 #include "nvs_manager.h"
-#include "bsp_init.h"
-#include "ssd1306.h"
 #include "fsm_manager.h"
 #include "app_context.h"
+#include "app_display.h"
+#include "wifi_manager.h"
+#include "power_manager.h"
 #include "fsm_state_callbacks.h"
 
 static const char *TAG = "STATE_INIT";
@@ -18,34 +21,30 @@ static void maybe_teardown_display(exit_mode_t mode)
         return;
     }
 
-    ssd1306_handle_t disp = app_context_get_display_handle();
-    i2c_master_bus_handle_t bus = app_context_get_display_bus();
-
-    if (disp) {
-        ssd1306_destroy(disp);
-        (void)app_context_set_display_handle(NULL);
-    }
-    if (bus) {
-        (void)bsp_i2c_del_bus(bus);
-        (void)app_context_set_display_bus(NULL);
-    }
+    app_context_release_display();
 }
 
 static void init_display_show(const char *line1, const char *line2)
 {
-    ssd1306_handle_t disp = app_context_ensure_display();
-    if (disp == NULL) {
+#if CONFIG_APP_FAST_BOOT
+    // Bringing up the panel for a splash nobody sees costs more than the sample.
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER) {
+        return;
+    }
+#endif
+    if (!power_manager_display_allowed()) {
         return;
     }
 
-    (void)ssd1306_clear(disp);
+    // Panel bring-up alone takes tens of ms; the display task does it off the boot path.
+    app_display_frame_t frame = {0};
     if (line1 != NULL) {
-        (void)ssd1306_draw_text(disp, line1, 0, 0);
+        (void)snprintf(frame.line[0], sizeof(frame.line[0]), "%s", line1);
     }
     if (line2 != NULL) {
-        (void)ssd1306_draw_text(disp, line2, 0, 2);
+        (void)snprintf(frame.line[1], sizeof(frame.line[1]), "%s", line2);
     }
-    (void)ssd1306_flush(disp);
+    (void)app_display_show(&frame);
 }
 
 /* =========================================================================
@@ -53,6 +52,8 @@ static void init_display_show(const char *line1, const char *line2)
    ========================================================================= */
 void state_init_on_enter(void)
 {
+    // Clock survives deep sleep; decides whether this wake needs SNTP.
+    (void)wifi_manager_time_restore();
     time_t now = time(NULL);
     ESP_LOGI(TAG, "wakeup reason=%d ts=%ld", (int)esp_sleep_get_wakeup_cause(), (long)now);
 
@@ -70,6 +71,10 @@ void state_init_on_enter(void)
 
     if (has_cfg) {
         (void)app_context_set_config(&cfg);
+        int32_t slot_s = -1;
+        if (nvs_manager_load_upload_slot(&slot_s) == ESP_OK) {
+            app_context_set_upload_slot(slot_s);
+        }
         size_t ssid_len = strnlen(cfg.ssid, sizeof(cfg.ssid));
         size_t pass_len = strnlen(cfg.passwd, sizeof(cfg.passwd));
         ESP_LOGI(TAG, "wifi ssid=%.*s passwd=%.*s",
@@ -1,61 +1,40 @@
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
-#include "ssd1306.h"
 #include "bme280_task.h"
 #include "veml7700_task.h"
 #include "soil_sensor_task.h"
+#include "sensor_schedule.h"
+#include "sensor_burst.h"
 #include "bsp_init.h"
+#include "app_boot_profile.h"
 #include "app_context.h"
+#include "app_display.h"
 #include "sensor_task_context.h"
 #include "fsm_manager.h"
+#include "power_manager.h"
 #include "fsm_state_callbacks.h"
 
 /* =========================================================================
    SECTION: Helpers
    ========================================================================= */
-static void display_shutdown(void)
-{
-    ssd1306_handle_t disp = app_context_get_display_handle();
-    i2c_master_bus_handle_t bus = app_context_get_display_bus();
-
-    if (disp) {
-        (void)ssd1306_power_off(disp);
-        ssd1306_destroy(disp);
-        (void)app_context_set_display_handle(NULL);
-    }
-    if (bus) {
-        (void)bsp_i2c_del_bus(bus);
-        (void)app_context_set_display_bus(NULL);
-    }
-}
-
 static void display_sensor_data(const sensor_data_t *data)
 {
-    if (data == NULL) {
+    if ((data == NULL) || !power_manager_display_allowed()) {
         return;
     }
 
-    ssd1306_handle_t disp = app_context_ensure_display();
-    if (disp == NULL) {
-        return;
-    }
-
-    char line1[24] = {0};
-    char line2[24] = {0};
-    char line3[24] = {0};
-
+    app_display_frame_t frame = {0};
     float temp_c = ((float)data->temperature / 10.0f) - 273.15f;
-    (void)snprintf(line1, sizeof(line1), "Lux:%u Soil:%u%%",
+    (void)snprintf(frame.line[0], sizeof(frame.line[0]), "Lux:%u Soil:%u%%",
                    (unsigned)data->lux_level,
                    (unsigned)data->soil_moisture);
-    (void)snprintf(line2, sizeof(line2), "Temp:%.1fC", temp_c);
-    (void)snprintf(line3, sizeof(line3), "Pres:%.1fhPa", data->pressure);
+    (void)snprintf(frame.line[1], sizeof(frame.line[1]), "Temp:%.1fC", temp_c);
+    const unsigned pres_dhpa = (unsigned)((data->pressure_cpa + 500U) / 1000U);
+    (void)snprintf(frame.line[2], sizeof(frame.line[2]), "Pres:%u.%uhPa", pres_dhpa / 10U, pres_dhpa % 10U);
 
-    (void)ssd1306_clear(disp);
-    (void)ssd1306_draw_text(disp, line1, 0, 0);
-    (void)ssd1306_draw_text(disp, line2, 0, 2);
-    (void)ssd1306_draw_text(disp, line3, 0, 4);
-    (void)ssd1306_flush(disp);
+    // Drawn by the display task; the FSM moves on right away.
+    (void)app_display_show(&frame);
 }
 
 static const char *TAG = "STATE_SENSING";
@@ -66,16 +45,22 @@ static const char *TAG = "STATE_SENSING";
 void state_sensing_on_enter(void)
 {
     ESP_LOGI(TAG, "enter");
+    app_boot_profile_mark(APP_BOOT_MARK_FIRST_SENSOR);
 
+    const sensor_mask_t due = sensor_schedule_begin();
+    sensor_mask_t fresh = 0;
+
+    // Soil-only cycles never touch I2C.
     i2c_master_bus_handle_t bus = app_context_get_sensors_bus();
-    if (bus == NULL) {
-        if (bsp_i2c_create_sensors_bus(&bus) != ESP_OK) {
-            ESP_LOGW(TAG, "sensors bus create failed");
-            (void)fsm_manager_post_event(APP_EVENT_SENSORS_DATA_READY, NULL, 0, 0);
-            return;
+    if ((bus == NULL) && (due & SENSOR_MASK_I2C)) {
+        // Held until deep sleep, so device handles survive connected-mode cycles.
+        if (bsp_i2c_bus_acquire(BSP_I2C_BUS_SENSORS, &bus) == ESP_OK) {
+            (void)app_context_set_sensors_bus(bus);
+            ESP_LOGI(TAG, "sensors bus acquired");
+        } else {
+            ESP_LOGW(TAG, "sensors bus acquire failed");
+            bus = NULL;
         }
-        (void)app_context_set_sensors_bus(bus);
-        ESP_LOGI(TAG, "sensors bus created");
     }
 
     sensor_data_t data = {0};
@@ -84,23 +69,50 @@ void state_sensing_on_enter(void)
         .data = &data,
         .bus = bus,
     };
+    sensor_stats_t stats = {0};
+
+#if CONFIG_APP_SENSOR_BURST_COUNT > 1
+    fresh = sensor_burst_run(&shared, due, CONFIG_APP_SENSOR_BURST_COUNT, &stats);
+#else
+    if ((due & SENSOR_MASK_ENV) && (bus != NULL)) {
+        ESP_LOGI(TAG, "start bme280 sync");
+        if (bme280_read_once(&shared) == ESP_OK) {
+            fresh |= SENSOR_MASK_ENV;
+        } else {
+            ESP_LOGW(TAG, "bme280 sync failed");
+        }
+    }
 
-    ESP_LOGI(TAG, "start bme280 sync");
-    if (bme280_read_once(&shared) != ESP_OK) {
-        ESP_LOGW(TAG, "bme280 sync failed");
+    if ((due & SENSOR_MASK_LUX) && (bus != NULL)) {
+        ESP_LOGI(TAG, "start veml7700 sync");
+        if (veml7700_read_once(&shared) == ESP_OK) {
+            fresh |= SENSOR_MASK_LUX;
+        } else {
+            ESP_LOGW(TAG, "veml7700 sync failed");
+        }
     }
 
-    ESP_LOGI(TAG, "start veml7700 sync");
-    if (veml7700_read_once(&shared) != ESP_OK) {
-        ESP_LOGW(TAG, "veml7700 sync failed");
+    if (due & SENSOR_MASK_SOIL) {
+        ESP_LOGI(TAG, "start soil sync");
+        if (soil_sensor_read_once(&shared) == ESP_OK) {
+            fresh |= SENSOR_MASK_SOIL;
+        } else {
+            ESP_LOGW(TAG, "soil sync failed");
+        }
     }
+#endif
 
-    ESP_LOGI(TAG, "start soil sync");
-    if (soil_sensor_read_once(&shared) != ESP_OK) {
-        ESP_LOGW(TAG, "soil sync failed");
+    // Sampled with the soil probe; on deep-sleep wakes the radio is not up yet.
+    // Not carried over: 0 says it was not measured this cycle.
+    data.battery_mv = 0U;
+    if ((fresh & SENSOR_MASK_SOIL) && (soil_sensor_battery_mv(&data.battery_mv) == ESP_OK)) {
+        power_manager_note_battery(data.battery_mv);
     }
 
+    // Skipped or failed sensors carry their last reading, flagged stale.
+    sensor_schedule_finish(&data, due, fresh);
     (void)app_context_set_sensor_data(&data);
+    (void)app_context_set_sensor_stats(&stats);
     display_sensor_data(&data);
     (void)fsm_manager_post_event(APP_EVENT_SENSORS_DATA_READY, NULL, 0, 0);
 }
@@ -109,5 +121,5 @@ void state_sensing_on_exit(exit_mode_t mode)
 {
     (void)mode;
     ESP_LOGI(TAG, "exit");
-    display_shutdown();
+    (void)app_display_release();
 }
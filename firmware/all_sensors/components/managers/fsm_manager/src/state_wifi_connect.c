@@ -1,5 +1,8 @@
 #include "esp_log.h"
 #include "wifi_manager.h"
+#include "mqtt_manager.h"
+#include "fsm_manager.h"
+#include "power_manager.h"
 #include "fsm_state_callbacks.h"
 
 static const char *TAG = "STATE_WIFI";
@@ -10,6 +13,24 @@ static const char *TAG = "STATE_WIFI";
 void state_wifi_connect_on_enter(void)
 {
     ESP_LOGI(TAG, "enter");
+
+    // Wi-Fi is only needed for the upload; skip the radio while either hop is backing off.
+    const bool skip_wifi = wifi_manager_backoff_should_skip();
+    const bool skip_mqtt = mqtt_manager_backoff_should_skip();
+    if (skip_wifi || skip_mqtt) {
+        ESP_LOGI(TAG, "connectivity backoff (wifi=%d mqtt=%d) -> storage", (int)skip_wifi, (int)skip_mqtt);
+        (void)fsm_manager_post_event(APP_EVENT_WIFI_DISCONNECTED, NULL, 0, 0);
+        return;
+    }
+
+    if (!power_manager_upload_due()) {
+        // Backend asked for fewer uploads; a link kept from connected sleep goes too.
+        (void)mqtt_manager_stop();
+        wifi_manager_stop();
+        (void)fsm_manager_post_event(APP_EVENT_WIFI_DISCONNECTED, NULL, 0, 0);
+        return;
+    }
+
     (void)wifi_manager_start();
 }
 
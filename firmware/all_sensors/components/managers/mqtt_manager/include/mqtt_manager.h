@@ -18,3 +18,7 @@ esp_err_t mqtt_manager_publish_telemetry(void);
 
 // Stop MQTT client and prevent reconnects.
 esp_err_t mqtt_manager_stop(void);
+
+// Call once per wake. True while the broker is considered down after repeated
+// failed wakes; each call counts one skipped wake.
+bool mqtt_manager_backoff_should_skip(void);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_transport.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef struct {
+    uint32_t handshake_ms;        // last handshake, TCP connect excluded
+    uint32_t handshake_tx_bytes;  // TLS records sent during last handshake
+    uint32_t handshake_rx_bytes;  // TLS records received during last handshake
+    bool resumed;                 // last handshake skipped certificate exchange
+    uint32_t full_count;          // full handshakes since power-on
+    uint32_t resumed_count;       // resumed handshakes since power-on
+} mqtt_tls_stats_t;
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Create a TLS 1.2 transport verifying the broker against ca_pem. ca_pem_len
+// includes the NUL terminator, as mbedTLS expects for PEM input.
+// The negotiated session is kept in RTC memory and offered again on the next
+// connect, so later wakes resume instead of doing a full handshake.
+// Ownership of the handle passes to the MQTT client, which destroys it.
+esp_transport_handle_t mqtt_tls_transport_create(const char *ca_pem, size_t ca_pem_len);
+
+// Copy statistics of the most recent handshake.
+esp_err_t mqtt_tls_transport_get_stats(mqtt_tls_stats_t *out_stats);
+
+// Drop the cached session so the next connect does a full handshake.
+void mqtt_tls_transport_forget_session(void);
@@ -1,30 +1,90 @@
+#include <math.h>
 #include <string.h>
 #include <time.h>
 #include <stdint.h>
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_mac.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
 #include "mqtt_client.h"
 #include "cJSON.h"
+#include "mbedtls/base64.h"
 #include "driver/gpio.h"
+#include "app_backoff.h"
+#include "app_boot_profile.h"
+#include "app_rtc_log.h"
 #include "app_context.h"
 #include "app_types.h"
 #include "app_constants.h"
 #include "fsm_manager.h"
 #include "mqtt_manager.h"
 #include "nvs_manager.h"
+#include "power_manager.h"
+#include "mqtt_tls_transport.h"
 
 /* =========================================================================
    SECTION: Constants
    ========================================================================= */
-#define MQTT_BROKER_HOST          "172.20.10.2"
 #define MQTT_BROKER_PORT          1883
+#define MQTT_BROKER_TLS_PORT      8883
 #define MQTT_WATER_GPIO           GPIO_NUM_2
 
 #define MQTT_TOPIC_BUF_LEN        96
 #define MQTT_PAYLOAD_BUF_LEN      256
 #define MQTT_FAIL_WINDOW_US       (30LL * 1000LL * 1000LL)
 #define MQTT_FAIL_THRESHOLD       3
+#define MQTT_PROBE_FAIL_THRESHOLD 1       // while backing off, give up on the first failure
+#define MQTT_BACKOFF_THRESHOLD    2U      // wakes with a failed broker before skipping
+#define MQTT_BACKOFF_MAX_SKIP     32U
+#define MQTT_BACKOFF_UNTIL_MAX_S  4102444800.0  // 2100-01-01; power_manager caps it further
+
+#define MQTT_SESSION_EXPIRY_S     (7U * 24U * 3600U)   // keep subscriptions while asleep
+#define MQTT_TELEMETRY_EXPIRY_S   (7U * 24U * 3600U)   // drop telemetry nobody picked up in a week
+#define MQTT_WATER_STATUS_EXPIRY_S 60U                 // watering status is stale almost immediately
+#define MQTT_DIAG_EXPIRY_S        (24U * 3600U)
+
+// Backlog drain after the live sample is acked. Bounded per wake so a full
+// ring never stretches the wake; the rest goes out on later wakes.
+#define MQTT_DRAIN_CHUNK_N        4       // samples in flight per chunk
+#define MQTT_DRAIN_MAX_PER_WAKE   16      // samples per wake
+#define MQTT_DRAIN_BUDGET_MS      4000    // wall time from live ack to giving up
+
+// RTC log dump on request: records per diag message, 320 B raw / 428 B base64.
+#define MQTT_LOG_DUMP_RECS_PER_MSG 16
+#define MQTT_LOG_DUMP_MAX_RECS    128
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef enum {
+    MQTT_TOPIC_TELEMETRY = 0,
+    MQTT_TOPIC_SETUP,
+    MQTT_TOPIC_CONFIG_CMD,
+    MQTT_TOPIC_WATER_CMD,
+    MQTT_TOPIC_WATER_STATUS,
+    MQTT_TOPIC_DIAG,
+    MQTT_TOPIC_COUNT
+} mqtt_topic_t;
+
+typedef struct {
+    bool active;               // live sample acked, drain running
+    bool finished;             // MQTT_PUBLISHED already posted this wake
+    bool busy;                 // MQTT task is dropping/publishing a chunk
+    const char *deferred;      // budget ran out while busy; finish when done
+    uint32_t sent;             // samples acked and dropped this wake
+    uint32_t chunk_end_seq;    // drop samples below this once chunk is acked
+    size_t chunk_len;
+    size_t chunk_acked;
+    int chunk_msg_ids[MQTT_DRAIN_CHUNK_N];
+} mqtt_drain_t;
+
+typedef struct {
+    const char *suffix;        // part after devices/<uuid>/
+    uint16_t alias;            // MQTT 5 topic alias for QoS 0 publishes, 0 = none
+    uint32_t expiry_s;         // message expiry interval, 0 = none
+} mqtt_topic_desc_t;
 
 /* =========================================================================
    SECTION: Static Data
@@ -33,13 +93,38 @@ static const char *TAG = "MQTT_MGR";
 static esp_mqtt_client_handle_t s_client = NULL;
 static bool s_subscribed = false;
 static bool s_publish_pending = false;
-static int s_last_pub_id = -1;
+static int s_live_msg_id = -1;
 static char s_uuid[13] = {0};
 static uint32_t s_device_id = 0;
 static char s_mqtt_pass[33] = {0};
 static int s_mqtt_fail_count = 0;
 static int64_t s_mqtt_fail_window_start_us = 0;
 static uint32_t s_mqtt_msg_counter = 0;
+static bool s_alias_bound[MQTT_TOPIC_COUNT] = {0};
+static mqtt_drain_t s_drain = {0};
+static esp_timer_handle_t s_drain_timer = NULL;
+static portMUX_TYPE s_drain_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_boot_diag_sent = false;
+static app_rtc_log_rec_t s_log_dump[MQTT_LOG_DUMP_MAX_RECS];
+
+// Broker health across wakes; per-wake failures above feed into it.
+RTC_DATA_ATTR static app_backoff_t s_rtc_backoff;
+RTC_DATA_ATTR static uint32_t s_rtc_overruns_reported;
+
+#if CONFIG_APP_MQTT_USE_TLS
+extern const char s_ca_crt_start[] asm("_binary_ca_crt_start");
+extern const char s_ca_crt_end[] asm("_binary_ca_crt_end");
+#endif
+
+// Only QoS 0 publishes are aliased, which leaves diag; Mosquitto allows 10 per client by default.
+static const mqtt_topic_desc_t s_topics[MQTT_TOPIC_COUNT] = {
+    [MQTT_TOPIC_TELEMETRY]    = { "telemetry",       0U, MQTT_TELEMETRY_EXPIRY_S },
+    [MQTT_TOPIC_SETUP]        = { "setup",           0U, 0U },
+    [MQTT_TOPIC_CONFIG_CMD]   = { "config/cmd",      0U, 0U },
+    [MQTT_TOPIC_WATER_CMD]    = { "watering/cmd",    0U, 0U },
+    [MQTT_TOPIC_WATER_STATUS] = { "watering/status", 0U, MQTT_WATER_STATUS_EXPIRY_S },
+    [MQTT_TOPIC_DIAG]         = { "diag",            1U, MQTT_DIAG_EXPIRY_S },
+};
 
 /* =========================================================================
    SECTION: Helpers
@@ -58,20 +143,15 @@ static void mqtt_build_uuid(void)
     s_device_id = ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | (uint32_t)mac[5];
 }
 
-static void mqtt_build_topics(char *telemetry, size_t telemetry_len,
-                              char *setup, size_t setup_len,
-                              char *cfg_cmd, size_t cfg_cmd_len,
-                              char *water_cmd, size_t water_cmd_len,
-                              char *water_status, size_t water_status_len,
-                              char *hard_reset, size_t hard_reset_len)
+static void mqtt_build_topic(mqtt_topic_t topic, char *out_topic, size_t out_len)
 {
     mqtt_build_uuid();
-    (void)snprintf(telemetry, telemetry_len, "devices/%s/telemetry", s_uuid);
-    (void)snprintf(setup, setup_len, "devices/%s/setup", s_uuid);
-    (void)snprintf(cfg_cmd, cfg_cmd_len, "devices/%s/config/cmd", s_uuid);
-    (void)snprintf(water_cmd, water_cmd_len, "devices/%s/watering/cmd", s_uuid);
-    (void)snprintf(water_status, water_status_len, "devices/%s/watering/status", s_uuid);
+    (void)snprintf(out_topic, out_len, "devices/%s/%s", s_uuid, s_topics[topic].suffix);
+}
 
+static void mqtt_reset_aliases(void)
+{
+    memset(s_alias_bound, 0, sizeof(s_alias_bound));
 }
 
 static void mqtt_gpio_init(void)
@@ -87,21 +167,70 @@ static void mqtt_gpio_init(void)
     gpio_set_level(MQTT_WATER_GPIO, 0);
 }
 
-static esp_err_t mqtt_publish_json(const char *topic, const char *payload, int qos)
+#ifdef CONFIG_MQTT_PROTOCOL_5
+// Attach alias/expiry to the next publish. Returns the topic string to put on
+// the wire. An alias only means something on the connection that set it up,
+// and QoS 1 publishes sit in the outbox and are resent byte for byte after a
+// reconnect (persistent session). An alias on those would either be dead
+// weight next to the full topic or, alias-only, be refused on the new
+// connection, so QoS 1 never carries one. QoS 0 ones, never resent, go out
+// alias-only once bound on this connection. *out_aliased tells whether the
+// alias went on this publish.
+static const char *mqtt_prepare_publish_properties(mqtt_topic_t topic, const char *full_topic, int qos,
+                                                   bool *out_aliased)
+{
+    const mqtt_topic_desc_t *desc = &s_topics[topic];
+    esp_mqtt5_publish_property_config_t props = {
+        .message_expiry_interval = desc->expiry_s,
+        .topic_alias = (qos == 0) ? desc->alias : 0U,
+    };
+
+    if (esp_mqtt5_client_set_publish_property(s_client, &props) != ESP_OK) {
+        // Broker granted fewer aliases than we use; publish with the full topic only.
+        props.topic_alias = 0;
+        (void)esp_mqtt5_client_set_publish_property(s_client, &props);
+        return full_topic;
+    }
+
+    *out_aliased = (props.topic_alias != 0U);
+    if (!*out_aliased || !s_alias_bound[topic]) {
+        return full_topic;
+    }
+    return "";
+}
+#endif
+
+static esp_err_t mqtt_publish_json(mqtt_topic_t topic, const char *payload, int qos, int *out_msg_id)
 {
-    if ((s_client == NULL) || (topic == NULL) || (payload == NULL)) {
+    if ((s_client == NULL) || (topic >= MQTT_TOPIC_COUNT) || (payload == NULL)) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGI(TAG, "publishing topic=%s qos=%d payload=%s", topic, qos, payload);
-    int msg_id = esp_mqtt_client_publish(s_client, topic, payload, 0, qos, 0);
+    char full_topic[MQTT_TOPIC_BUF_LEN] = {0};
+    mqtt_build_topic(topic, full_topic, sizeof(full_topic));
+
+    const char *wire_topic = full_topic;
+    bool aliased = false;
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    wire_topic = mqtt_prepare_publish_properties(topic, full_topic, qos, &aliased);
+#endif
+
+    ESP_LOGD(TAG, "publishing topic=%s%s qos=%d payload=%s",
+             full_topic, (wire_topic[0] == '\0') ? " (alias)" : "", qos, payload);
+    int msg_id = esp_mqtt_client_publish(s_client, wire_topic, payload, 0, qos, 0);
     if (msg_id < 0) {
-        ESP_LOGW(TAG, "publish failed topic=%s", topic);
+        ESP_LOGW(TAG, "publish failed topic=%s", full_topic);
         return ESP_FAIL;
     }
 
-    s_last_pub_id = msg_id;
-    ESP_LOGI(TAG, "publish queued msg_id=%d", msg_id);
+    if (aliased) {
+        s_alias_bound[topic] = true;
+    }
+    if (out_msg_id != NULL) {
+        *out_msg_id = msg_id;
+    }
+    ESP_LOGD(TAG, "publish queued msg_id=%d", msg_id);
+    APP_RLOG(MQTT_PUBLISH, topic, strlen(payload), msg_id);
     return ESP_OK;
 }
 
@@ -116,19 +245,150 @@ static double mqtt_next_timestamp_ms(uint32_t unix_ts)
     return ts;
 }
 
-static void mqtt_publish_watering_status(int water_on)
+// Best-effort device diagnostics, sent once the live sample is acked. QoS 0 so
+// it never delays the upload.
+static void mqtt_publish_diagnostics(void)
 {
-    char topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy1[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy2[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy3[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy4[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy5[MQTT_TOPIC_BUF_LEN] = {0};
-    mqtt_build_topics(dummy1, sizeof(dummy1), dummy2, sizeof(dummy2), dummy3, sizeof(dummy3), dummy4, sizeof(dummy4), topic, sizeof(topic), dummy5, sizeof(dummy5));
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return;
+    }
 
+    bool has_data = false;
+#if CONFIG_APP_MQTT_USE_TLS
+    mqtt_tls_stats_t tls_stats = {0};
+    cJSON *tls = cJSON_AddObjectToObject(root, "tls");
+    if ((tls != NULL) && (mqtt_tls_transport_get_stats(&tls_stats) == ESP_OK)) {
+        cJSON_AddNumberToObject(tls, "ms", (double)tls_stats.handshake_ms);
+        cJSON_AddNumberToObject(tls, "tx", (double)tls_stats.handshake_tx_bytes);
+        cJSON_AddNumberToObject(tls, "rx", (double)tls_stats.handshake_rx_bytes);
+        cJSON_AddNumberToObject(tls, "res", tls_stats.resumed ? 1 : 0);
+        cJSON_AddNumberToObject(tls, "full", (double)tls_stats.full_count);
+        cJSON_AddNumberToObject(tls, "resumed", (double)tls_stats.resumed_count);
+        has_data = true;
+    }
+#endif
+
+    // Boot breakdown, once per boot; connected-sleep cycles do not reboot.
+    const uint32_t sensor_ms = app_boot_profile_get_ms(APP_BOOT_MARK_FIRST_SENSOR);
+    cJSON *boot = (!s_boot_diag_sent && (sensor_ms != 0U)) ? cJSON_AddObjectToObject(root, "boot") : NULL;
+    if (boot != NULL) {
+        cJSON_AddNumberToObject(boot, "pre", (double)app_boot_profile_get_pre_app_ms());
+        cJSON_AddNumberToObject(boot, "main", (double)app_boot_profile_get_ms(APP_BOOT_MARK_APP_MAIN));
+        cJSON_AddNumberToObject(boot, "nvs", (double)app_boot_profile_get_ms(APP_BOOT_MARK_NVS_READY));
+        cJSON_AddNumberToObject(boot, "fsm", (double)app_boot_profile_get_ms(APP_BOOT_MARK_FSM_READY));
+        cJSON_AddNumberToObject(boot, "sen", (double)sensor_ms);
+        s_boot_diag_sent = true;
+        has_data = true;
+    }
+
+    // Wake budget overruns since the last report; the count itself never resets.
+    fsm_overrun_info_t ovr = {0};
+    if ((fsm_manager_get_overrun(&ovr) == ESP_OK) && (ovr.count != s_rtc_overruns_reported)) {
+        cJSON *ovr_obj = cJSON_AddObjectToObject(root, "ovr");
+        if (ovr_obj != NULL) {
+            cJSON_AddNumberToObject(ovr_obj, "cnt", (double)ovr.count);
+            cJSON_AddStringToObject(ovr_obj, "st", app_state_str(ovr.last_state));
+            cJSON_AddNumberToObject(ovr_obj, "ms", (double)ovr.last_elapsed_ms);
+            cJSON_AddNumberToObject(ovr_obj, "hard", ovr.last_hard ? 1 : 0);
+            s_rtc_overruns_reported = ovr.count;
+            has_data = true;
+        }
+    }
+
+    char *json = has_data ? cJSON_PrintUnformatted(root) : NULL;
+    if (json != NULL) {
+        (void)mqtt_publish_json(MQTT_TOPIC_DIAG, json, 0, NULL);
+        cJSON_free(json);
+    }
+    cJSON_Delete(root);
+}
+
+static void mqtt_publish_watering_status(int water_on)
+{
     char payload[64] = {0};
     (void)snprintf(payload, sizeof(payload), "{\"water\":%d}", water_on ? 1 : 0);
-    (void)mqtt_publish_json(topic, payload, 1);
+    (void)mqtt_publish_json(MQTT_TOPIC_WATER_STATUS, payload, 1, NULL);
+}
+
+// Ships the binary RTC log to the diag topic as base64 parts:
+// {"log":{"v":1,"part":i,"parts":n,"d":"..."}}. Decode with scripts/rtc_log.
+static void mqtt_dump_rtc_log(bool clear)
+{
+    const size_t count = app_rtc_log_snapshot(s_log_dump, MQTT_LOG_DUMP_MAX_RECS);
+    size_t parts = (count + MQTT_LOG_DUMP_RECS_PER_MSG - 1U) / MQTT_LOG_DUMP_RECS_PER_MSG;
+    if (parts == 0U) {
+        parts = 1U;   // an empty part still tells the backend the ring is empty
+    }
+
+    for (size_t part = 0; part < parts; ++part) {
+        const size_t first = part * MQTT_LOG_DUMP_RECS_PER_MSG;
+        size_t n = (count > first) ? (count - first) : 0U;
+        if (n > MQTT_LOG_DUMP_RECS_PER_MSG) {
+            n = MQTT_LOG_DUMP_RECS_PER_MSG;
+        }
+
+        unsigned char b64[((MQTT_LOG_DUMP_RECS_PER_MSG * sizeof(app_rtc_log_rec_t) + 2U) / 3U) * 4U + 1U] = {0};
+        size_t b64_len = 0;
+        if (mbedtls_base64_encode(b64, sizeof(b64), &b64_len, (const unsigned char *)&s_log_dump[first],
+                                  n * sizeof(app_rtc_log_rec_t)) != 0) {
+            ESP_LOGW(TAG, "log dump encode failed");
+            return;
+        }
+
+        char payload[sizeof(b64) + 64] = {0};
+        (void)snprintf(payload, sizeof(payload), "{\"log\":{\"v\":1,\"part\":%u,\"parts\":%u,\"d\":\"%s\"}}",
+                       (unsigned)part, (unsigned)parts, (const char *)b64);
+        if (mqtt_publish_json(MQTT_TOPIC_DIAG, payload, 1, NULL) != ESP_OK) {
+            ESP_LOGW(TAG, "log dump stopped at part %u/%u", (unsigned)part, (unsigned)parts);
+            return;
+        }
+    }
+
+    ESP_LOGI(TAG, "rtc log dumped: %u records", (unsigned)count);
+    if (clear) {
+        app_rtc_log_clear();
+    }
+}
+
+// Clamps a finite downlink number to [0, max] so the cast after it is defined.
+static double mqtt_clamp_number(double value, double max)
+{
+    if (value <= 0.0) {
+        return 0.0;
+    }
+    return (value > max) ? max : value;
+}
+
+// Backpressure from the backend: {"min": s, "nth": n, "until": unix}.
+// null, or an "until" in the past, lifts it.
+static void mqtt_apply_backoff(const cJSON *bko)
+{
+    if (cJSON_IsNull(bko)) {
+        power_manager_set_backoff(0U, 0U, 0);
+        return;
+    }
+
+    const cJSON *until = cJSON_GetObjectItem(bko, "until");
+    if (!cJSON_IsObject(bko) || !cJSON_IsNumber(until)) {
+        ESP_LOGW(TAG, "backoff invalid");
+        return;
+    }
+
+    const cJSON *min = cJSON_GetObjectItem(bko, "min");
+    const cJSON *nth = cJSON_GetObjectItem(bko, "nth");
+    const double min_s = cJSON_IsNumber(min) ? cJSON_GetNumberValue(min) : 0.0;
+    const double every = cJSON_IsNumber(nth) ? cJSON_GetNumberValue(nth) : 0.0;
+    const double until_s = cJSON_GetNumberValue(until);
+    // cJSON turns overflowing literals into inf; casting those is undefined.
+    if (!isfinite(min_s) || !isfinite(every) || !isfinite(until_s)) {
+        ESP_LOGW(TAG, "backoff invalid");
+        return;
+    }
+
+    power_manager_set_backoff((uint32_t)mqtt_clamp_number(min_s, (double)UINT32_MAX),
+                              (uint16_t)mqtt_clamp_number(every, (double)UINT16_MAX),
+                              (int64_t)mqtt_clamp_number(until_s, MQTT_BACKOFF_UNTIL_MAX_S));
 }
 
 static void mqtt_apply_config(const cJSON *root)
@@ -137,6 +397,19 @@ static void mqtt_apply_config(const cJSON *root)
         return;
     }
 
+    const cJSON *bko = cJSON_GetObjectItem(root, "bko");
+    if (bko != NULL) {
+        mqtt_apply_backoff(bko);
+    }
+    // {"log": 1} dumps the RTC log, {"log": 2} dumps and clears it.
+    const cJSON *log = cJSON_GetObjectItem(root, "log");
+    if (cJSON_IsNumber(log) && (cJSON_GetNumberValue(log) >= 1.0)) {
+        mqtt_dump_rtc_log(cJSON_GetNumberValue(log) >= 2.0);
+    }
+    if (((bko != NULL) || (log != NULL)) && (cJSON_GetObjectItem(root, "sle") == NULL)) {
+        return;   // directive-only message
+    }
+
     const cJSON *lux = cJSON_GetObjectItem(root, "lux");
     const cJSON *moi = cJSON_GetObjectItem(root, "moi");
     const cJSON *tem = cJSON_GetObjectItem(root, "tem");
@@ -183,6 +456,21 @@ static void mqtt_apply_config(const cJSON *root)
     if (app_context_set_config(&cfg) == ESP_OK) {
         ESP_LOGI(TAG, "config updated from mqtt");
     }
+
+    // Optional upload slot: second within the sleep interval this pot should
+    // wake at, so the broker sees the fleet spread out. Negative clears it.
+    const cJSON *slo = cJSON_GetObjectItem(root, "slo");
+    if (cJSON_IsNumber(slo)) {
+        const double slot = cJSON_GetNumberValue(slo);
+        if (slot >= (double)cfg.sleep_duration) {
+            ESP_LOGW(TAG, "config invalid slo=%d", (int)slot);
+            return;
+        }
+        const int32_t slot_s = (slot < 0.0) ? -1 : (int32_t)slot;
+        app_context_set_upload_slot(slot_s);
+        (void)nvs_manager_save_upload_slot(slot_s);
+        ESP_LOGI(TAG, "upload slot %ld", (long)slot_s);
+    }
 }
 
 static void mqtt_handle_watering(const cJSON *root)
@@ -210,49 +498,45 @@ static void mqtt_handle_watering(const cJSON *root)
     mqtt_publish_watering_status(0);
 }
 
-static void mqtt_publish_telemetry_internal(void)
+// [min, max, sd] scaled to the telemetry unit: value * scale + offset.
+static void mqtt_add_stat(cJSON *obj, const char *key, const sensor_stat_t *stat, double scale, double offset)
 {
-    sensor_data_t data = {0};
-    (void)app_context_get_sensor_data(&data);
-
-    char topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char setup_topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char cfg_topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char water_topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char water_status[MQTT_TOPIC_BUF_LEN] = {0};
-    char hard_reset[MQTT_TOPIC_BUF_LEN] = {0};
-    mqtt_build_topics(topic, sizeof(topic), setup_topic, sizeof(setup_topic), cfg_topic, sizeof(cfg_topic), water_topic, sizeof(water_topic), water_status, sizeof(water_status), hard_reset, sizeof(hard_reset));
-
-    float temp_c = ((float)data.temperature / 10.0f) - 273.15f;
-
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
+    if (stat->n < 2U) {
         return;
     }
 
-    uint32_t unix_ts = 0;
-    if (app_context_is_time_synced()) {
-        unix_ts = (uint32_t)time(NULL);
+    cJSON *arr = cJSON_AddArrayToObject(obj, key);
+    if (arr == NULL) {
+        return;
     }
-    cJSON_AddNumberToObject(root, "timestamp", mqtt_next_timestamp_ms(unix_ts));
+    cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)stat->min * scale + offset));
+    cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)stat->max * scale + offset));
+    cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)stat->sd10 * scale / 10.0));
+    cJSON_AddItemToArray(arr, cJSON_CreateNumber((double)stat->n));
+}
 
-    cJSON *payload = cJSON_AddObjectToObject(root, "data");
-    if (payload != NULL) {
-        cJSON_AddNumberToObject(payload, "lux", (int)data.lux_level);
-        cJSON_AddNumberToObject(payload, "tem", (double)temp_c);
-        cJSON_AddNumberToObject(payload, "moi", (int)data.soil_moisture);
-        cJSON_AddNumberToObject(payload, "pre", (double)data.pressure);
+static void mqtt_add_stats(cJSON *root, const sensor_stats_t *stats)
+{
+    if ((stats == NULL) ||
+        ((stats->lux.n < 2U) && (stats->temperature.n < 2U) && (stats->pressure.n < 2U) && (stats->soil.n < 2U))) {
+        return;
     }
 
-    char *json = cJSON_PrintUnformatted(root);
-    if (json != NULL) {
-        (void)mqtt_publish_json(topic, json, 1);
-        cJSON_free(json);
+    cJSON *sta = cJSON_AddObjectToObject(root, "sta");
+    if (sta == NULL) {
+        return;
     }
-    cJSON_Delete(root);
+    mqtt_add_stat(sta, "lux", &stats->lux, 1.0, 0.0);
+    mqtt_add_stat(sta, "tem", &stats->temperature, 0.1, -273.15);
+    mqtt_add_stat(sta, "moi", &stats->soil, 1.0, 0.0);
+    mqtt_add_stat(sta, "pre", &stats->pressure, 0.1, 0.0);
 }
 
-static esp_err_t mqtt_publish_sample_payload(const char *topic, const sensor_data_t *data, uint32_t timestamp)
+// stats: burst spread, NULL or all n < 2 when the sample has none.
+static esp_err_t mqtt_publish_sample_payload(const sensor_data_t *data,
+                                             const sensor_stats_t *stats,
+                                             uint32_t timestamp,
+                                             int *out_msg_id)
 {
     if (data == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -271,8 +555,15 @@ static esp_err_t mqtt_publish_sample_payload(const char *topic, const sensor_dat
         cJSON_AddNumberToObject(payload, "lux", (int)data->lux_level);
         cJSON_AddNumberToObject(payload, "tem", (double)temp_c);
         cJSON_AddNumberToObject(payload, "moi", (int)data->soil_moisture);
-        cJSON_AddNumberToObject(payload, "pre", (double)data->pressure);
+        cJSON_AddNumberToObject(payload, "pre", (double)data->pressure_cpa / SENSOR_PRESSURE_CPA_PER_HPA);
+        if (data->flags != 0U) {
+            cJSON_AddNumberToObject(payload, "flg", (int)data->flags);
+        }
+        if (data->battery_mv != 0U) {
+            cJSON_AddNumberToObject(payload, "bat", (int)data->battery_mv);
+        }
     }
+    mqtt_add_stats(root, stats);
 
     char *json = cJSON_PrintUnformatted(root);
     if (json == NULL) {
@@ -280,43 +571,211 @@ static esp_err_t mqtt_publish_sample_payload(const char *topic, const sensor_dat
         return ESP_ERR_NO_MEM;
     }
 
-    esp_err_t err = mqtt_publish_json(topic, json, 1);
+    esp_err_t err = mqtt_publish_json(MQTT_TOPIC_TELEMETRY, json, 1, out_msg_id);
     cJSON_free(json);
     cJSON_Delete(root);
     return err;
 }
 
-static void mqtt_publish_stored_samples(void)
+static esp_err_t mqtt_publish_telemetry_internal(void)
+{
+    sensor_data_t data = {0};
+    (void)app_context_get_sensor_data(&data);
+    sensor_stats_t stats = {0};
+    (void)app_context_get_sensor_stats(&stats);
+
+    uint32_t unix_ts = 0;
+    if (app_context_is_time_synced()) {
+        unix_ts = (uint32_t)time(NULL);
+    }
+    return mqtt_publish_sample_payload(&data, &stats, unix_ts, &s_live_msg_id);
+}
+
+/* =========================================================================
+   SECTION: Backlog Drain
+   ========================================================================= */
+static void mqtt_drain_reset(void)
+{
+    if (s_drain_timer != NULL) {
+        (void)esp_timer_stop(s_drain_timer);
+    }
+    taskENTER_CRITICAL(&s_drain_lock);
+    memset(&s_drain, 0, sizeof(s_drain));
+    taskEXIT_CRITICAL(&s_drain_lock);
+}
+
+static void mqtt_drain_report(const char *reason)
 {
-    sensor_sample_t samples[NVS_SENSOR_SAMPLES_N] = {0};
+    if (s_drain_timer != NULL) {
+        (void)esp_timer_stop(s_drain_timer);
+    }
+    const size_t left = nvs_manager_get_sample_count();
+    ESP_LOGI(TAG, "drain done (%s): sent=%u left=%u", reason, (unsigned)s_drain.sent, (unsigned)left);
+    APP_RLOG(MQTT_DRAIN, s_drain.sent, left, 0);
+    (void)fsm_manager_post_event(APP_EVENT_MQTT_PUBLISHED, NULL, 0, 0);
+}
+
+// MQTT task only; only the first call per wake releases the FSM.
+static void mqtt_drain_finish(const char *reason)
+{
+    bool post = false;
+    taskENTER_CRITICAL(&s_drain_lock);
+    if (!s_drain.finished) {
+        s_drain.finished = true;
+        s_drain.active = false;
+        post = true;
+    }
+    taskEXIT_CRITICAL(&s_drain_lock);
+
+    if (post) {
+        mqtt_drain_report(reason);
+    }
+}
+
+// Budget timer. While the MQTT task is mid-chunk the finish is left to it,
+// so nothing is dropped or published after MQTT_PUBLISHED.
+static void mqtt_drain_timer_cb(void *arg)
+{
+    (void)arg;
+
+    bool post = false;
+    taskENTER_CRITICAL(&s_drain_lock);
+    if (s_drain.busy) {
+        s_drain.deferred = "budget exhausted";
+    } else if (!s_drain.finished) {
+        s_drain.finished = true;
+        s_drain.active = false;
+        post = true;
+    }
+    taskEXIT_CRITICAL(&s_drain_lock);
+
+    if (post) {
+        mqtt_drain_report("budget exhausted");
+    }
+}
+
+// Brackets chunk work on the MQTT task; false once the drain is over.
+static bool mqtt_drain_begin_work(void)
+{
+    taskENTER_CRITICAL(&s_drain_lock);
+    const bool running = s_drain.active && !s_drain.finished;
+    s_drain.busy = running;
+    taskEXIT_CRITICAL(&s_drain_lock);
+    return running;
+}
+
+static void mqtt_drain_end_work(void)
+{
+    taskENTER_CRITICAL(&s_drain_lock);
+    const char *deferred = s_drain.deferred;
+    s_drain.busy = false;
+    s_drain.deferred = NULL;
+    taskEXIT_CRITICAL(&s_drain_lock);
+
+    if (deferred != NULL) {
+        mqtt_drain_finish(deferred);
+    }
+}
+
+static void mqtt_drain_next_chunk(void)
+{
+    if (!s_drain.active) {
+        return;
+    }
+    if (power_manager_backoff_active()) {
+        // The backend asked for less traffic; the backlog waits.
+        mqtt_drain_finish("server backoff");
+        return;
+    }
+    if (s_drain.sent >= MQTT_DRAIN_MAX_PER_WAKE) {
+        mqtt_drain_finish("wake quota reached");
+        return;
+    }
+
+    size_t want = MQTT_DRAIN_MAX_PER_WAKE - s_drain.sent;
+    if (want > MQTT_DRAIN_CHUNK_N) {
+        want = MQTT_DRAIN_CHUNK_N;
+    }
+
+    sensor_sample_t chunk[MQTT_DRAIN_CHUNK_N] = {0};
     size_t count = 0;
-    if (nvs_manager_get_all_samples(samples, NVS_SENSOR_SAMPLES_N, &count) != ESP_OK) {
-        ESP_LOGW(TAG, "failed to read stored samples");
+    if (nvs_manager_peek_oldest_samples(chunk, want, &count) != ESP_OK) {
+        mqtt_drain_finish("backlog read failed");
         return;
     }
     if (count == 0) {
+        mqtt_drain_finish("backlog empty");
         return;
     }
 
-    char topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char setup_topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char cfg_topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char water_topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char water_status[MQTT_TOPIC_BUF_LEN] = {0};
-    char hard_reset[MQTT_TOPIC_BUF_LEN] = {0};
-    mqtt_build_topics(topic, sizeof(topic), setup_topic, sizeof(setup_topic), cfg_topic, sizeof(cfg_topic), water_topic, sizeof(water_topic), water_status, sizeof(water_status), hard_reset, sizeof(hard_reset));
-
-    bool all_ok = true;
+    s_drain.chunk_len = 0;
+    s_drain.chunk_acked = 0;
     for (size_t i = 0; i < count; ++i) {
-        if (mqtt_publish_sample_payload(topic, &samples[i].data, samples[i].timestamp) != ESP_OK) {
-            all_ok = false;
+        if (mqtt_publish_sample_payload(&chunk[i].data, &chunk[i].stats, chunk[i].timestamp,
+                                        &s_drain.chunk_msg_ids[i]) != ESP_OK) {
+            // Unacked samples stay in NVS; some may arrive twice next wake.
+            mqtt_drain_finish("publish failed");
+            return;
+        }
+        s_drain.chunk_len++;
+    }
+    s_drain.chunk_end_seq = chunk[count - 1].sample_seq + 1U;
+}
+
+static void mqtt_drain_chunk_acked(int msg_id)
+{
+    for (size_t i = 0; i < s_drain.chunk_len; ++i) {
+        if (s_drain.chunk_msg_ids[i] == msg_id) {
+            s_drain.chunk_msg_ids[i] = -1;
+            s_drain.chunk_acked++;
             break;
         }
     }
+    if (s_drain.chunk_acked < s_drain.chunk_len) {
+        return;
+    }
 
-    if (all_ok) {
-        (void)nvs_manager_clear_samples();
-        ESP_LOGI(TAG, "published %u stored samples", (unsigned)count);
+    // Whole chunk delivered; only now is it safe to forget it.
+    if (nvs_manager_drop_samples_before(s_drain.chunk_end_seq) != ESP_OK) {
+        mqtt_drain_finish("backlog drop failed");
+        return;
+    }
+    s_drain.sent += (uint32_t)s_drain.chunk_len;
+    mqtt_drain_next_chunk();
+}
+
+static void mqtt_drain_on_ack(int msg_id)
+{
+    if ((msg_id <= 0) || !mqtt_drain_begin_work()) {
+        return;
+    }
+    mqtt_drain_chunk_acked(msg_id);
+    mqtt_drain_end_work();
+}
+
+static void mqtt_drain_start(void)
+{
+    mqtt_drain_reset();
+    taskENTER_CRITICAL(&s_drain_lock);
+    s_drain.active = true;
+    taskEXIT_CRITICAL(&s_drain_lock);
+
+    if (s_drain_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = mqtt_drain_timer_cb,
+            .name = "mqtt_drain",
+        };
+        if (esp_timer_create(&args, &s_drain_timer) != ESP_OK) {
+            s_drain_timer = NULL;
+        }
+    }
+    if (s_drain_timer != NULL) {
+        (void)esp_timer_start_once(s_drain_timer, (uint64_t)MQTT_DRAIN_BUDGET_MS * 1000ULL);
+    }
+
+    if (mqtt_drain_begin_work()) {
+        mqtt_drain_next_chunk();
+        mqtt_drain_end_work();
     }
 }
 
@@ -328,11 +787,8 @@ static void mqtt_handle_event_data(const esp_mqtt_event_handle_t event)
 
     char cfg_topic[MQTT_TOPIC_BUF_LEN] = {0};
     char water_topic[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy1[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy2[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy3[MQTT_TOPIC_BUF_LEN] = {0};
-    char dummy4[MQTT_TOPIC_BUF_LEN] = {0};
-    mqtt_build_topics(dummy1, sizeof(dummy1), dummy2, sizeof(dummy2), cfg_topic, sizeof(cfg_topic), water_topic, sizeof(water_topic), dummy3, sizeof(dummy3), dummy4, sizeof(dummy4));
+    mqtt_build_topic(MQTT_TOPIC_CONFIG_CMD, cfg_topic, sizeof(cfg_topic));
+    mqtt_build_topic(MQTT_TOPIC_WATER_CMD, water_topic, sizeof(water_topic));
 
     if ((event->topic_len <= 0) || (event->data_len <= 0)) {
         return;
@@ -364,6 +820,12 @@ static void mqtt_handle_event_data(const esp_mqtt_event_handle_t event)
 
 static void mqtt_track_failure_and_fallback(void)
 {
+    if (s_drain.active) {
+        // Live sample is already delivered; the backlog simply waits for the next wake.
+        mqtt_drain_finish("connection lost");
+        return;
+    }
+
     int64_t now_us = esp_timer_get_time();
     if ((s_mqtt_fail_window_start_us == 0) || ((now_us - s_mqtt_fail_window_start_us) > MQTT_FAIL_WINDOW_US)) {
         s_mqtt_fail_window_start_us = now_us;
@@ -371,8 +833,11 @@ static void mqtt_track_failure_and_fallback(void)
     }
 
     s_mqtt_fail_count++;
-    if (s_mqtt_fail_count >= MQTT_FAIL_THRESHOLD) {
-        ESP_LOGW(TAG, "mqtt failures=%d within window, fallback to flash", s_mqtt_fail_count);
+    const int threshold = (s_rtc_backoff.failures > 0U) ? MQTT_PROBE_FAIL_THRESHOLD : MQTT_FAIL_THRESHOLD;
+    if (s_mqtt_fail_count >= threshold) {
+        app_backoff_on_failure(&s_rtc_backoff, MQTT_BACKOFF_THRESHOLD, MQTT_BACKOFF_MAX_SKIP);
+        ESP_LOGW(TAG, "mqtt failures=%d within window, fallback to flash (skip next %u wakes)",
+                 s_mqtt_fail_count, (unsigned)s_rtc_backoff.skip_left);
         s_mqtt_fail_count = 0;
         s_mqtt_fail_window_start_us = 0;
         (void)fsm_manager_post_event(APP_EVENT_DECISION_STORAGE, NULL, 0, 0);
@@ -394,26 +859,23 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             ESP_LOGI(TAG, "mqtt connected");
             s_mqtt_fail_count = 0;
             s_mqtt_fail_window_start_us = 0;
-
-            mqtt_publish_stored_samples();
+            mqtt_reset_aliases();   // alias mappings live only as long as the connection
 
             if (!s_subscribed) {
                 char cfg_topic[MQTT_TOPIC_BUF_LEN] = {0};
                 char water_topic[MQTT_TOPIC_BUF_LEN] = {0};
-                char dummy1[MQTT_TOPIC_BUF_LEN] = {0};
-                char dummy2[MQTT_TOPIC_BUF_LEN] = {0};
-                char dummy3[MQTT_TOPIC_BUF_LEN] = {0};
-                char dummy4[MQTT_TOPIC_BUF_LEN] = {0};
-                mqtt_build_topics(dummy1, sizeof(dummy1), dummy2, sizeof(dummy2), cfg_topic, sizeof(cfg_topic), water_topic, sizeof(water_topic), dummy3, sizeof(dummy3), dummy4, sizeof(dummy4));
+                mqtt_build_topic(MQTT_TOPIC_CONFIG_CMD, cfg_topic, sizeof(cfg_topic));
+                mqtt_build_topic(MQTT_TOPIC_WATER_CMD, water_topic, sizeof(water_topic));
 
                 (void)esp_mqtt_client_subscribe(s_client, cfg_topic, 1);
                 (void)esp_mqtt_client_subscribe(s_client, water_topic, 1);
                 s_subscribed = true;
             }
 
+            // The live sample normally sits in the outbox already; the backlog
+            // is only touched once it is acked.
             if (s_publish_pending) {
-                mqtt_publish_telemetry_internal();
-                s_publish_pending = false;
+                s_publish_pending = (mqtt_publish_telemetry_internal() != ESP_OK);
             }
             break;
         }
@@ -421,9 +883,15 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             mqtt_handle_event_data(event);
             break;
         case MQTT_EVENT_PUBLISHED:
-            if (event->msg_id == s_last_pub_id) {
-                ESP_LOGI(TAG, "publish confirmed msg_id=%d", event->msg_id);
-                (void)fsm_manager_post_event(APP_EVENT_MQTT_PUBLISHED, NULL, 0, 0);
+            if ((s_live_msg_id > 0) && (event->msg_id == s_live_msg_id)) {
+                ESP_LOGI(TAG, "live sample confirmed msg_id=%d", event->msg_id);
+                APP_RLOG(MQTT_ACK, event->msg_id, 0, 0);
+                s_live_msg_id = -1;
+                app_backoff_on_success(&s_rtc_backoff);
+                mqtt_publish_diagnostics();
+                mqtt_drain_start();
+            } else {
+                mqtt_drain_on_ack(event->msg_id);
             }
             break;
         case MQTT_EVENT_ERROR:
@@ -432,6 +900,8 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             break;
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGW(TAG, "mqtt disconnected");
+            APP_RLOG(MQTT_DISCONNECT, s_mqtt_fail_count, 0, 0);
+            mqtt_reset_aliases();
             mqtt_track_failure_and_fallback();
             break;
         default:
@@ -462,23 +932,57 @@ static esp_err_t mqtt_client_start_internal(void)
     mqtt_gpio_init();
 
     char mqtt_uri[128] = {0};
-    snprintf(mqtt_uri, sizeof(mqtt_uri), "mqtt://%s", MQTT_BROKER_HOST);
+#if CONFIG_APP_MQTT_USE_TLS
+    snprintf(mqtt_uri, sizeof(mqtt_uri), "mqtts://%s", CONFIG_APP_MQTT_BROKER_HOST);
+    // Own transport instead of esp-tls so the session can be kept across deep sleep.
+    esp_transport_handle_t transport =
+        mqtt_tls_transport_create(s_ca_crt_start, (size_t)(s_ca_crt_end - s_ca_crt_start));
+    if (transport == NULL) {
+        ESP_LOGE(TAG, "tls transport init failed");
+        return ESP_FAIL;
+    }
+#else
+    snprintf(mqtt_uri, sizeof(mqtt_uri), "mqtt://%s", CONFIG_APP_MQTT_BROKER_HOST);
+#endif
 
     esp_mqtt_client_config_t cfg = {
         .broker.address.uri = mqtt_uri,
+#if CONFIG_APP_MQTT_USE_TLS
+        .broker.address.port = MQTT_BROKER_TLS_PORT,
+        .network.transport = transport,
+#else
         .broker.address.port = MQTT_BROKER_PORT,
+#endif
         .credentials.client_id = s_uuid,
         .credentials.username = s_uuid,
         .credentials.authentication.password = s_mqtt_pass,
         .session.keepalive = 60,
         .session.disable_clean_session = true,
+#ifdef CONFIG_MQTT_PROTOCOL_5
+        .session.protocol_ver = MQTT_PROTOCOL_V_5,
+#endif
     };
 
     s_client = esp_mqtt_client_init(&cfg);
     if (s_client == NULL) {
+#if CONFIG_APP_MQTT_USE_TLS
+        esp_transport_destroy(transport);
+#endif
         return ESP_FAIL;
     }
 
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    // MQTT 5 ends a non-clean session on disconnect unless an expiry is given.
+    esp_mqtt5_connection_property_config_t connect_props = {
+        .session_expiry_interval = MQTT_SESSION_EXPIRY_S,
+    };
+    if (esp_mqtt5_client_set_connect_property(s_client, &connect_props) != ESP_OK) {
+        ESP_LOGW(TAG, "mqtt5 connect properties rejected");
+    }
+#else
+    ESP_LOGW(TAG, "CONFIG_MQTT_PROTOCOL_5 disabled, publishing with full topics");
+#endif
+
     esp_mqtt_client_register_event(s_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
     return esp_mqtt_client_start(s_client);
 }
@@ -498,9 +1002,9 @@ esp_err_t mqtt_manager_publish_telemetry(void)
         return err;
     }
 
-    s_publish_pending = true;
-   mqtt_publish_telemetry_internal();
-    s_publish_pending = false;
+    mqtt_drain_reset();
+    // Queued in the outbox if not connected yet; retried on connect if even that fails.
+    s_publish_pending = (mqtt_publish_telemetry_internal() != ESP_OK);
     return ESP_OK;
 }
 
@@ -515,8 +1019,19 @@ esp_err_t mqtt_manager_stop(void)
     s_client = NULL;
     s_subscribed = false;
     s_publish_pending = false;
-    s_last_pub_id = -1;
+    s_live_msg_id = -1;
+    mqtt_drain_reset();
     s_mqtt_fail_count = 0;
     s_mqtt_fail_window_start_us = 0;
+    mqtt_reset_aliases();
     return ESP_OK;
 }
+
+bool mqtt_manager_backoff_should_skip(void)
+{
+    if (!app_backoff_should_skip(&s_rtc_backoff)) {
+        return false;
+    }
+    ESP_LOGI(TAG, "broker backing off, %u wakes left", (unsigned)s_rtc_backoff.skip_left);
+    return true;
+}
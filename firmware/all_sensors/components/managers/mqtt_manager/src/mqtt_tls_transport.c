@@ -0,0 +1,492 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_random.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/net_sockets.h"
+#include "mqtt_tls_transport.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define MQTT_TLS_SESSION_MAGIC    0x544C5331UL   // "TLS1"
+#define MQTT_TLS_SESSION_MAX      512            // serialized session incl. ticket, no peer cert
+#define MQTT_TLS_PORT_STR_LEN     8
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef struct {
+    uint32_t magic;
+    uint32_t key;              // hash of host:port the session belongs to
+    uint16_t len;
+    uint8_t blob[MQTT_TLS_SESSION_MAX];
+} tls_session_cache_t;
+
+typedef struct {
+    int sock;
+    bool ssl_ready;
+    bool in_handshake;
+    bool cert_verified;        // set by verify callback, only runs on full handshakes
+    uint32_t hs_tx;
+    uint32_t hs_rx;
+    mbedtls_x509_crt ca;
+    mbedtls_ssl_config conf;
+    mbedtls_ssl_context ssl;
+} tls_ctx_t;
+
+/* =========================================================================
+   SECTION: Static Data
+   ========================================================================= */
+static const char *TAG = "MQTT_TLS";
+
+// Survives deep sleep; lost on power-on or reset, which simply costs one full handshake.
+RTC_DATA_ATTR static tls_session_cache_t s_rtc_session;
+RTC_DATA_ATTR static uint32_t s_rtc_full_count;
+RTC_DATA_ATTR static uint32_t s_rtc_resumed_count;
+
+static mqtt_tls_stats_t s_last_stats = {0};
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static uint32_t tls_session_key(const char *host, int port)
+{
+    // FNV-1a over host and port
+    uint32_t hash = 2166136261UL;
+    for (const char *p = host; (p != NULL) && (*p != '\0'); ++p) {
+        hash = (hash ^ (uint8_t)*p) * 16777619UL;
+    }
+    hash = (hash ^ (uint32_t)port) * 16777619UL;
+    return hash;
+}
+
+static int tls_rng(void *arg, unsigned char *out_buf, size_t len)
+{
+    (void)arg;
+    esp_fill_random(out_buf, len);
+    return 0;
+}
+
+static int tls_verify_cb(void *arg, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    (void)crt;
+    (void)depth;
+    (void)flags;
+
+    tls_ctx_t *ctx = (tls_ctx_t *)arg;
+    ctx->cert_verified = true;
+    return 0;
+}
+
+static int tls_bio_send(void *arg, const unsigned char *buf, size_t len)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)arg;
+    int ret = send(ctx->sock, buf, len, 0);
+    if (ret < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+    if (ctx->in_handshake) {
+        ctx->hs_tx += (uint32_t)ret;
+    }
+    return ret;
+}
+
+static int tls_bio_recv(void *arg, unsigned char *buf, size_t len)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)arg;
+    int ret = recv(ctx->sock, buf, len, 0);
+    if (ret < 0) {
+        // SO_RCVTIMEO expired; report a timeout so the handshake does not spin.
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            return MBEDTLS_ERR_SSL_TIMEOUT;
+        }
+        return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+    if (ctx->in_handshake) {
+        ctx->hs_rx += (uint32_t)ret;
+    }
+    return ret;
+}
+
+static int tls_tcp_connect(const char *host, int port, int timeout_ms)
+{
+    char port_str[MQTT_TLS_PORT_STR_LEN] = {0};
+    (void)snprintf(port_str, sizeof(port_str), "%d", port);
+
+    struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *res = NULL;
+    if ((getaddrinfo(host, port_str, &hints, &res) != 0) || (res == NULL)) {
+        ESP_LOGW(TAG, "dns lookup failed for %s", host);
+        return -1;
+    }
+
+    int sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (sock < 0) {
+        freeaddrinfo(res);
+        return -1;
+    }
+
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    (void)setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    (void)setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    int ret = connect(sock, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    if (ret != 0) {
+        ESP_LOGW(TAG, "tcp connect to %s:%d failed errno=%d", host, port, errno);
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static bool tls_offer_cached_session(tls_ctx_t *ctx, uint32_t key)
+{
+    if ((s_rtc_session.magic != MQTT_TLS_SESSION_MAGIC) || (s_rtc_session.key != key) ||
+        (s_rtc_session.len == 0U) || (s_rtc_session.len > sizeof(s_rtc_session.blob))) {
+        return false;
+    }
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    bool ok = (mbedtls_ssl_session_load(&session, s_rtc_session.blob, s_rtc_session.len) == 0) &&
+              (mbedtls_ssl_set_session(&ctx->ssl, &session) == 0);
+    mbedtls_ssl_session_free(&session);
+
+    if (!ok) {
+        // Typically an mbedTLS config change after OTA; start over with a full handshake.
+        ESP_LOGW(TAG, "cached session unusable, dropping");
+        mqtt_tls_transport_forget_session();
+    }
+    return ok;
+}
+
+static void tls_store_session(tls_ctx_t *ctx, uint32_t key)
+{
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+
+    size_t len = 0;
+    s_rtc_session.magic = 0;
+    int ret = mbedtls_ssl_get_session(&ctx->ssl, &session);
+    if (ret == 0) {
+        ret = mbedtls_ssl_session_save(&session, s_rtc_session.blob, sizeof(s_rtc_session.blob), &len);
+    }
+    mbedtls_ssl_session_free(&session);
+
+    if (ret != 0) {
+        ESP_LOGW(TAG, "session not cached err=-0x%04x need=%u", (unsigned)-ret, (unsigned)len);
+        mqtt_tls_transport_forget_session();
+        return;
+    }
+
+    s_rtc_session.key = key;
+    s_rtc_session.len = (uint16_t)len;
+    s_rtc_session.magic = MQTT_TLS_SESSION_MAGIC;
+}
+
+static int tls_poll(tls_ctx_t *ctx, int timeout_ms, bool for_read)
+{
+    if (ctx->sock < 0) {
+        return -1;
+    }
+
+    fd_set fds;
+    fd_set err_fds;
+    FD_ZERO(&fds);
+    FD_ZERO(&err_fds);
+    FD_SET(ctx->sock, &fds);
+    FD_SET(ctx->sock, &err_fds);
+
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    int ret = select(ctx->sock + 1, for_read ? &fds : NULL, for_read ? NULL : &fds, &err_fds,
+                     (timeout_ms < 0) ? NULL : &tv);
+    if ((ret > 0) && FD_ISSET(ctx->sock, &err_fds)) {
+        return -1;
+    }
+    return ret;
+}
+
+/* =========================================================================
+   SECTION: Transport Callbacks
+   ========================================================================= */
+static int tls_close(esp_transport_handle_t t)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)esp_transport_get_context_data(t);
+    if (ctx == NULL) {
+        return -1;
+    }
+
+    if (ctx->ssl_ready) {
+        // close_notify keeps the server-side session cache entry valid
+        if ((ctx->sock >= 0) && mbedtls_ssl_is_handshake_over(&ctx->ssl)) {
+            (void)mbedtls_ssl_close_notify(&ctx->ssl);
+        }
+        mbedtls_ssl_free(&ctx->ssl);
+        ctx->ssl_ready = false;
+    }
+    if (ctx->sock >= 0) {
+        close(ctx->sock);
+        ctx->sock = -1;
+    }
+    return 0;
+}
+
+static int tls_connect(esp_transport_handle_t t, const char *host, int port, int timeout_ms)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)esp_transport_get_context_data(t);
+    if ((ctx == NULL) || (host == NULL)) {
+        return -1;
+    }
+
+    (void)tls_close(t);
+    ctx->sock = tls_tcp_connect(host, port, timeout_ms);
+    if (ctx->sock < 0) {
+        return -1;
+    }
+
+    mbedtls_ssl_init(&ctx->ssl);
+    ctx->ssl_ready = true;
+    if ((mbedtls_ssl_setup(&ctx->ssl, &ctx->conf) != 0) ||
+        (mbedtls_ssl_set_hostname(&ctx->ssl, host) != 0)) {
+        ESP_LOGE(TAG, "ssl setup failed");
+        (void)tls_close(t);
+        return -1;
+    }
+    mbedtls_ssl_set_bio(&ctx->ssl, ctx, tls_bio_send, tls_bio_recv, NULL);
+
+    const uint32_t key = tls_session_key(host, port);
+    const bool offered = tls_offer_cached_session(ctx, key);
+
+    ctx->hs_tx = 0;
+    ctx->hs_rx = 0;
+    ctx->cert_verified = false;
+    ctx->in_handshake = true;
+    const int64_t start_us = esp_timer_get_time();
+
+    int ret = 0;
+    do {
+        ret = mbedtls_ssl_handshake(&ctx->ssl);
+    } while ((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE));
+    ctx->in_handshake = false;
+
+    if (ret != 0) {
+        ESP_LOGW(TAG, "handshake failed err=-0x%04x verify=0x%08x",
+                 (unsigned)-ret, (unsigned)mbedtls_ssl_get_verify_result(&ctx->ssl));
+        mqtt_tls_transport_forget_session();
+        (void)tls_close(t);
+        return -1;
+    }
+
+    // The server certificate is only parsed (and our verify callback run) on a full handshake.
+    const bool resumed = offered && !ctx->cert_verified;
+    if (resumed) {
+        s_rtc_resumed_count++;
+    } else {
+        s_rtc_full_count++;
+    }
+
+    s_last_stats.handshake_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+    s_last_stats.handshake_tx_bytes = ctx->hs_tx;
+    s_last_stats.handshake_rx_bytes = ctx->hs_rx;
+    s_last_stats.resumed = resumed;
+    s_last_stats.full_count = s_rtc_full_count;
+    s_last_stats.resumed_count = s_rtc_resumed_count;
+
+    ESP_LOGI(TAG, "%s handshake %s in %u ms tx=%u rx=%u",
+             resumed ? "resumed" : "full", mbedtls_ssl_get_ciphersuite(&ctx->ssl),
+             (unsigned)s_last_stats.handshake_ms,
+             (unsigned)s_last_stats.handshake_tx_bytes, (unsigned)s_last_stats.handshake_rx_bytes);
+
+    tls_store_session(ctx, key);
+    return 0;
+}
+
+static int tls_poll_read(esp_transport_handle_t t, int timeout_ms)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)esp_transport_get_context_data(t);
+    if (ctx == NULL) {
+        return -1;
+    }
+    if (ctx->ssl_ready && (mbedtls_ssl_get_bytes_avail(&ctx->ssl) > 0U)) {
+        return 1;
+    }
+    return tls_poll(ctx, timeout_ms, true);
+}
+
+static int tls_poll_write(esp_transport_handle_t t, int timeout_ms)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)esp_transport_get_context_data(t);
+    if (ctx == NULL) {
+        return -1;
+    }
+    return tls_poll(ctx, timeout_ms, false);
+}
+
+static int tls_read(esp_transport_handle_t t, char *buffer, int len, int timeout_ms)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)esp_transport_get_context_data(t);
+    if ((ctx == NULL) || !ctx->ssl_ready) {
+        return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+    }
+
+    if (mbedtls_ssl_get_bytes_avail(&ctx->ssl) == 0U) {
+        int poll = tls_poll(ctx, timeout_ms, true);
+        if (poll < 0) {
+            return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+        }
+        if (poll == 0) {
+            return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+        }
+    }
+
+    int ret = mbedtls_ssl_read(&ctx->ssl, (unsigned char *)buffer, (size_t)len);
+    if (ret > 0) {
+        return ret;
+    }
+    if ((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE) ||
+        (ret == MBEDTLS_ERR_SSL_TIMEOUT)) {
+        return ERR_TCP_TRANSPORT_CONNECTION_TIMEOUT;
+    }
+    if ((ret == 0) || (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)) {
+        return ERR_TCP_TRANSPORT_CONNECTION_CLOSED_BY_FIN;
+    }
+    ESP_LOGW(TAG, "read failed err=-0x%04x", (unsigned)-ret);
+    return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+}
+
+static int tls_write(esp_transport_handle_t t, const char *buffer, int len, int timeout_ms)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)esp_transport_get_context_data(t);
+    if ((ctx == NULL) || !ctx->ssl_ready) {
+        return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+    }
+
+    int poll = tls_poll(ctx, timeout_ms, false);
+    if (poll <= 0) {
+        return poll;
+    }
+
+    int ret = mbedtls_ssl_write(&ctx->ssl, (const unsigned char *)buffer, (size_t)len);
+    if (ret >= 0) {
+        return ret;
+    }
+    if ((ret == MBEDTLS_ERR_SSL_WANT_READ) || (ret == MBEDTLS_ERR_SSL_WANT_WRITE)) {
+        return 0;
+    }
+    ESP_LOGW(TAG, "write failed err=-0x%04x", (unsigned)-ret);
+    return ERR_TCP_TRANSPORT_CONNECTION_FAILED;
+}
+
+static void tls_ctx_free(tls_ctx_t *ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+    mbedtls_ssl_config_free(&ctx->conf);
+    mbedtls_x509_crt_free(&ctx->ca);
+    free(ctx);
+}
+
+static int tls_destroy(esp_transport_handle_t t)
+{
+    tls_ctx_t *ctx = (tls_ctx_t *)esp_transport_get_context_data(t);
+    (void)tls_close(t);
+    tls_ctx_free(ctx);
+    esp_transport_set_context_data(t, NULL);
+    return 0;
+}
+
+static int tls_configure(tls_ctx_t *ctx, const char *ca_pem, size_t ca_pem_len)
+{
+    int ret = mbedtls_x509_crt_parse(&ctx->ca, (const unsigned char *)ca_pem, ca_pem_len);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "ca parse failed err=-0x%04x", (unsigned)-ret);
+        return ret;
+    }
+
+    ret = mbedtls_ssl_config_defaults(&ctx->conf, MBEDTLS_SSL_IS_CLIENT,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        return ret;
+    }
+
+    mbedtls_ssl_conf_authmode(&ctx->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&ctx->conf, &ctx->ca, NULL);
+    mbedtls_ssl_conf_rng(&ctx->conf, tls_rng, NULL);
+    mbedtls_ssl_conf_verify(&ctx->conf, tls_verify_cb, ctx);
+    // TLS 1.2 resumption is a single round trip with no asymmetric crypto on our side.
+    mbedtls_ssl_conf_max_tls_version(&ctx->conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&ctx->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    return 0;
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+esp_transport_handle_t mqtt_tls_transport_create(const char *ca_pem, size_t ca_pem_len)
+{
+    if ((ca_pem == NULL) || (ca_pem_len == 0U)) {
+        return NULL;
+    }
+
+    tls_ctx_t *ctx = calloc(1, sizeof(tls_ctx_t));
+    if (ctx == NULL) {
+        return NULL;
+    }
+    ctx->sock = -1;
+    mbedtls_x509_crt_init(&ctx->ca);
+    mbedtls_ssl_config_init(&ctx->conf);
+
+    if (tls_configure(ctx, ca_pem, ca_pem_len) != 0) {
+        tls_ctx_free(ctx);
+        return NULL;
+    }
+
+    esp_transport_handle_t t = esp_transport_init();
+    if (t == NULL) {
+        tls_ctx_free(ctx);
+        return NULL;
+    }
+
+    esp_transport_set_context_data(t, ctx);
+    esp_transport_set_func(t, tls_connect, tls_read, tls_write, tls_close,
+                           tls_poll_read, tls_poll_write, tls_destroy);
+    return t;
+}
+
+esp_err_t mqtt_tls_transport_get_stats(mqtt_tls_stats_t *out_stats)
+{
+    if (out_stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_stats = s_last_stats;
+    return ESP_OK;
+}
+
+void mqtt_tls_transport_forget_session(void)
+{
+    memset(&s_rtc_session, 0, sizeof(s_rtc_session));
+}
@@ -18,6 +18,7 @@ typedef struct {
     uint32_t sample_seq;     // Monotonic sample number (ordering source of truth)
     uint32_t timestamp;      // Unix time if available
     sensor_data_t data;      // Sensor payload
+    sensor_stats_t stats;    // Burst spread; all n == 0 for single reads
 } sensor_sample_t;
 
 /* =========================================================================
@@ -29,6 +30,19 @@ esp_err_t nvs_manager_save_config(const config_t *cfg);
 esp_err_t nvs_manager_load_config(config_t *out_cfg, bool *has_config);
 esp_err_t nvs_manager_clear_config(void);
 
+// Server-assigned upload slot (seconds into the sleep interval). A negative
+// value erases it; out_slot_s is -1 when none is stored.
+esp_err_t nvs_manager_save_upload_slot(int32_t slot_s);
+esp_err_t nvs_manager_load_upload_slot(int32_t *out_slot_s);
+
 esp_err_t nvs_manager_store_sample(sensor_sample_t *sample_in);
-esp_err_t nvs_manager_get_all_samples(sensor_sample_t *buffer, size_t max_items, size_t *out_count);
-esp_err_t nvs_manager_clear_samples(void);
+// Gives up with ESP_ERR_TIMEOUT if another task holds the sample ring longer
+// than timeout_ms; for callers that must not block (wake budget timer).
+esp_err_t nvs_manager_try_store_sample(sensor_sample_t *sample_in, uint32_t timeout_ms);
+
+// Oldest-first access for incremental upload: read up to max_items of the
+// oldest samples, then drop them once delivered. end_seq is one past the last
+// sample_seq to drop; samples stored in between are kept.
+esp_err_t nvs_manager_peek_oldest_samples(sensor_sample_t *buffer, size_t max_items, size_t *out_count);
+esp_err_t nvs_manager_drop_samples_before(uint32_t end_seq);
+size_t nvs_manager_get_sample_count(void);
@@ -5,6 +5,8 @@
 #include "nvs.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "nvs_manager.h"
 
 static const char *TAG = "NVS_MGR";
@@ -15,8 +17,38 @@ static const char *TAG = "NVS_MGR";
 #define NVS_NAMESPACE        "app"
 #define NVS_KEY_CONFIG       "cfg"
 #define NVS_KEY_CONFIG_SET   "cfg_set"
+#define NVS_KEY_UPLOAD_SLOT  "slot"
 #define NVS_KEY_META_NEXT    "meta_next"
 #define NVS_KEY_META_COUNT   "meta_cnt"
+#define NVS_SAMPLES_LOCK_MS  1000U
+#define NVS_SAMPLE_VERSION   3U
+#define NVS_SAMPLE_VERSION_NO_STATS 2U
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+// Sample blob as stored. Version 1 had no header: a bare nvs_sample_v2_t
+// with pressure as a hPa float where pressure_cpa now is. Version 2 adds
+// the header, version 3 the burst statistics. A sample without statistics
+// is still written as version 2, which takes one NVS entry less.
+typedef struct {
+    uint32_t sample_seq;
+    uint32_t timestamp;
+    sensor_data_t data;
+} nvs_sample_v2_t;
+
+typedef struct {
+    uint32_t version;
+    nvs_sample_v2_t sample;
+} nvs_sample_record_v2_t;
+
+typedef struct {
+    uint32_t version;
+    sensor_sample_t sample;
+} nvs_sample_record_t;
+
+_Static_assert(sizeof(nvs_sample_v2_t) == 24, "version 1 layout changed");
+_Static_assert(sizeof(nvs_sample_record_v2_t) == 28, "version 2 layout changed");
 
 /* =========================================================================
    SECTION: Static State
@@ -24,6 +56,11 @@ static const char *TAG = "NVS_MGR";
 static nvs_handle_t s_nvs = 0;
 static bool s_ready = false;
 
+// Sample ring bookkeeping is a read-modify-write of two keys; the FSM, MQTT
+// and esp_timer (wake budget) tasks all touch it.
+static SemaphoreHandle_t s_samples_lock;
+static StaticSemaphore_t s_samples_lock_buf;
+
 /* =========================================================================
    SECTION: Helpers
    ========================================================================= */
@@ -53,6 +90,20 @@ static esp_err_t ensure_nvs(void)
     return ESP_OK;
 }
 
+static bool samples_lock(uint32_t timeout_ms)
+{
+    if (s_samples_lock == NULL) {
+        ESP_LOGE(TAG, "nvs_manager_init not called");
+        return false;
+    }
+    return xSemaphoreTake(s_samples_lock, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+static void samples_unlock(void)
+{
+    (void)xSemaphoreGive(s_samples_lock);
+}
+
 static bool config_is_valid(const config_t *cfg)
 {
     if (cfg == NULL) {
@@ -148,21 +199,151 @@ static void sample_key_from_index(uint32_t idx, char *out_key, size_t out_len)
     snprintf(out_key, out_len, "s%03u", (unsigned)idx);
 }
 
-static esp_err_t erase_all_samples(uint32_t stored, uint32_t next_seq)
+static void sample_from_v2(const nvs_sample_v2_t *in, sensor_sample_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->sample_seq = in->sample_seq;
+    out->timestamp = in->timestamp;
+    out->data = in->data;
+}
+
+static bool sample_has_stats(const sensor_stats_t *stats)
 {
-    if (stored == 0) {
+    return (stats->lux.n != 0U) || (stats->temperature.n != 0U) || (stats->pressure.n != 0U) ||
+           (stats->soil.n != 0U);
+}
+
+static esp_err_t sample_from_blob(const nvs_sample_record_t *rec, size_t len, sensor_sample_t *out)
+{
+    if ((len == sizeof(*rec)) && (rec->version == NVS_SAMPLE_VERSION)) {
+        *out = rec->sample;
         return ESP_OK;
     }
 
+    nvs_sample_record_v2_t v2;
+    if ((len == sizeof(v2)) && (rec->version == NVS_SAMPLE_VERSION_NO_STATS)) {
+        memcpy(&v2, rec, sizeof(v2));
+        sample_from_v2(&v2.sample, out);
+        return ESP_OK;
+    }
+
+    if (len == sizeof(v2.sample)) {
+        // Version 1, queued before an update: no header, hPa float pressure.
+        float hpa = 0.0f;
+        memcpy(&v2.sample, rec, sizeof(v2.sample));
+        sample_from_v2(&v2.sample, out);
+        memcpy(&hpa, &out->data.pressure_cpa, sizeof(hpa));
+        out->data.pressure_cpa = (hpa > 0.0f) ? (uint32_t)((hpa * (float)SENSOR_PRESSURE_CPA_PER_HPA) + 0.5f) : 0U;
+        return ESP_OK;
+    }
+
+    ESP_LOGE(TAG, "sample blob len=%lu version=%lu unknown",
+             (unsigned long)len, (unsigned long)((len >= sizeof(rec->version)) ? rec->version : 0U));
+    return ESP_ERR_INVALID_VERSION;
+}
+
+static esp_err_t read_samples_locked(sensor_sample_t *buffer, size_t max_items, size_t *out_count)
+{
+    uint32_t next_seq = 0, stored = 0;
+    ESP_RETURN_ON_ERROR(load_meta(&next_seq, &stored), TAG, "load meta failed");
+
+    size_t count = stored;
+    if (count > max_items) {
+        count = max_items;
+    }
+
+    if (count == 0) {
+        *out_count = 0;
+        return ESP_OK;
+    }
+
+    // first `count` of the backlog
     uint32_t start_seq = (next_seq >= stored) ? (next_seq - stored) : 0;
-    for (uint32_t i = 0; i < stored; ++i) {
+    for (size_t i = 0; i < count; ++i) {
         uint32_t seq = start_seq + i;
         uint32_t idx = seq % NVS_SENSOR_SAMPLES_N;
         char key[6];
         sample_key_from_index(idx, key, sizeof(key));
+
+        nvs_sample_record_t rec;
+        size_t len = sizeof(rec);
+        esp_err_t err = nvs_get_blob(s_nvs, key, &rec, &len);
+        if (err == ESP_ERR_NVS_INVALID_LENGTH) {
+            len = 0;        // longer than any version this build knows
+            err = ESP_OK;
+        }
+        if (err == ESP_OK) {
+            err = sample_from_blob(&rec, len, &buffer[i]);
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        buffer[i].sample_seq = seq; // enforce ordering even if blob missing seq
+    }
+
+    *out_count = count;
+    return ESP_OK;
+}
+
+static esp_err_t store_sample_locked(sensor_sample_t *sample_in)
+{
+    uint32_t next_seq = 0, stored = 0;
+    ESP_RETURN_ON_ERROR(load_meta(&next_seq, &stored), TAG, "load meta failed");
+
+    uint32_t seq = next_seq;
+    uint32_t idx = seq % NVS_SENSOR_SAMPLES_N;
+    char key[6];
+    sample_key_from_index(idx, key, sizeof(key));
+
+    sample_in->sample_seq = seq;
+    esp_err_t err;
+    if (sample_has_stats(&sample_in->stats)) {
+        const nvs_sample_record_t rec = { .version = NVS_SAMPLE_VERSION, .sample = *sample_in };
+        err = nvs_set_blob(s_nvs, key, &rec, sizeof(rec));
+    } else {
+        const nvs_sample_record_v2_t rec = {
+            .version = NVS_SAMPLE_VERSION_NO_STATS,
+            .sample = { .sample_seq = seq, .timestamp = sample_in->timestamp, .data = sample_in->data },
+        };
+        err = nvs_set_blob(s_nvs, key, &rec, sizeof(rec));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "store sample failed (%s)", esp_err_to_name(err));
+        return err;
+    }
+
+    next_seq += 1;
+    if (stored < NVS_SENSOR_SAMPLES_N) {
+        stored += 1;
+    }
+
+    ESP_RETURN_ON_ERROR(save_meta(next_seq, stored), TAG, "save meta failed");
+    return ESP_OK;
+}
+
+static esp_err_t drop_samples_locked(uint32_t end_seq)
+{
+    uint32_t next_seq = 0, stored = 0;
+    ESP_RETURN_ON_ERROR(load_meta(&next_seq, &stored), TAG, "load meta failed");
+
+    uint32_t start_seq = (next_seq >= stored) ? (next_seq - stored) : 0;
+    if (end_seq > next_seq) {
+        end_seq = next_seq;
+    }
+    if (end_seq <= start_seq) {
+        return ESP_OK;   // already overwritten or dropped
+    }
+
+    for (uint32_t seq = start_seq; seq < end_seq; ++seq) {
+        char key[6];
+        sample_key_from_index(seq % NVS_SENSOR_SAMPLES_N, key, sizeof(key));
         (void)nvs_erase_key(s_nvs, key);
     }
-    return nvs_commit(s_nvs);
+
+    stored -= (end_seq - start_seq);
+    ESP_RETURN_ON_ERROR(save_meta(next_seq, stored), TAG, "save meta failed");
+    return ESP_OK;
 }
 
 /* =========================================================================
@@ -170,6 +351,10 @@ static esp_err_t erase_all_samples(uint32_t stored, uint32_t next_seq)
    ========================================================================= */
 esp_err_t nvs_manager_init(void)
 {
+    // Before any other task runs; the sample functions rely on it.
+    if (s_samples_lock == NULL) {
+        s_samples_lock = xSemaphoreCreateMutexStatic(&s_samples_lock_buf);
+    }
     return ensure_nvs();
 }
 
@@ -233,92 +418,100 @@ esp_err_t nvs_manager_clear_config(void)
 
     (void)nvs_erase_key(s_nvs, NVS_KEY_CONFIG);
     (void)nvs_erase_key(s_nvs, NVS_KEY_CONFIG_SET);
+    (void)nvs_erase_key(s_nvs, NVS_KEY_UPLOAD_SLOT);
     return nvs_commit(s_nvs);
 }
 
-esp_err_t nvs_manager_store_sample(sensor_sample_t *sample_in)
+esp_err_t nvs_manager_save_upload_slot(int32_t slot_s)
 {
-    if (sample_in == NULL) {
-        return ESP_ERR_INVALID_ARG;
-    }
-
     ESP_RETURN_ON_ERROR(ensure_nvs(), TAG, "nvs not ready");
 
-    uint32_t next_seq = 0, stored = 0;
-    ESP_RETURN_ON_ERROR(load_meta(&next_seq, &stored), TAG, "load meta failed");
-
-    uint32_t seq = next_seq;
-    uint32_t idx = seq % NVS_SENSOR_SAMPLES_N;
-    char key[6];
-    sample_key_from_index(idx, key, sizeof(key));
-
-    sample_in->sample_seq = seq;
-    esp_err_t err = nvs_set_blob(s_nvs, key, sample_in, sizeof(*sample_in));
+    esp_err_t err;
+    if (slot_s < 0) {
+        err = nvs_erase_key(s_nvs, NVS_KEY_UPLOAD_SLOT);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            return ESP_OK;
+        }
+    } else {
+        err = nvs_set_i32(s_nvs, NVS_KEY_UPLOAD_SLOT, slot_s);
+    }
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "store sample failed (%s)", esp_err_to_name(err));
+        ESP_LOGE(TAG, "set upload slot failed (%s)", esp_err_to_name(err));
         return err;
     }
-
-    next_seq += 1;
-    if (stored < NVS_SENSOR_SAMPLES_N) {
-        stored += 1;
-    }
-
-    ESP_RETURN_ON_ERROR(save_meta(next_seq, stored), TAG, "save meta failed");
-    return ESP_OK;
+    return nvs_commit(s_nvs);
 }
 
-esp_err_t nvs_manager_get_all_samples(sensor_sample_t *buffer, size_t max_items, size_t *out_count)
+esp_err_t nvs_manager_load_upload_slot(int32_t *out_slot_s)
 {
-    if (buffer == NULL || out_count == NULL || max_items == 0) {
+    if (out_slot_s == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
+    *out_slot_s = -1;
 
     ESP_RETURN_ON_ERROR(ensure_nvs(), TAG, "nvs not ready");
 
-    uint32_t next_seq = 0, stored = 0;
-    ESP_RETURN_ON_ERROR(load_meta(&next_seq, &stored), TAG, "load meta failed");
-
-    size_t count = stored;
-    if (count > max_items) {
-        count = max_items;
-    }
-
-    if (count == 0) {
-        *out_count = 0;
+    esp_err_t err = nvs_get_i32(s_nvs, NVS_KEY_UPLOAD_SLOT, out_slot_s);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        *out_slot_s = -1;
         return ESP_OK;
     }
+    return err;
+}
 
-    uint32_t start_seq = (next_seq >= count) ? (next_seq - count) : 0;
-    for (size_t i = 0; i < count; ++i) {
-        uint32_t seq = start_seq + i;
-        uint32_t idx = seq % NVS_SENSOR_SAMPLES_N;
-        char key[6];
-        sample_key_from_index(idx, key, sizeof(key));
+esp_err_t nvs_manager_store_sample(sensor_sample_t *sample_in)
+{
+    return nvs_manager_try_store_sample(sample_in, NVS_SAMPLES_LOCK_MS);
+}
 
-        size_t required = sizeof(sensor_sample_t);
-        esp_err_t err = nvs_get_blob(s_nvs, key, &buffer[i], &required);
-        if (err != ESP_OK) {
-            return err;
-        }
+esp_err_t nvs_manager_try_store_sample(sensor_sample_t *sample_in, uint32_t timeout_ms)
+{
+    if (sample_in == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-        buffer[i].sample_seq = seq; // enforce ordering even if blob missing seq
+    ESP_RETURN_ON_ERROR(ensure_nvs(), TAG, "nvs not ready");
+    if (!samples_lock(timeout_ms)) {
+        return ESP_ERR_TIMEOUT;
     }
+    esp_err_t err = store_sample_locked(sample_in);
+    samples_unlock();
+    return err;
+}
 
-    *out_count = count;
-    return ESP_OK;
+esp_err_t nvs_manager_peek_oldest_samples(sensor_sample_t *buffer, size_t max_items, size_t *out_count)
+{
+    if (buffer == NULL || out_count == NULL || max_items == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_RETURN_ON_ERROR(ensure_nvs(), TAG, "nvs not ready");
+    if (!samples_lock(NVS_SAMPLES_LOCK_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    esp_err_t err = read_samples_locked(buffer, max_items, out_count);
+    samples_unlock();
+    return err;
 }
 
-esp_err_t nvs_manager_clear_samples(void)
+esp_err_t nvs_manager_drop_samples_before(uint32_t end_seq)
 {
     ESP_RETURN_ON_ERROR(ensure_nvs(), TAG, "nvs not ready");
+    if (!samples_lock(NVS_SAMPLES_LOCK_MS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    esp_err_t err = drop_samples_locked(end_seq);
+    samples_unlock();
+    return err;
+}
 
+size_t nvs_manager_get_sample_count(void)
+{
     uint32_t next_seq = 0, stored = 0;
-    ESP_RETURN_ON_ERROR(load_meta(&next_seq, &stored), TAG, "load meta failed");
-
-    ESP_RETURN_ON_ERROR(erase_all_samples(stored, next_seq), TAG, "erase samples failed");
-
-    stored = 0;
-    ESP_RETURN_ON_ERROR(save_meta(next_seq, stored), TAG, "save meta failed");
-    return ESP_OK;
+    if ((ensure_nvs() != ESP_OK) || !samples_lock(NVS_SAMPLES_LOCK_MS)) {
+        return 0;
+    }
+    const esp_err_t err = load_meta(&next_seq, &stored);
+    samples_unlock();
+    return (err == ESP_OK) ? (size_t)stored : 0U;
 }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef enum {
+    POWER_MODE_DEEP_SLEEP = 0,   // reboot, reassociate and reconnect every interval
+    POWER_MODE_CONNECTED,        // stay associated in automatic light sleep
+} power_mode_t;
+
+// Battery tiers, each one degrading more (CONFIG_APP_BATT_*). Without
+// CONFIG_APP_BATTERY_MONITOR the tier stays NORMAL.
+typedef enum {
+    POWER_BATT_NORMAL = 0,
+    POWER_BATT_LOW,        // display off, interval stretched, uploads batched
+    POWER_BATT_CRITICAL,   // same, stretched further
+    POWER_BATT_CUTOFF,     // no radio and no flash writes, only sampling to notice recovery
+} power_batt_tier_t;
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Sampling interval from the plant config, with the default applied,
+// raised to the minimum of an active server backoff and stretched by the
+// battery tier.
+uint32_t power_manager_get_interval_s(void);
+
+// Server backoff directive, kept in RTC memory until until_s (unix time).
+// An until_s in the past clears it. Values are clamped to sane bounds.
+void power_manager_set_backoff(uint32_t min_interval_s, uint16_t every_nth, int64_t until_s);
+bool power_manager_backoff_active(void);
+
+// Call once per sampling cycle before connecting. False on the wakes an
+// "every Nth wake" directive or the battery tier skips; the sample is stored
+// instead.
+bool power_manager_upload_due(void);
+
+// Time to sleep from now until the next sample. With a valid clock wakes land
+// on this pot's phase of the interval (server slot, else MAC-derived) so the
+// fleet does not hit the broker at once; without one the interval gets a
+// per-device stretch instead.
+uint32_t power_manager_get_sleep_s(void);
+
+// Picks the cheaper way to spend interval_s until the next sample, from the
+// measured cost of a deep-sleep wake against staying connected.
+power_mode_t power_manager_select_mode(uint32_t interval_s);
+
+// Interval below which staying connected is cheaper, in seconds.
+uint32_t power_manager_get_break_even_s(void);
+
+// Call right before deep sleep; feeds the awake time of this wake into the
+// deep-sleep cost estimate.
+void power_manager_note_wake_end(void);
+
+// Automatic light sleep between FreeRTOS ticks. Returns ESP_ERR_NOT_SUPPORTED
+// when the build has no power management or tickless idle.
+esp_err_t power_manager_light_sleep_enable(void);
+esp_err_t power_manager_light_sleep_disable(void);
+
+// Feed a battery reading (mV, 0 = none). The tier follows it with some
+// hysteresis and is kept in RTC memory, so the next wake starts from it.
+void power_manager_note_battery(uint16_t mv);
+power_batt_tier_t power_manager_battery_tier(void);
+bool power_manager_display_allowed(void);
+// False once a brown-out during an NVS write becomes a real risk.
+bool power_manager_flash_write_allowed(void);
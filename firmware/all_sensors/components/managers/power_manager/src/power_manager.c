@@ -0,0 +1,425 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "app_context.h"
+#include "app_rtc_log.h"
+#include "power_manager.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define POWER_DEFAULT_INTERVAL_S   60U
+#define POWER_MIN_VALID_UNIX_S     1700000000LL   // clock never set before this
+#define POWER_SLOT_MIN_SLEEP_S     10U     // closer slots are taken one interval later
+// Without a wall clock each pot stretches its period by up to 1/N of the
+// interval, so pots powered on together drift apart.
+#define POWER_FREE_RUN_SPREAD_DIV  10U
+
+// Energy model, ESP32 module at 3.3 V. Rough bench figures; only their ratios
+// matter for picking a mode. mW * ms gives uJ.
+#define POWER_ACTIVE_MW            330U    // CPU at full clock with the radio up
+#define POWER_DEEP_SLEEP_UW        50U     // RTC timer + ext0, board quiescent included
+#define POWER_CONNECTED_IDLE_UW    6600U   // auto light sleep, max modem sleep, DTIM x3
+#define POWER_CONNECTED_CYCLE_MS   400U    // sample + publish over the open session
+#define POWER_BOOT_OVERHEAD_MS     250U    // ROM + bootloader, before esp_timer starts
+#define POWER_DEFAULT_WAKE_MS      2500U   // used until a deep-sleep wake was measured
+#define POWER_WAKE_MAX_SAMPLE_MS   20000U  // longer wakes are provisioning/calibration
+#define POWER_WAKE_EMA_SHIFT       2U      // new sample weighs 1/4
+
+// Once in a mode, the other one has to win by this margin (percent).
+#define POWER_HYSTERESIS_PCT       10U
+
+#define POWER_MIN_CPU_MHZ          40U     // XTAL; Wi-Fi needs at least this between sleeps
+
+#define POWER_RTC_MAGIC            0x50574D31UL   // "PWM1"
+#define POWER_BACKOFF_MAGIC        0x50424B31UL   // "PBK1"
+
+// Bounds on server backoff directives, so a bad one cannot silence a pot for good.
+#define POWER_BACKOFF_MAX_S        (7L * 24L * 3600L)
+#define POWER_BACKOFF_MAX_INTERVAL_S (6UL * 3600UL)
+#define POWER_BACKOFF_MAX_NTH      100U
+
+#define POWER_BATT_MAGIC           0x50424154UL   // "PBAT"
+#define POWER_BATT_HYST_MV         50U     // a tier is left only this far above its threshold
+#define POWER_BATT_TIER_COUNT      4U
+
+#if CONFIG_PM_ENABLE && CONFIG_FREERTOS_USE_TICKLESS_IDLE
+#define POWER_LIGHT_SLEEP_SUPPORTED 1
+#else
+#define POWER_LIGHT_SLEEP_SUPPORTED 0
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef struct {
+    uint32_t magic;
+    uint32_t wake_ms;      // EMA of a deep-sleep wake, boot overhead included
+} power_rtc_state_t;
+
+typedef struct {
+    uint32_t magic;
+    int64_t until_s;           // unix time the directive expires
+    uint32_t min_interval_s;   // lower bound on the sampling interval, 0 = none
+    uint16_t every_nth;        // upload on every Nth wake only, 0/1 = every wake
+    uint16_t wake_count;       // wakes since the directive arrived
+} power_backoff_t;
+
+typedef struct {
+    uint16_t below_mv;         // tier applies under this voltage
+    uint8_t sleep_mul;         // interval multiplier
+    uint8_t upload_every;      // upload on every Nth wake, 0 = never
+} power_batt_policy_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t mv;               // last reading
+    uint8_t tier;              // power_batt_tier_t
+    uint8_t reserved;
+    uint16_t wake_count;       // wakes in a batching tier
+} power_batt_state_t;
+
+/* =========================================================================
+   SECTION: Static Data
+   ========================================================================= */
+static const char *TAG = "POWER_MGR";
+static power_mode_t s_mode = POWER_MODE_DEEP_SLEEP;
+static uint32_t s_mac_hash;
+
+RTC_DATA_ATTR static power_rtc_state_t s_rtc_power;
+RTC_DATA_ATTR static power_backoff_t s_rtc_backoff;
+RTC_DATA_ATTR static power_batt_state_t s_rtc_batt;
+
+#if CONFIG_APP_BATTERY_MONITOR
+static const power_batt_policy_t s_batt_policy[POWER_BATT_TIER_COUNT] = {
+    [POWER_BATT_NORMAL]   = { .below_mv = UINT16_MAX, .sleep_mul = 1U, .upload_every = 1U },
+    [POWER_BATT_LOW]      = { .below_mv = CONFIG_APP_BATT_LOW_MV, .sleep_mul = CONFIG_APP_BATT_LOW_SLEEP_MUL,
+                              .upload_every = CONFIG_APP_BATT_LOW_UPLOAD_EVERY },
+    [POWER_BATT_CRITICAL] = { .below_mv = CONFIG_APP_BATT_CRITICAL_MV, .sleep_mul = CONFIG_APP_BATT_CRITICAL_SLEEP_MUL,
+                              .upload_every = CONFIG_APP_BATT_CRITICAL_UPLOAD_EVERY },
+    [POWER_BATT_CUTOFF]   = { .below_mv = CONFIG_APP_BATT_CUTOFF_MV, .sleep_mul = CONFIG_APP_BATT_CUTOFF_SLEEP_MUL,
+                              .upload_every = 0U },
+};
+
+// The tier lookup walks the thresholds from shallow to deep; Kconfig ranges alone allow any order.
+_Static_assert(CONFIG_APP_BATT_LOW_MV > CONFIG_APP_BATT_CRITICAL_MV,
+               "APP_BATT_LOW_MV must be above APP_BATT_CRITICAL_MV");
+_Static_assert(CONFIG_APP_BATT_CRITICAL_MV > CONFIG_APP_BATT_CUTOFF_MV,
+               "APP_BATT_CRITICAL_MV must be above APP_BATT_CUTOFF_MV");
+#else
+static const power_batt_policy_t s_batt_policy[POWER_BATT_TIER_COUNT] = {
+    [POWER_BATT_NORMAL] = { .below_mv = UINT16_MAX, .sleep_mul = 1U, .upload_every = 1U },
+};
+#endif
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static uint32_t power_wake_ms(void)
+{
+    return (s_rtc_power.magic == POWER_RTC_MAGIC) ? s_rtc_power.wake_ms : POWER_DEFAULT_WAKE_MS;
+}
+
+// Stable per-device number: FNV-1a over the station MAC.
+static uint32_t power_mac_hash(void)
+{
+    if (s_mac_hash != 0U) {
+        return s_mac_hash;
+    }
+
+    uint8_t mac[6] = {0};
+    (void)esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < sizeof(mac); ++i) {
+        hash = (hash ^ mac[i]) * 16777619UL;
+    }
+    s_mac_hash = (hash != 0U) ? hash : 1U;
+    return s_mac_hash;
+}
+
+static void power_backoff_clear(void)
+{
+    memset(&s_rtc_backoff, 0, sizeof(s_rtc_backoff));
+}
+
+static const power_batt_policy_t *power_batt_policy(void)
+{
+    return &s_batt_policy[power_manager_battery_tier()];
+}
+
+#if CONFIG_APP_BATTERY_MONITOR
+// Most severe tier whose threshold mv is under.
+static power_batt_tier_t power_batt_tier_for(uint32_t mv)
+{
+    power_batt_tier_t tier = POWER_BATT_NORMAL;
+    for (uint32_t t = POWER_BATT_LOW; t < POWER_BATT_TIER_COUNT; ++t) {
+        if (mv < s_batt_policy[t].below_mv) {
+            tier = (power_batt_tier_t)t;
+        }
+    }
+    return tier;
+}
+#endif
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+uint32_t power_manager_get_interval_s(void)
+{
+    config_t cfg = {0};
+    uint32_t interval_s = POWER_DEFAULT_INTERVAL_S;
+    if ((app_context_get_config(&cfg) == ESP_OK) && (cfg.sleep_duration != 0U)) {
+        interval_s = cfg.sleep_duration;
+    }
+    if (power_manager_backoff_active()) {
+        interval_s = MAX(interval_s, s_rtc_backoff.min_interval_s);
+    }
+    return interval_s * power_batt_policy()->sleep_mul;
+}
+
+void power_manager_set_backoff(uint32_t min_interval_s, uint16_t every_nth, int64_t until_s)
+{
+    const int64_t now = (int64_t)time(NULL);
+    if ((now < POWER_MIN_VALID_UNIX_S) || (until_s <= now)) {
+        if (s_rtc_backoff.magic == POWER_BACKOFF_MAGIC) {
+            ESP_LOGI(TAG, "server backoff cleared");
+        }
+        power_backoff_clear();
+        return;
+    }
+
+    s_rtc_backoff.until_s = MIN(until_s, now + POWER_BACKOFF_MAX_S);
+    s_rtc_backoff.min_interval_s = MIN(min_interval_s, POWER_BACKOFF_MAX_INTERVAL_S);
+    s_rtc_backoff.every_nth = MIN(every_nth, POWER_BACKOFF_MAX_NTH);
+    s_rtc_backoff.wake_count = 0U;
+    s_rtc_backoff.magic = POWER_BACKOFF_MAGIC;
+    ESP_LOGI(TAG, "server backoff: min %us, every %u wakes, for %llds",
+             (unsigned)s_rtc_backoff.min_interval_s, (unsigned)s_rtc_backoff.every_nth,
+             (long long)(s_rtc_backoff.until_s - now));
+}
+
+bool power_manager_backoff_active(void)
+{
+    if (s_rtc_backoff.magic != POWER_BACKOFF_MAGIC) {
+        return false;
+    }
+
+    // Without a clock the directive is kept; it can only be checked once time is back.
+    const int64_t now = (int64_t)time(NULL);
+    if ((now >= POWER_MIN_VALID_UNIX_S) && (now >= s_rtc_backoff.until_s)) {
+        ESP_LOGI(TAG, "server backoff expired");
+        power_backoff_clear();
+        return false;
+    }
+    return true;
+}
+
+// Batches uploads in the low tiers; the samples in between go to flash.
+static bool power_batt_upload_due(void)
+{
+    const power_batt_policy_t *policy = power_batt_policy();
+    if (policy->upload_every == 1U) {
+        return true;
+    }
+    if (policy->upload_every == 0U) {
+        ESP_LOGI(TAG, "battery %u mV: upload skipped", (unsigned)s_rtc_batt.mv);
+        return false;
+    }
+
+    s_rtc_batt.wake_count++;
+    if ((s_rtc_batt.wake_count % policy->upload_every) == 0U) {
+        return true;
+    }
+    ESP_LOGI(TAG, "battery %u mV: upload batched (%u/%u)", (unsigned)s_rtc_batt.mv,
+             (unsigned)(s_rtc_batt.wake_count % policy->upload_every), (unsigned)policy->upload_every);
+    return false;
+}
+
+static bool power_backoff_upload_due(void)
+{
+    if (!power_manager_backoff_active() || (s_rtc_backoff.every_nth <= 1U)) {
+        return true;
+    }
+
+    s_rtc_backoff.wake_count++;
+    if ((s_rtc_backoff.wake_count % s_rtc_backoff.every_nth) == 0U) {
+        return true;
+    }
+    ESP_LOGI(TAG, "server backoff: upload skipped (%u/%u)",
+             (unsigned)(s_rtc_backoff.wake_count % s_rtc_backoff.every_nth),
+             (unsigned)s_rtc_backoff.every_nth);
+    return false;
+}
+
+bool power_manager_upload_due(void)
+{
+    // Both counters advance every wake, so neither skews the other's cadence.
+    const bool backoff_due = power_backoff_upload_due();
+    const bool batt_due = power_batt_upload_due();
+    return backoff_due && batt_due;
+}
+
+uint32_t power_manager_get_sleep_s(void)
+{
+    const uint32_t interval_s = power_manager_get_interval_s();
+    const time_t now = time(NULL);
+    if ((int64_t)now < POWER_MIN_VALID_UNIX_S) {
+        return interval_s + (power_mac_hash() % (interval_s / POWER_FREE_RUN_SPREAD_DIV + 1U));
+    }
+
+    // Wake on a fixed phase of the wall clock: the server-assigned slot when
+    // there is one, otherwise a phase derived from the MAC.
+    const int32_t slot_s = app_context_get_upload_slot();
+    const uint32_t phase_s = ((slot_s >= 0) && ((uint32_t)slot_s < interval_s))
+                                 ? (uint32_t)slot_s
+                                 : (power_mac_hash() % interval_s);
+    const uint32_t now_phase_s = (uint32_t)((uint64_t)now % interval_s);
+    uint32_t sleep_s = (phase_s + interval_s - now_phase_s) % interval_s;
+    if (sleep_s < MIN(POWER_SLOT_MIN_SLEEP_S, interval_s / 2U)) {
+        sleep_s += interval_s;
+    }
+    return sleep_s;
+}
+
+uint32_t power_manager_get_break_even_s(void)
+{
+    // Deep sleep pays a full wake per sample, staying connected pays idle power
+    // for the whole interval. Break-even where both cost the same:
+    //   E_wake + P_deep * T = E_cycle + P_conn * T
+    const uint64_t wake_uj = (uint64_t)power_wake_ms() * POWER_ACTIVE_MW;
+    const uint64_t cycle_uj = (uint64_t)POWER_CONNECTED_CYCLE_MS * POWER_ACTIVE_MW;
+    if (wake_uj <= cycle_uj) {
+        return 0U;
+    }
+    return (uint32_t)((wake_uj - cycle_uj) / (POWER_CONNECTED_IDLE_UW - POWER_DEEP_SLEEP_UW));
+}
+
+power_mode_t power_manager_select_mode(uint32_t interval_s)
+{
+#if POWER_LIGHT_SLEEP_SUPPORTED
+    const uint32_t break_even_s = power_manager_get_break_even_s();
+    const uint32_t pct = (s_mode == POWER_MODE_CONNECTED) ? (100U + POWER_HYSTERESIS_PCT)
+                                                          : (100U - POWER_HYSTERESIS_PCT);
+    const uint64_t limit_s = ((uint64_t)break_even_s * pct) / 100U;
+    const power_mode_t mode = ((uint64_t)interval_s < limit_s) ? POWER_MODE_CONNECTED
+                                                               : POWER_MODE_DEEP_SLEEP;
+    if (mode != s_mode) {
+        ESP_LOGI(TAG, "interval %us, break-even %us -> %s", (unsigned)interval_s,
+                 (unsigned)break_even_s, (mode == POWER_MODE_CONNECTED) ? "connected" : "deep sleep");
+    }
+    s_mode = mode;
+    return mode;
+#else
+    (void)interval_s;
+    return POWER_MODE_DEEP_SLEEP;
+#endif
+}
+
+void power_manager_note_wake_end(void)
+{
+    const uint32_t awake_ms = (uint32_t)(esp_timer_get_time() / 1000) + POWER_BOOT_OVERHEAD_MS;
+    if (awake_ms > POWER_WAKE_MAX_SAMPLE_MS) {
+        return;
+    }
+
+    if (s_rtc_power.magic != POWER_RTC_MAGIC) {
+        s_rtc_power.magic = POWER_RTC_MAGIC;
+        s_rtc_power.wake_ms = awake_ms;
+    } else {
+        const int32_t delta = (int32_t)awake_ms - (int32_t)s_rtc_power.wake_ms;
+        s_rtc_power.wake_ms = (uint32_t)((int32_t)s_rtc_power.wake_ms + (delta >> POWER_WAKE_EMA_SHIFT));
+    }
+    ESP_LOGD(TAG, "wake %ums, avg %ums", (unsigned)awake_ms, (unsigned)s_rtc_power.wake_ms);
+}
+
+esp_err_t power_manager_light_sleep_enable(void)
+{
+#if POWER_LIGHT_SLEEP_SUPPORTED
+    const esp_pm_config_t pm = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = POWER_MIN_CPU_MHZ,
+        .light_sleep_enable = true,
+    };
+    // Buttons arm their GPIO wakeup themselves (power-save mode of iot_button).
+    (void)esp_sleep_enable_gpio_wakeup();
+    esp_err_t err = esp_pm_configure(&pm);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "light sleep enable failed (%s)", esp_err_to_name(err));
+    }
+    return err;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t power_manager_light_sleep_disable(void)
+{
+#if POWER_LIGHT_SLEEP_SUPPORTED
+    const esp_pm_config_t pm = {
+        .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+        .light_sleep_enable = false,
+    };
+    return esp_pm_configure(&pm);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void power_manager_note_battery(uint16_t mv)
+{
+#if CONFIG_APP_BATTERY_MONITOR
+    if (mv == 0U) {
+        return;
+    }
+
+    const power_batt_tier_t cur = power_manager_battery_tier();
+    power_batt_tier_t tier = power_batt_tier_for(mv);
+    if (tier < cur) {
+        tier = MIN(cur, power_batt_tier_for((mv > POWER_BATT_HYST_MV) ? (mv - POWER_BATT_HYST_MV) : 0U));
+    }
+
+    if ((s_rtc_batt.magic != POWER_BATT_MAGIC) || (tier != cur)) {
+        ESP_LOGI(TAG, "battery %u mV: tier %u -> %u", (unsigned)mv, (unsigned)cur, (unsigned)tier);
+        APP_RLOG(BATTERY, mv, (uint32_t)cur, (uint32_t)tier);
+        s_rtc_batt.wake_count = 0U;
+    }
+    s_rtc_batt.magic = POWER_BATT_MAGIC;
+    s_rtc_batt.mv = mv;
+    s_rtc_batt.tier = (uint8_t)tier;
+#else
+    (void)mv;
+#endif
+}
+
+power_batt_tier_t power_manager_battery_tier(void)
+{
+#if CONFIG_APP_BATTERY_MONITOR
+    if ((s_rtc_batt.magic != POWER_BATT_MAGIC) || (s_rtc_batt.tier >= POWER_BATT_TIER_COUNT)) {
+        return POWER_BATT_NORMAL;
+    }
+    return (power_batt_tier_t)s_rtc_batt.tier;
+#else
+    return POWER_BATT_NORMAL;
+#endif
+}
+
+bool power_manager_display_allowed(void)
+{
+    return power_manager_battery_tier() == POWER_BATT_NORMAL;
+}
+
+bool power_manager_flash_write_allowed(void)
+{
+    return power_manager_battery_tier() != POWER_BATT_CUTOFF;
+}
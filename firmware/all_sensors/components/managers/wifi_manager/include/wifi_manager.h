@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -12,4 +13,22 @@
 esp_err_t wifi_manager_init(void);
 esp_err_t wifi_manager_start(void);
 void wifi_manager_stop(void);
+
+// Switches between max modem sleep and the modem sleep used for active wakes
+// while staying associated. Both come from the link quality seen on earlier
+// wakes, as does the TX power. Only valid once started.
+esp_err_t wifi_manager_set_power_save(bool enable);
+
+// Call once per wake before starting Wi-Fi. True while the AP is considered
+// down after repeated failed wakes; each call counts one skipped wake.
+bool wifi_manager_backoff_should_skip(void);
+// Posts APP_EVENT_TIME_SYNC_DONE right away when the clock is still trusted,
+// otherwise once SNTP answers.
 esp_err_t wifi_manager_request_time_sync(void);
+
+// Call once per wake before using the clock. Applies the learned RTC drift and
+// marks time as synced while the estimated error stays within budget.
+bool wifi_manager_time_restore(void);
+
+// True when the clock was set by SNTP since power-on, even if it is due for a resync.
+bool wifi_manager_time_is_valid(void);
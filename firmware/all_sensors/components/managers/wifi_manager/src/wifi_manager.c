@@ -1,13 +1,21 @@
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/param.h>
 #include <sys/time.h>
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
 #include "esp_check.h"
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
 #include "esp_sntp.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
+#include "app_backoff.h"
 #include "app_context.h"
+#include "app_rtc_log.h"
 #include "app_events.h"
 #include "fsm_manager.h"
 #include "wifi_manager.h"
@@ -16,6 +24,64 @@
    SECTION: Constants
    ========================================================================= */
 #define WIFI_MAX_RETRY 5
+#define WIFI_PROBE_RETRY 1            // while backing off, one attempt is enough to tell
+#define WIFI_BACKOFF_THRESHOLD 2U     // failed wakes before wakes start being skipped
+#define WIFI_BACKOFF_MAX_SKIP  32U    // at most ~5 h without trying at 10 min wakes
+
+#define WIFI_FAST_CACHE_MAGIC    0x57464331UL   // "WFC1"
+// Reuse the cached lease this many times before doing DHCP again, so an
+// address the router handed to someone else is not kept forever.
+#define WIFI_FAST_MAX_USES       36U
+
+#define WIFI_TIME_STATE_MAGIC    0x54494D31UL   // "TIM1"
+#define WIFI_TIME_MIN_VALID_S    1700000000LL   // anything earlier was never set
+#define WIFI_TIME_DEFAULT_DRIFT_PPM  1000     // uncompensated RTC slow clock, worst case
+#define WIFI_TIME_DRIFT_MARGIN_PPM   100      // residual error once drift is compensated
+#define WIFI_TIME_MIN_DRIFT_SPAN_S   1800     // shorter spans are dominated by SNTP jitter
+
+#define WIFI_LINK_MAGIC          0x574C4B31UL   // "WLK1"
+// TX power in esp_wifi units of 0.25 dBm.
+#define WIFI_TX_POWER_MAX        80             // 20 dBm, driver default
+#define WIFI_TX_POWER_MIN        34             // 8.5 dBm, lowest PHY step
+#define WIFI_TX_POWER_STEP       8              // 2 dBm per wake
+// The AP has to be heard this much above the floor before TX power is cut,
+// assuming a roughly symmetric link.
+#define WIFI_RSSI_FLOOR_DBM      (-70)
+#define WIFI_LINK_MARGIN_DB      10
+#define WIFI_RSSI_STRONG_DBM     (-60)
+#define WIFI_RSSI_WEAK_DBM       (-75)
+#define WIFI_CLEAN_WAKES_TO_CUT  2U             // first-try connects before lowering TX power
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef struct {
+    uint32_t magic;
+    uint32_t cred_hash;          // SSID + password the entry was learned with
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t uses;                // fast connects since last DHCP
+    esp_netif_ip_info_t ip_info; // ip, netmask, gateway
+    esp_ip4_addr_t dns;
+} wifi_fast_cache_t;
+
+typedef struct {
+    uint32_t magic;
+    int64_t last_sync_us;        // unix time of the last SNTP sync
+    int64_t last_adjust_us;      // unix time drift compensation was last applied
+    int32_t drift_ppm;           // RTC error rate, positive = RTC runs slow
+    bool drift_known;
+} wifi_time_state_t;
+
+typedef struct {
+    uint32_t magic;
+    int8_t rssi_avg;             // dBm, EMA over connected wakes
+    int8_t rssi_last;            // dBm, this wake
+    int8_t tx_power;             // 0.25 dBm units
+    uint8_t listen_interval;     // beacons between wakes in max modem sleep
+    uint8_t retries_last;        // reconnect attempts the last connect needed
+    uint8_t clean_wakes;         // consecutive first-try connects
+} wifi_link_state_t;
 
 /* =========================================================================
    SECTION: Static Data
@@ -28,18 +94,279 @@ static int s_retry_num;
 static esp_netif_t *s_sta_netif;
 static esp_event_handler_instance_t s_any_id_handler;
 static esp_event_handler_instance_t s_got_ip_handler;
+static bool s_fast_attempt;
+static uint8_t s_connect_retries;
+
+// Kept across deep sleep; a cold boot starts with a full scan and DHCP.
+RTC_DATA_ATTR static wifi_fast_cache_t s_rtc_fast;
+RTC_DATA_ATTR static wifi_time_state_t s_rtc_time;
+RTC_DATA_ATTR static app_backoff_t s_rtc_backoff;
+RTC_DATA_ATTR static wifi_link_state_t s_rtc_link;
+
+// System/monotonic clock pair taken when SNTP is started, used to tell how far
+// the RTC-kept time was off once the server answers.
+static int64_t s_sntp_ref_sys_us;
+static int64_t s_sntp_ref_mono_us;
 
 /* =========================================================================
    SECTION: Helpers
    ========================================================================= */
+static int64_t time_now_us(void)
+{
+    struct timeval tv = {0};
+    (void)gettimeofday(&tv, NULL);
+    return ((int64_t)tv.tv_sec * 1000000LL) + (int64_t)tv.tv_usec;
+}
+
+static bool time_state_valid(void)
+{
+    return (s_rtc_time.magic == WIFI_TIME_STATE_MAGIC) &&
+           (s_rtc_time.last_sync_us >= (WIFI_TIME_MIN_VALID_S * 1000000LL));
+}
+
+static uint32_t time_uncertainty_ms(int64_t now_us)
+{
+    int64_t since_sync_us = now_us - s_rtc_time.last_sync_us;
+    if (since_sync_us < 0) {
+        since_sync_us = -since_sync_us;
+    }
+    const int64_t ppm = s_rtc_time.drift_known ? WIFI_TIME_DRIFT_MARGIN_PPM : WIFI_TIME_DEFAULT_DRIFT_PPM;
+    const int64_t unc_ms = (since_sync_us / 1000LL) * ppm / 1000000LL;
+    return (unc_ms > (int64_t)UINT32_MAX) ? UINT32_MAX : (uint32_t)unc_ms;
+}
+
+// Compare SNTP time with where our clock would be without the sync and fold
+// the error into the drift estimate.
+static void time_update_drift(int64_t actual_us)
+{
+    const int64_t predicted_us = s_sntp_ref_sys_us + (esp_timer_get_time() - s_sntp_ref_mono_us);
+
+    if (time_state_valid()) {
+        const int64_t span_us = predicted_us - s_rtc_time.last_sync_us;
+        if (span_us >= (WIFI_TIME_MIN_DRIFT_SPAN_S * 1000000LL)) {
+            // Residual on top of the compensation already applied during the span.
+            const int32_t residual_ppm = (int32_t)(((actual_us - predicted_us) * 1000000LL) / span_us);
+            if (s_rtc_time.drift_known) {
+                s_rtc_time.drift_ppm += residual_ppm / 2;
+            } else {
+                s_rtc_time.drift_ppm = residual_ppm;
+                s_rtc_time.drift_known = true;
+            }
+            ESP_LOGI(TAG, "clock error %lld ms over %lld s, drift=%ld ppm",
+                     (long long)((actual_us - predicted_us) / 1000LL), (long long)(span_us / 1000000LL),
+                     (long)s_rtc_time.drift_ppm);
+        }
+    } else {
+        memset(&s_rtc_time, 0, sizeof(s_rtc_time));
+    }
+
+    s_rtc_time.last_sync_us = actual_us;
+    s_rtc_time.last_adjust_us = actual_us;
+    s_rtc_time.magic = WIFI_TIME_STATE_MAGIC;
+}
+
 static void sntp_sync_cb(struct timeval *tv)
 {
-    (void)tv;
+    const int64_t actual_us = (tv != NULL) ? (((int64_t)tv->tv_sec * 1000000LL) + (int64_t)tv->tv_usec)
+                                           : time_now_us();
+    time_update_drift(actual_us);
     app_context_set_time_synced(true);
     (void)fsm_manager_post_event(APP_EVENT_TIME_SYNC_DONE, NULL, 0, 0);
     ESP_LOGI(TAG, "time sync done");
 }
 
+static uint32_t wifi_cred_hash(const config_t *cfg)
+{
+    // FNV-1a over SSID and password
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; (i < sizeof(cfg->ssid)) && (cfg->ssid[i] != '\0'); ++i) {
+        hash = (hash ^ (uint8_t)cfg->ssid[i]) * 16777619UL;
+    }
+    hash = (hash ^ 0xFFU) * 16777619UL;
+    for (size_t i = 0; (i < sizeof(cfg->passwd)) && (cfg->passwd[i] != '\0'); ++i) {
+        hash = (hash ^ (uint8_t)cfg->passwd[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+static bool wifi_fast_cache_usable(uint32_t cred_hash)
+{
+    return (s_rtc_fast.magic == WIFI_FAST_CACHE_MAGIC) &&
+           (s_rtc_fast.cred_hash == cred_hash) &&
+           (s_rtc_fast.channel != 0U) &&
+           (s_rtc_fast.uses < WIFI_FAST_MAX_USES) &&
+           (s_rtc_fast.ip_info.ip.addr != 0U);
+}
+
+static void wifi_fast_cache_invalidate(void)
+{
+    memset(&s_rtc_fast, 0, sizeof(s_rtc_fast));
+}
+
+// Pin BSSID/channel and apply the cached lease as a static address.
+static esp_err_t wifi_fast_apply(wifi_config_t *wifi_cfg)
+{
+    esp_err_t err = esp_netif_dhcpc_stop(s_sta_netif);
+    if ((err != ESP_OK) && (err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED)) {
+        return err;
+    }
+    ESP_RETURN_ON_ERROR(esp_netif_set_ip_info(s_sta_netif, &s_rtc_fast.ip_info), TAG, "static ip");
+
+    esp_netif_dns_info_t dns = {0};
+    dns.ip.type = ESP_IPADDR_TYPE_V4;
+    dns.ip.u_addr.ip4 = s_rtc_fast.dns;
+    (void)esp_netif_set_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+
+    memcpy(wifi_cfg->sta.bssid, s_rtc_fast.bssid, sizeof(wifi_cfg->sta.bssid));
+    wifi_cfg->sta.bssid_set = true;
+    wifi_cfg->sta.channel = s_rtc_fast.channel;
+    wifi_cfg->sta.scan_method = WIFI_FAST_SCAN;
+    return ESP_OK;
+}
+
+static void wifi_dhcp_enable(void)
+{
+    esp_err_t err = esp_netif_dhcpc_start(s_sta_netif);
+    if ((err != ESP_OK) && (err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED)) {
+        ESP_LOGW(TAG, "dhcp start failed (%s)", esp_err_to_name(err));
+    }
+}
+
+// Fast connect failed once: forget the cache and do a regular scan + DHCP.
+static void wifi_fast_fallback(void)
+{
+    ESP_LOGW(TAG, "fast connect failed, full scan + dhcp");
+    s_fast_attempt = false;
+    wifi_fast_cache_invalidate();
+
+    wifi_config_t wifi_cfg = {0};
+    if (esp_wifi_get_config(WIFI_IF_STA, &wifi_cfg) == ESP_OK) {
+        wifi_cfg.sta.bssid_set = false;
+        wifi_cfg.sta.channel = 0;
+        wifi_cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        (void)esp_wifi_set_config(WIFI_IF_STA, &wifi_cfg);
+    }
+    wifi_dhcp_enable();
+    (void)esp_wifi_connect();
+}
+
+static void wifi_fast_cache_learn(void)
+{
+    if (s_fast_attempt) {
+        s_rtc_fast.uses++;
+        return;
+    }
+
+    config_t cfg = {0};
+    wifi_ap_record_t ap = {0};
+    esp_netif_ip_info_t ip_info = {0};
+    esp_netif_dns_info_t dns = {0};
+    if ((app_context_get_config(&cfg) != ESP_OK) ||
+        (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) ||
+        (esp_netif_get_ip_info(s_sta_netif, &ip_info) != ESP_OK)) {
+        wifi_fast_cache_invalidate();
+        return;
+    }
+    (void)esp_netif_get_dns_info(s_sta_netif, ESP_NETIF_DNS_MAIN, &dns);
+
+    s_rtc_fast.cred_hash = wifi_cred_hash(&cfg);
+    memcpy(s_rtc_fast.bssid, ap.bssid, sizeof(s_rtc_fast.bssid));
+    s_rtc_fast.channel = ap.primary;
+    s_rtc_fast.uses = 0;
+    s_rtc_fast.ip_info = ip_info;
+    s_rtc_fast.dns = dns.ip.u_addr.ip4;
+    s_rtc_fast.magic = WIFI_FAST_CACHE_MAGIC;
+}
+
+static void wifi_link_ensure(void)
+{
+    if (s_rtc_link.magic == WIFI_LINK_MAGIC) {
+        return;
+    }
+    memset(&s_rtc_link, 0, sizeof(s_rtc_link));
+    s_rtc_link.rssi_avg = WIFI_RSSI_FLOOR_DBM;
+    s_rtc_link.tx_power = WIFI_TX_POWER_MAX;
+    s_rtc_link.listen_interval = 1U;
+    s_rtc_link.magic = WIFI_LINK_MAGIC;
+}
+
+// Weak links stay awake during the short wake; a missed frame costs a
+// retransmission, which is dearer than the few ms of modem sleep saved.
+static wifi_ps_type_t wifi_link_active_ps(void)
+{
+    const bool weak = (s_rtc_link.rssi_avg < WIFI_RSSI_WEAK_DBM) || (s_rtc_link.retries_last > 1U);
+    return weak ? WIFI_PS_NONE : WIFI_PS_MIN_MODEM;
+}
+
+static void wifi_link_apply_tx_power(void)
+{
+    esp_err_t err = esp_wifi_set_max_tx_power(s_rtc_link.tx_power);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "set tx power failed (%s)", esp_err_to_name(err));
+    }
+}
+
+// Fold this connect into the link statistics and pick the settings for the
+// next wake: TX power walks down while the link is clean and has margin, and
+// jumps back up on any reconnect.
+static void wifi_link_learn(void)
+{
+    wifi_ap_record_t ap = {0};
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+
+    wifi_link_ensure();
+    if (s_rtc_link.rssi_last == 0) {
+        s_rtc_link.rssi_avg = ap.rssi;   // first connect since power-on seeds the average
+    }
+    s_rtc_link.rssi_last = ap.rssi;
+    s_rtc_link.rssi_avg = (int8_t)(((int)s_rtc_link.rssi_avg * 3 + (int)ap.rssi) / 4);
+    s_rtc_link.retries_last = s_connect_retries;
+
+    if (s_connect_retries > 0U) {
+        s_rtc_link.clean_wakes = 0U;
+        s_rtc_link.tx_power = (int8_t)MIN(s_rtc_link.tx_power + 2 * WIFI_TX_POWER_STEP, WIFI_TX_POWER_MAX);
+    } else {
+        if (s_rtc_link.clean_wakes < UINT8_MAX) {
+            s_rtc_link.clean_wakes++;
+        }
+        const int headroom_db = (int)s_rtc_link.rssi_avg - WIFI_RSSI_FLOOR_DBM - WIFI_LINK_MARGIN_DB;
+        const int tx_floor = MAX(WIFI_TX_POWER_MAX - MAX(headroom_db, 0) * 4, WIFI_TX_POWER_MIN);
+        if ((s_rtc_link.clean_wakes >= WIFI_CLEAN_WAKES_TO_CUT) && (s_rtc_link.tx_power > tx_floor)) {
+            s_rtc_link.tx_power = (int8_t)MAX(s_rtc_link.tx_power - WIFI_TX_POWER_STEP, tx_floor);
+        } else if (s_rtc_link.tx_power < tx_floor) {
+            s_rtc_link.tx_power = (int8_t)tx_floor;   // margin shrank since the last cut
+        }
+    }
+
+    if (s_rtc_link.rssi_avg >= WIFI_RSSI_STRONG_DBM) {
+        s_rtc_link.listen_interval = 3U;
+    } else if (s_rtc_link.rssi_avg >= WIFI_RSSI_FLOOR_DBM) {
+        s_rtc_link.listen_interval = 2U;
+    } else {
+        s_rtc_link.listen_interval = 1U;
+    }
+
+    APP_RLOG(WIFI_LINK, (int32_t)ap.rssi, s_connect_retries, s_rtc_link.tx_power);
+    ESP_LOGI(TAG, "link rssi=%d avg=%d retries=%u -> tx=%d.%02d dBm li=%u",
+             (int)ap.rssi, (int)s_rtc_link.rssi_avg, (unsigned)s_connect_retries,
+             s_rtc_link.tx_power / 4, (s_rtc_link.tx_power % 4) * 25, (unsigned)s_rtc_link.listen_interval);
+}
+
+static void wifi_link_on_failure(void)
+{
+    wifi_link_ensure();
+    s_rtc_link.tx_power = WIFI_TX_POWER_MAX;
+    s_rtc_link.clean_wakes = 0U;
+    s_rtc_link.retries_last = s_connect_retries;
+}
+
+static int wifi_max_retry(void)
+{
+    return (s_rtc_backoff.failures > 0U) ? WIFI_PROBE_RETRY : WIFI_MAX_RETRY;
+}
+
 static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
 {
     (void)arg;
@@ -53,10 +380,23 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t e
                 break;
             case WIFI_EVENT_STA_DISCONNECTED:
                 app_context_set_wifi_connected(false);
-                if (s_started && s_retry_num < WIFI_MAX_RETRY) {
+                if (s_started && s_fast_attempt) {
+                    // Stale cache, not a link problem; not counted as a retry.
+                    wifi_fast_fallback();
+                } else if (s_started && s_retry_num < wifi_max_retry()) {
                     s_retry_num++;
+                    if (s_connect_retries < UINT8_MAX) {
+                        s_connect_retries++;
+                    }
                     (void)esp_wifi_connect();
                 } else {
+                    if (s_started) {
+                        wifi_link_on_failure();
+                        APP_RLOG(WIFI_FAIL, s_connect_retries, 0, 0);
+                        app_backoff_on_failure(&s_rtc_backoff, WIFI_BACKOFF_THRESHOLD, WIFI_BACKOFF_MAX_SKIP);
+                        ESP_LOGW(TAG, "connect failed, failures=%u skip next %u wakes",
+                                 (unsigned)s_rtc_backoff.failures, (unsigned)s_rtc_backoff.skip_left);
+                    }
                     (void)fsm_manager_post_event(APP_EVENT_WIFI_DISCONNECTED, NULL, 0, 0);
                 }
                 break;
@@ -68,6 +408,10 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base, int32_t e
 
     if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         s_retry_num = 0;
+        app_backoff_on_success(&s_rtc_backoff);
+        wifi_fast_cache_learn();
+        wifi_link_learn();
+        s_connect_retries = 0U;
         app_context_set_wifi_connected(true);
         (void)fsm_manager_post_event(APP_EVENT_WIFI_CONNECTED, NULL, 0, 0);
     }
@@ -137,6 +481,12 @@ esp_err_t wifi_manager_start(void)
 {
     ESP_RETURN_ON_ERROR(wifi_manager_init(), TAG, "init");
 
+    if (s_started && app_context_is_wifi_connected()) {
+        // Stayed associated through a connected sleep, nothing to redo.
+        (void)fsm_manager_post_event(APP_EVENT_WIFI_CONNECTED, NULL, 0, 0);
+        return ESP_OK;
+    }
+
     config_t cfg = {0};
     if (app_context_get_config(&cfg) != ESP_OK) {
         ESP_LOGW(TAG, "config unavailable");
@@ -151,6 +501,21 @@ esp_err_t wifi_manager_start(void)
     wifi_config_t wifi_cfg = {0};
     (void)strncpy((char *)wifi_cfg.sta.ssid, cfg.ssid, sizeof(wifi_cfg.sta.ssid) - 1U);
     (void)strncpy((char *)wifi_cfg.sta.password, cfg.passwd, sizeof(wifi_cfg.sta.password) - 1U);
+    wifi_link_ensure();
+    wifi_cfg.sta.listen_interval = s_rtc_link.listen_interval;
+
+    s_fast_attempt = false;
+    s_connect_retries = 0U;
+    if (!s_started && wifi_fast_cache_usable(wifi_cred_hash(&cfg))) {
+        if (wifi_fast_apply(&wifi_cfg) == ESP_OK) {
+            s_fast_attempt = true;
+            ESP_LOGI(TAG, "fast connect ch=%u " IPSTR, (unsigned)s_rtc_fast.channel,
+                     IP2STR(&s_rtc_fast.ip_info.ip));
+        }
+    }
+    if (!s_fast_attempt) {
+        wifi_dhcp_enable();
+    }
 
     ESP_RETURN_ON_ERROR(esp_wifi_set_mode(WIFI_MODE_STA), TAG, "set mode");
     ESP_RETURN_ON_ERROR(esp_wifi_set_config(WIFI_IF_STA, &wifi_cfg), TAG, "set config");
@@ -165,6 +530,9 @@ esp_err_t wifi_manager_start(void)
     }
 
     ESP_RETURN_ON_ERROR(esp_wifi_start(), TAG, "start");
+    // Both need the driver started; the connect itself runs from STA_START.
+    wifi_link_apply_tx_power();
+    (void)esp_wifi_set_ps(wifi_link_active_ps());
 
     app_context_set_wifi_connected(false);
     s_started = true;
@@ -181,9 +549,24 @@ void wifi_manager_stop(void)
     (void)esp_wifi_stop();
     app_context_set_wifi_connected(false);
     s_started = false;
+    s_fast_attempt = false;
     ESP_LOGI(TAG, "wifi stop");
 }
 
+esp_err_t wifi_manager_set_power_save(bool enable)
+{
+    if (!s_started) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Max modem sleep honours the learned listen interval; otherwise back to
+    // the policy used for active wakes.
+    const wifi_ps_type_t ps = enable ? WIFI_PS_MAX_MODEM : wifi_link_active_ps();
+    ESP_RETURN_ON_ERROR(esp_wifi_set_ps(ps), TAG, "set ps");
+    ESP_LOGI(TAG, "power save %d, listen interval %u", (int)ps, (unsigned)s_rtc_link.listen_interval);
+    return ESP_OK;
+}
+
 esp_err_t wifi_manager_request_time_sync(void)
 {
     if (!app_context_is_wifi_connected()) {
@@ -192,6 +575,8 @@ esp_err_t wifi_manager_request_time_sync(void)
     }
 
     if (app_context_is_time_synced()) {
+        // Clock restored from RTC is still within budget, no SNTP round trip.
+        (void)fsm_manager_post_event(APP_EVENT_TIME_SYNC_DONE, NULL, 0, 0);
         return ESP_OK;
     }
 
@@ -199,6 +584,9 @@ esp_err_t wifi_manager_request_time_sync(void)
         return ESP_OK;
     }
 
+    s_sntp_ref_sys_us = time_now_us();
+    s_sntp_ref_mono_us = esp_timer_get_time();
+
     sntp_setoperatingmode(SNTP_OPMODE_POLL);
     sntp_setservername(0, "pool.ntp.org");
     sntp_set_time_sync_notification_cb(sntp_sync_cb);
@@ -208,3 +596,50 @@ esp_err_t wifi_manager_request_time_sync(void)
     ESP_LOGI(TAG, "sntp start");
     return ESP_OK;
 }
+
+bool wifi_manager_time_restore(void)
+{
+    if (!time_state_valid()) {
+        app_context_set_time_synced(false);
+        return false;
+    }
+
+    int64_t now_us = time_now_us();
+    if (now_us < s_rtc_time.last_adjust_us) {
+        // Clock went backwards, RTC domain was reset; treat as never synced.
+        memset(&s_rtc_time, 0, sizeof(s_rtc_time));
+        app_context_set_time_synced(false);
+        return false;
+    }
+
+    if (s_rtc_time.drift_known) {
+        now_us += ((now_us - s_rtc_time.last_adjust_us) * (int64_t)s_rtc_time.drift_ppm) / 1000000LL;
+        const struct timeval tv = {
+            .tv_sec = (time_t)(now_us / 1000000LL),
+            .tv_usec = (suseconds_t)(now_us % 1000000LL),
+        };
+        (void)settimeofday(&tv, NULL);
+        s_rtc_time.last_adjust_us = now_us;
+    }
+
+    const uint32_t unc_ms = time_uncertainty_ms(now_us);
+    const bool within_budget = (unc_ms <= (uint32_t)CONFIG_APP_TIME_MAX_UNCERTAINTY_MS);
+    app_context_set_time_synced(within_budget);
+    ESP_LOGI(TAG, "time restored, uncertainty=%lu ms drift=%ld ppm%s", (unsigned long)unc_ms,
+             (long)s_rtc_time.drift_ppm, within_budget ? "" : " -> resync");
+    return within_budget;
+}
+
+bool wifi_manager_time_is_valid(void)
+{
+    return time_state_valid() && (time(NULL) >= (time_t)WIFI_TIME_MIN_VALID_S);
+}
+
+bool wifi_manager_backoff_should_skip(void)
+{
+    if (!app_backoff_should_skip(&s_rtc_backoff)) {
+        return false;
+    }
+    ESP_LOGI(TAG, "backing off, %u wakes left", (unsigned)s_rtc_backoff.skip_left);
+    return true;
+}
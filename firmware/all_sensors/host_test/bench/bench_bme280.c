@@ -0,0 +1,149 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "bme280.h"
+
+// Cost of one BME280 reading from raw ADC words to sensor_data_t units,
+// three ways: the integer path the firmware uses, the same with the hPa float
+// telemetry used to carry, and the datasheet double formulas. Host numbers
+// only rank the variants; on the ESP32 double is software-emulated, so the
+// gap there is far wider. Also counts readings the float hPa field could not
+// carry exactly. Prints only; nothing here fails.
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define BENCH_ROUNDS      200
+#define BENCH_ADC_T_FIRST 400000
+#define BENCH_ADC_T_STEP    1024
+#define BENCH_ADC_P_FIRST 300000
+#define BENCH_ADC_P_STEP     512
+#define BENCH_POINTS       256      // per axis
+#define CENTI_C_ZERO_K     27315
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+// BMP280 datasheet section 3.12 trimming.
+static struct bme280_calib_data s_calib = {
+    .dig_t1 = 27504U, .dig_t2 = 26435, .dig_t3 = -1000,
+    .dig_p1 = 36477U, .dig_p2 = -10685, .dig_p3 = 3024, .dig_p4 = 2855, .dig_p5 = 140,
+    .dig_p6 = -7, .dig_p7 = 15500, .dig_p8 = -14600, .dig_p9 = 6000,
+};
+
+static volatile uint32_t s_sink;
+
+/* =========================================================================
+   SECTION: Variants
+   ========================================================================= */
+static uint32_t read_fixed(const struct bme280_uncomp_data *raw)
+{
+    struct bme280_data out;
+    (void)bme280_compensate_data(BME280_PRESS | BME280_TEMP, raw, &out, &s_calib);
+    const uint16_t dk = (uint16_t)(((uint32_t)(out.temperature + CENTI_C_ZERO_K) + 5U) / 10U);
+    return dk ^ out.pressure;
+}
+
+static uint32_t read_float_hpa(const struct bme280_uncomp_data *raw)
+{
+    struct bme280_data out;
+    (void)bme280_compensate_data(BME280_PRESS | BME280_TEMP, raw, &out, &s_calib);
+    const uint16_t dk = (uint16_t)(((uint32_t)(out.temperature + CENTI_C_ZERO_K) + 5U) / 10U);
+    const float hpa = (float)out.pressure / 10000.0f;
+    uint32_t bits;
+    __builtin_memcpy(&bits, &hpa, sizeof(bits));
+    return dk ^ bits;
+}
+
+// Datasheet section 8.1 floating point compensation.
+static uint32_t read_double(const struct bme280_uncomp_data *raw)
+{
+    const struct bme280_calib_data *c = &s_calib;
+    double var1 = ((double)raw->temperature / 16384.0 - (double)c->dig_t1 / 1024.0) * (double)c->dig_t2;
+    double var2 = (double)raw->temperature / 131072.0 - (double)c->dig_t1 / 8192.0;
+    var2 = var2 * var2 * (double)c->dig_t3;
+    const double t_fine = var1 + var2;
+    const double temp_c = t_fine / 5120.0;
+
+    var1 = t_fine / 2.0 - 64000.0;
+    var2 = var1 * var1 * (double)c->dig_p6 / 32768.0;
+    var2 = var2 + var1 * (double)c->dig_p5 * 2.0;
+    var2 = var2 / 4.0 + (double)c->dig_p4 * 65536.0;
+    var1 = ((double)c->dig_p3 * var1 * var1 / 524288.0 + (double)c->dig_p2 * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * (double)c->dig_p1;
+    double pa = 1048576.0 - (double)raw->pressure;
+    pa = (pa - var2 / 4096.0) * 6250.0 / var1;
+    var1 = (double)c->dig_p9 * pa * pa / 2147483648.0;
+    var2 = pa * (double)c->dig_p8 / 32768.0;
+    pa = pa + (var1 + var2 + (double)c->dig_p7) / 16.0;
+
+    const uint16_t dk = (uint16_t)lround((temp_c + 273.15) * 10.0);
+    return dk ^ (uint32_t)lround(pa * 100.0);
+}
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void raw_at(uint32_t i, struct bme280_uncomp_data *raw)
+{
+    raw->temperature = BENCH_ADC_T_FIRST + (i / BENCH_POINTS) * BENCH_ADC_T_STEP;
+    raw->pressure = BENCH_ADC_P_FIRST + (i % BENCH_POINTS) * BENCH_ADC_P_STEP;
+    raw->humidity = 0U;
+}
+
+static double bench(const char *name, uint32_t (*read)(const struct bme280_uncomp_data *))
+{
+    const uint32_t n = BENCH_POINTS * BENCH_POINTS;
+    uint32_t acc = 0;
+    const double t0 = now_ns();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; ++r) {
+        for (uint32_t i = 0; i < n; ++i) {
+            struct bme280_uncomp_data raw;
+            raw_at(i, &raw);
+            acc += read(&raw);
+        }
+    }
+    const double ns = (now_ns() - t0) / ((double)n * BENCH_ROUNDS);
+    s_sink = acc;
+    printf("%-10s %7.1f ns/reading\n", name, ns);
+    return ns;
+}
+
+/* =========================================================================
+   SECTION: Main
+   ========================================================================= */
+int main(void)
+{
+    // Readings a hPa float could not hold to the 0.01 Pa the sensor gives.
+    uint32_t lossy = 0;
+    uint32_t max_err_cpa = 0;
+    for (uint32_t i = 0; i < BENCH_POINTS * BENCH_POINTS; ++i) {
+        struct bme280_uncomp_data raw;
+        struct bme280_data out;
+        raw_at(i, &raw);
+        (void)bme280_compensate_data(BME280_PRESS | BME280_TEMP, &raw, &out, &s_calib);
+        const float hpa = (float)out.pressure / 10000.0f;
+        const uint32_t back = (uint32_t)lroundf(hpa * 10000.0f);
+        const uint32_t err = (back > out.pressure) ? (back - out.pressure) : (out.pressure - back);
+        if (err != 0U) {
+            lossy++;
+            max_err_cpa = (err > max_err_cpa) ? err : max_err_cpa;
+        }
+    }
+    printf("float hPa round trip: %u of %u readings off, up to %u x 0.01 Pa\n",
+           (unsigned)lossy, (unsigned)(BENCH_POINTS * BENCH_POINTS), (unsigned)max_err_cpa);
+
+    const double fixed_ns = bench("fixed", read_fixed);
+    (void)bench("float hPa", read_float_hpa);
+    const double double_ns = bench("double", read_double);
+    printf("double / fixed: %.2fx\n", double_ns / fixed_ns);
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "bsp_bus.h"
+#include "bsp_init.h"
+#include "ssd1306.h"
+#include "host_idf.h"
+#include "host_bus.h"
+#include "host_check.h"
+#include "ssd1306_model.h"
+
+// Bytes the SSD1306 driver puts on the bus per typical screen update, with
+// the panel checked after each one: it must match the same screen drawn by
+// a freshly created driver, which flushes the whole frame. The byte counts
+// are deterministic, so they double as a regression budget.
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+typedef void (*screen_fn_t)(ssd1306_handle_t disp);
+
+typedef struct {
+    const char *name;
+    screen_fn_t update;     // what the caller draws for this step
+    screen_fn_t whole;      // the complete screen after it
+    uint32_t budget;        // bytes, control bytes included, address excluded
+} bench_step_t;
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static host_bus_t s_bus;
+static ssd1306_model_t s_oled;
+static i2c_master_bus_handle_t s_i2c;
+
+/* =========================================================================
+   SECTION: Screens
+   ========================================================================= */
+// Redrawn the way app_display does it: clear, then every line.
+static void sensing_screen(ssd1306_handle_t disp, const char *soil_line)
+{
+    (void)ssd1306_clear(disp);
+    (void)ssd1306_draw_text(disp, soil_line, 0, 0);
+    (void)ssd1306_draw_text(disp, "Temp:21.5C", 0, 2);
+    (void)ssd1306_draw_text(disp, "Pres:1013.2hPa", 0, 4);
+}
+
+static void screen_none(ssd1306_handle_t disp)
+{
+    (void)disp;
+}
+
+static void screen_sensing(ssd1306_handle_t disp)
+{
+    sensing_screen(disp, "Lux:1 Soil:40%");
+}
+
+static void screen_one_digit(ssd1306_handle_t disp)
+{
+    sensing_screen(disp, "Lux:1 Soil:41%");
+}
+
+static void update_label(ssd1306_handle_t disp)
+{
+    (void)ssd1306_draw_button_label_left(disp, "OK");
+}
+
+static void screen_label(ssd1306_handle_t disp)
+{
+    screen_one_digit(disp);
+    update_label(disp);
+}
+
+static void screen_full(ssd1306_handle_t disp)
+{
+    (void)ssd1306_fill_rect(disp, 0, 0, SSD1306_MODEL_COLS, SSD1306_MODEL_PAGES * 8U, true);
+}
+
+// Budgets are the sizes when partial flush went in. The harness used then
+// also counted each transfer's address byte (331, 17, 33, 1034).
+static const bench_step_t s_steps[] = {
+    { "sensing screen from blank", screen_sensing, screen_sensing, 325U },
+    { "one digit changed", screen_one_digit, screen_one_digit, 15U },
+    { "button label", update_label, screen_label, 31U },
+    { "whole panel lit", screen_full, screen_full, 1032U },
+    { "no change", screen_none, screen_full, 0U },
+};
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+// Power-on RAM is undefined; a pattern shows any region create() skipped.
+static ssd1306_handle_t fresh_panel(void)
+{
+    host_bus_init(&s_bus);
+    ssd1306_model_init(&s_oled, BSP_I2C_BUS_DISPLAY);
+    memset(s_oled.gddram, 0xA5, sizeof(s_oled.gddram));
+    (void)host_bus_attach(&s_bus, &s_oled.base);
+    bsp_bus_set_backend(&s_bus.backend);
+
+    ssd1306_handle_t disp = NULL;
+    HOST_CHECK_EQ(ssd1306_create(s_i2c, &disp), ESP_OK);
+    return disp;
+}
+
+// Panel RAM after `whole` is drawn on a just-created driver.
+static void render_expected(screen_fn_t whole, uint8_t out[SSD1306_MODEL_PAGES][SSD1306_MODEL_COLS])
+{
+    ssd1306_handle_t disp = fresh_panel();
+    whole(disp);
+    HOST_CHECK_EQ(ssd1306_flush(disp), ESP_OK);
+    memcpy(out, s_oled.gddram, sizeof(s_oled.gddram));
+    ssd1306_destroy(disp);
+}
+
+/* =========================================================================
+   SECTION: Main
+   ========================================================================= */
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_ERROR);
+
+    host_bus_init(&s_bus);
+    bsp_bus_set_backend(&s_bus.backend);
+    HOST_CHECK_EQ(bsp_init(), ESP_OK);
+    HOST_CHECK_EQ(bsp_i2c_bus_acquire(BSP_I2C_BUS_DISPLAY, &s_i2c), ESP_OK);
+
+    const size_t step_count = sizeof(s_steps) / sizeof(s_steps[0]);
+    static uint8_t expected[sizeof(s_steps) / sizeof(s_steps[0])][SSD1306_MODEL_PAGES][SSD1306_MODEL_COLS];
+    for (size_t i = 0; i < step_count; ++i) {
+        render_expected(s_steps[i].whole, expected[i]);
+    }
+
+    printf("%-26s %6s %6s %8s\n", "update", "bytes", "xfers", "wire us");
+    ssd1306_handle_t disp = fresh_panel();
+    HOST_CHECK_EQ(ssd1306_model_lit(&s_oled, 0, SSD1306_MODEL_PAGES - 1U), 0);   // create cleared it all
+    printf("%-26s %6u %6u\n", "create: init + full frame", (unsigned)s_oled.bytes, (unsigned)s_oled.transactions);
+    ssd1306_model_reset_stats(&s_oled);
+    HOST_CHECK_EQ(ssd1306_flush(disp), ESP_OK);   // nothing drawn since create
+    HOST_CHECK_EQ(s_oled.bytes, 0);
+
+    for (size_t i = 0; i < step_count; ++i) {
+        const bench_step_t *step = &s_steps[i];
+        ssd1306_model_reset_stats(&s_oled);
+        const int64_t t0 = host_clock_now_us();
+        step->update(disp);
+        HOST_CHECK_EQ(ssd1306_flush(disp), ESP_OK);
+        const int64_t wire_us = host_clock_now_us() - t0;
+
+        printf("%-26s %6u %6u %8lld\n", step->name, (unsigned)s_oled.bytes,
+               (unsigned)s_oled.transactions, (long long)wire_us);
+        if (s_oled.bytes > step->budget) {
+            fprintf(stderr, "%s: %u bytes, budget %u\n", step->name, (unsigned)s_oled.bytes,
+                    (unsigned)step->budget);
+            s_host_check_failures++;
+        }
+        if (memcmp(s_oled.gddram, expected[i], sizeof(s_oled.gddram)) != 0) {
+            fprintf(stderr, "%s: panel differs from a full redraw\n", step->name);
+            s_host_check_failures++;
+        }
+        HOST_CHECK_EQ(s_oled.unknown_cmds, 0);
+    }
+
+    ssd1306_destroy(disp);
+    (void)bsp_i2c_bus_release(BSP_I2C_BUS_DISPLAY);
+    return HOST_CHECK_RESULT();
+}
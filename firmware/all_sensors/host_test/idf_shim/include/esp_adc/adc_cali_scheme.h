@@ -0,0 +1,5 @@
+#pragma once
+
+#include "esp_adc/adc_cali.h"
+
+// No calibration scheme: ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED stays undefined.
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_adc/adc_oneshot.h"
+
+// The host target has no digital controller (SOIL_SENSOR_HAS_DMA is 0), so
+// only what the bus backend table refers to is declared.
+typedef struct adc_continuous_ctx_t *adc_continuous_handle_t;
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle,
+                              uint8_t *buf,
+                              uint32_t length_max,
+                              uint32_t *out_length,
+                              uint32_t timeout_ms);
@@ -0,0 +1,8 @@
+#pragma once
+
+#define IRAM_ATTR
+// RTC memory is one linker section, so host_deep_sleep_restart() can keep it.
+#define RTC_DATA_ATTR   __attribute__((section("host_rtc")))
+#define RTC_NOINIT_ATTR __attribute__((section("host_rtc")))
+#define RTC_FAST_ATTR   __attribute__((section("host_rtc")))
+#define RTC_SLOW_ATTR   __attribute__((section("host_rtc")))
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "sdkconfig.h"
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+// Milliseconds of virtual time, like the on-target log timestamp.
+uint32_t esp_log_timestamp(void);
+uint32_t esp_log_early_timestamp(void);
+
+#define HOST_LOG_AT(level, letter, tag, format, ...) do {                                   \
+        if (CONFIG_LOG_MAXIMUM_LEVEL >= (level)) {                                          \
+            esp_log_write((level), (tag), letter " (%u) %s: " format "\n",                  \
+                          (unsigned)esp_log_timestamp(), (tag), ##__VA_ARGS__);             \
+        }                                                                                   \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG_AT(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG_AT(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG_AT(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG_AT(ESP_LOG_DEBUG, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG_AT(ESP_LOG_VERBOSE, "V", tag, format, ##__VA_ARGS__)
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Advances the virtual clock instead of spinning.
+void esp_rom_delay_us(uint32_t us);
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Virtual microseconds since the host "boot", see host_idf.h.
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+// One thread, virtual time: see host_rtos.c for how "tasks" are scheduled.
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE  0
+#define pdTRUE   1
+#define pdFAIL   0
+#define pdPASS   1
+
+#define portMAX_DELAY        ((TickType_t)0xFFFFFFFFU)
+#define configTICK_RATE_HZ   CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS   ((TickType_t)1000U / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)    ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0U, 0U }
+#define portMUX_INITIALIZE(mux)      ((mux)->owner = 0U, (mux)->count = 0U)
+// Nothing preempts the host "tasks", so critical sections only nest a count.
+#define taskENTER_CRITICAL(mux)      ((void)((mux)->count++))
+#define taskEXIT_CRITICAL(mux)       ((void)((mux)->count--))
+
+#ifndef BIT0
+#define BIT0 0x00000001U
+#define BIT1 0x00000002U
+#define BIT2 0x00000004U
+#define BIT3 0x00000008U
+#endif
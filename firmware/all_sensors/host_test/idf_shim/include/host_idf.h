@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_sleep.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Virtual Clock
+   ========================================================================= */
+// Microseconds since the host "boot". Only delays, bus transfers and
+// host_clock_advance_us() move it, so every run of a test is identical.
+int64_t host_clock_now_us(void);
+void host_clock_advance_us(int64_t us);
+// Time spent in esp_rom_delay_us(): the CPU busy-waiting rather than blocked.
+int64_t host_clock_spin_us(void);
+
+/* =========================================================================
+   SECTION: Tasks
+   ========================================================================= */
+// Runs every notified task until it blocks again, like the FSM task going
+// idle so lower priority work gets the CPU. A task function is re-entered
+// from the top each time, so it must not keep locals across its wait.
+void host_rtos_idle(void);
+
+/* =========================================================================
+   SECTION: Environment
+   ========================================================================= */
+void host_sleep_set_wakeup_cause(esp_sleep_wakeup_cause_t cause);
+// Deep sleep: RTC_DATA_ATTR variables keep their value, everything else
+// starts over. Re-runs the program from main() with `argv` (main's own) and
+// `cause` as the wakeup cause; returns only if that fails.
+void host_deep_sleep_restart(char **argv, esp_sleep_wakeup_cause_t cause);
+// Empties the in-memory NVS, as after a flash erase.
+void host_nvs_erase_all(void);
+// NULL: stderr.
+void host_log_set_output(FILE *out);
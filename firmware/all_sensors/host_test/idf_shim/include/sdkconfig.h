@@ -0,0 +1,19 @@
+#pragma once
+
+// Host build configuration. Defaults follow sdkconfig.defaults; a test
+// target can override a value with a compile definition.
+#ifndef CONFIG_FREERTOS_HZ
+#define CONFIG_FREERTOS_HZ 100
+#endif
+#ifndef CONFIG_LOG_MAXIMUM_LEVEL
+#define CONFIG_LOG_MAXIMUM_LEVEL 3
+#endif
+#ifndef CONFIG_APP_SENSOR_BURST_COUNT
+#define CONFIG_APP_SENSOR_BURST_COUNT 1
+#endif
+#ifndef CONFIG_APP_BATTERY_MONITOR
+#define CONFIG_APP_BATTERY_MONITOR 0
+#endif
+#ifndef CONFIG_APP_FAST_BOOT
+#define CONFIG_APP_FAST_BOOT 0
+#endif
@@ -0,0 +1,3 @@
+#pragma once
+
+// The host has no ADC calibration scheme, so the line-fitting paths stay out.
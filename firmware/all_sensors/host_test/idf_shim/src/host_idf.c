@@ -0,0 +1,370 @@
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "driver/gpio.h"
+#include "driver/i2c_master.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "host_idf.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define HOST_LOG_TAGS     16
+#define HOST_LOG_TAG_LEN  24
+#define HOST_RTC_ENV      "HOST_RTC_STATE"
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+struct i2c_master_bus_t {
+    i2c_port_t port;
+};
+
+struct i2c_master_dev_t {
+    i2c_master_bus_handle_t bus;
+    uint16_t addr;
+};
+
+struct adc_oneshot_unit_ctx_t {
+    adc_unit_t unit;
+};
+
+typedef struct {
+    char tag[HOST_LOG_TAG_LEN];
+    esp_log_level_t level;
+} host_log_tag_t;
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static esp_sleep_wakeup_cause_t s_wake_cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+static FILE *s_log_out;
+static esp_log_level_t s_log_default = ESP_LOG_INFO;
+static host_log_tag_t s_log_tags[HOST_LOG_TAGS];
+static size_t s_log_tag_count;
+
+// Bounds of the RTC_DATA_ATTR section, provided by the linker.
+extern uint8_t __start_host_rtc[] __attribute__((weak));
+extern uint8_t __stop_host_rtc[] __attribute__((weak));
+
+/* =========================================================================
+   SECTION: Errors
+   ========================================================================= */
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+void host_esp_error_check_failed(esp_err_t rc, const char *file, int line, const char *expr)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: %s at %s:%d (%s)\n", esp_err_to_name(rc), file, line, expr);
+    abort();
+}
+
+/* =========================================================================
+   SECTION: Log
+   ========================================================================= */
+static esp_log_level_t host_log_level(const char *tag)
+{
+    for (size_t i = 0; i < s_log_tag_count; ++i) {
+        if (strcmp(s_log_tags[i].tag, tag) == 0) {
+            return s_log_tags[i].level;
+        }
+    }
+    return s_log_default;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    if (strcmp(tag, "*") == 0) {
+        s_log_default = level;
+        s_log_tag_count = 0;
+        return;
+    }
+    for (size_t i = 0; i < s_log_tag_count; ++i) {
+        if (strcmp(s_log_tags[i].tag, tag) == 0) {
+            s_log_tags[i].level = level;
+            return;
+        }
+    }
+    if (s_log_tag_count < HOST_LOG_TAGS) {
+        host_log_tag_t *slot = &s_log_tags[s_log_tag_count++];
+        (void)snprintf(slot->tag, sizeof(slot->tag), "%s", tag);
+        slot->level = level;
+    }
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    if (level > host_log_level(tag)) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    (void)vfprintf((s_log_out != NULL) ? s_log_out : stderr, format, args);
+    va_end(args);
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+uint32_t esp_log_early_timestamp(void)
+{
+    return esp_log_timestamp();
+}
+
+void host_log_set_output(FILE *out)
+{
+    s_log_out = out;
+}
+
+/* =========================================================================
+   SECTION: Sleep
+   ========================================================================= */
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void)
+{
+    return s_wake_cause;
+}
+
+void host_sleep_set_wakeup_cause(esp_sleep_wakeup_cause_t cause)
+{
+    s_wake_cause = cause;
+}
+
+static size_t host_rtc_size(void)
+{
+    return (__start_host_rtc != NULL) ? (size_t)(__stop_host_rtc - __start_host_rtc) : 0U;
+}
+
+// RTC memory and the wakeup cause go through a file named in the environment.
+void host_deep_sleep_restart(char **argv, esp_sleep_wakeup_cause_t cause)
+{
+    char path[] = "/tmp/host_rtc_XXXXXX";
+    const int fd = mkstemp(path);
+    FILE *out = (fd >= 0) ? fdopen(fd, "wb") : NULL;
+    if (out == NULL) {
+        perror("host_deep_sleep_restart");
+        return;
+    }
+    const size_t size = host_rtc_size();
+    const bool saved = (fwrite(&cause, sizeof(cause), 1, out) == 1U) &&
+                       ((size == 0U) || (fwrite(__start_host_rtc, size, 1, out) == 1U));
+    if ((fclose(out) != 0) || !saved || (setenv(HOST_RTC_ENV, path, 1) != 0)) {
+        perror(path);
+        (void)unlink(path);
+        return;
+    }
+
+    (void)fflush(NULL);
+    (void)execv("/proc/self/exe", argv);
+    perror("execv");
+    (void)unlink(path);
+}
+
+__attribute__((constructor)) static void host_rtc_restore(void)
+{
+    const char *path = getenv(HOST_RTC_ENV);
+    if (path == NULL) {
+        return;
+    }
+    FILE *in = fopen(path, "rb");
+    const size_t size = host_rtc_size();
+    if ((in == NULL) || (fread(&s_wake_cause, sizeof(s_wake_cause), 1, in) != 1U) ||
+        ((size != 0U) && (fread(__start_host_rtc, size, 1, in) != 1U))) {
+        fprintf(stderr, "%s: RTC memory not restored\n", path);
+        abort();
+    }
+    (void)fclose(in);
+    (void)unlink(path);
+    (void)unsetenv(HOST_RTC_ENV);
+}
+
+/* =========================================================================
+   SECTION: GPIO
+   ========================================================================= */
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    return (cfg != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    (void)level;
+    return ((gpio >= 0) && (gpio < GPIO_NUM_MAX)) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    (void)gpio;
+    return 1;
+}
+
+/* =========================================================================
+   SECTION: I2C
+   ========================================================================= */
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *cfg, i2c_master_bus_handle_t *out_bus)
+{
+    if ((cfg == NULL) || (out_bus == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_bus = calloc(1, sizeof(**out_bus));
+    if (*out_bus == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    (*out_bus)->port = cfg->i2c_port;
+    return ESP_OK;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus)
+{
+    free(bus);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus,
+                                    const i2c_device_config_t *cfg,
+                                    i2c_master_dev_handle_t *out_dev)
+{
+    if ((bus == NULL) || (cfg == NULL) || (out_dev == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_dev = calloc(1, sizeof(**out_dev));
+    if (*out_dev == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    (*out_dev)->bus = bus;
+    (*out_dev)->addr = cfg->device_address;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t dev)
+{
+    free(dev);
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus, uint16_t addr, int timeout_ms)
+{
+    (void)bus;
+    (void)addr;
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t *buf, size_t len, int timeout_ms)
+{
+    (void)dev;
+    (void)buf;
+    (void)len;
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t dev, uint8_t *buf, size_t len, int timeout_ms)
+{
+    (void)dev;
+    (void)buf;
+    (void)len;
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev,
+                                      const uint8_t *tx_buf,
+                                      size_t tx_len,
+                                      uint8_t *rx_buf,
+                                      size_t rx_len,
+                                      int timeout_ms)
+{
+    (void)dev;
+    (void)tx_buf;
+    (void)tx_len;
+    (void)rx_buf;
+    (void)rx_len;
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+/* =========================================================================
+   SECTION: ADC
+   ========================================================================= */
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *cfg, adc_oneshot_unit_handle_t *out_unit)
+{
+    if ((cfg == NULL) || (out_unit == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_unit = calloc(1, sizeof(**out_unit));
+    if (*out_unit == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    (*out_unit)->unit = cfg->unit_id;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t unit,
+                                     adc_channel_t channel,
+                                     const adc_oneshot_chan_cfg_t *cfg)
+{
+    (void)channel;
+    return ((unit != NULL) && (cfg != NULL)) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t unit, adc_channel_t channel, int *out_raw)
+{
+    (void)unit;
+    (void)channel;
+    (void)out_raw;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_oneshot_del_unit(adc_oneshot_unit_handle_t unit)
+{
+    free(unit);
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle,
+                              uint8_t *buf,
+                              uint32_t length_max,
+                              uint32_t *out_length,
+                              uint32_t timeout_ms)
+{
+    (void)handle;
+    (void)buf;
+    (void)length_max;
+    (void)out_length;
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *out_mv)
+{
+    (void)handle;
+    (void)raw;
+    (void)out_mv;
+    return ESP_ERR_NOT_SUPPORTED;
+}
@@ -0,0 +1,181 @@
+#include <string.h>
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "host_idf.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define HOST_NVS_KEYS      64
+#define HOST_NVS_KEY_LEN   16    // NVS keys are at most 15 characters
+#define HOST_NVS_VALUE_MAX 512
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+// Integers are stored as raw bytes of their own size; a typed get of the
+// wrong size reports the key missing, like a type mismatch does.
+typedef struct {
+    char key[HOST_NVS_KEY_LEN];
+    size_t len;
+    uint8_t value[HOST_NVS_VALUE_MAX];
+} host_nvs_entry_t;
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static host_nvs_entry_t s_entries[HOST_NVS_KEYS];
+static size_t s_entry_count;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static host_nvs_entry_t *host_nvs_find(const char *key)
+{
+    for (size_t i = 0; i < s_entry_count; ++i) {
+        if (strcmp(s_entries[i].key, key) == 0) {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t host_nvs_set(const char *key, const void *value, size_t len)
+{
+    if ((key == NULL) || (strlen(key) >= HOST_NVS_KEY_LEN) || (len > HOST_NVS_VALUE_MAX)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_nvs_entry_t *e = host_nvs_find(key);
+    if (e == NULL) {
+        if (s_entry_count == HOST_NVS_KEYS) {
+            return ESP_ERR_NVS_NO_FREE_PAGES;
+        }
+        e = &s_entries[s_entry_count++];
+        strcpy(e->key, key);
+    }
+    memcpy(e->value, value, len);
+    e->len = len;
+    return ESP_OK;
+}
+
+static esp_err_t host_nvs_get_exact(const char *key, void *out, size_t len)
+{
+    const host_nvs_entry_t *e = host_nvs_find(key);
+    if ((e == NULL) || (e->len != len)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    memcpy(out, e->value, len);
+    return ESP_OK;
+}
+
+/* =========================================================================
+   SECTION: Flash
+   ========================================================================= */
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    host_nvs_erase_all();
+    return ESP_OK;
+}
+
+void host_nvs_erase_all(void)
+{
+    memset(s_entries, 0, sizeof(s_entries));
+    s_entry_count = 0;
+}
+
+/* =========================================================================
+   SECTION: Handle
+   ========================================================================= */
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    (void)name;
+    (void)open_mode;
+    *out_handle = 1U;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    (void)handle;
+    host_nvs_entry_t *e = host_nvs_find(key);
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *e = s_entries[--s_entry_count];
+    return ESP_OK;
+}
+
+/* =========================================================================
+   SECTION: Values
+   ========================================================================= */
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    (void)handle;
+    return host_nvs_set(key, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    (void)handle;
+    const host_nvs_entry_t *e = host_nvs_find(key);
+    if (e == NULL) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    // Like ESP-IDF: NULL asks for the size, a short buffer is an error.
+    if (out_value != NULL) {
+        if (*length < e->len) {
+            return ESP_ERR_NVS_INVALID_LENGTH;
+        }
+        memcpy(out_value, e->value, e->len);
+    }
+    *length = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    (void)handle;
+    return host_nvs_set(key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value)
+{
+    (void)handle;
+    return host_nvs_get_exact(key, out_value, sizeof(*out_value));
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    (void)handle;
+    return host_nvs_set(key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value)
+{
+    (void)handle;
+    return host_nvs_get_exact(key, out_value, sizeof(*out_value));
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value)
+{
+    (void)handle;
+    return host_nvs_set(key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out_value)
+{
+    (void)handle;
+    return host_nvs_get_exact(key, out_value, sizeof(*out_value));
+}
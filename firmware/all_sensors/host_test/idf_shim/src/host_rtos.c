@@ -0,0 +1,285 @@
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "host_idf.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define HOST_MAX_TASKS   4
+#define HOST_TICK_US     (1000000LL / configTICK_RATE_HZ)
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+struct host_task {
+    TaskFunction_t fn;
+    void *arg;
+    const char *name;
+    uint32_t notify;
+    bool deleted;
+};
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static int64_t s_now_us;
+static int64_t s_spin_us;
+static struct host_task s_tasks[HOST_MAX_TASKS];
+static size_t s_task_count;
+static struct host_task *s_current;   // NULL: the test's own context
+static jmp_buf s_block_jmp;
+
+/* =========================================================================
+   SECTION: Virtual Clock
+   ========================================================================= */
+int64_t host_clock_now_us(void)
+{
+    return s_now_us;
+}
+
+void host_clock_advance_us(int64_t us)
+{
+    if (us > 0) {
+        s_now_us += us;
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    s_spin_us += us;
+    host_clock_advance_us(us);
+}
+
+int64_t host_clock_spin_us(void)
+{
+    return s_spin_us;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(s_now_us / HOST_TICK_US);
+}
+
+/* =========================================================================
+   SECTION: Tasks
+   ========================================================================= */
+static struct host_task *host_next_ready(void)
+{
+    for (size_t i = 0; i < s_task_count; ++i) {
+        if (!s_tasks[i].deleted && (s_tasks[i].notify > 0U)) {
+            return &s_tasks[i];
+        }
+    }
+    return NULL;
+}
+
+void host_rtos_idle(void)
+{
+    if (s_current != NULL) {
+        return;
+    }
+
+    struct host_task *task;
+    while ((task = host_next_ready()) != NULL) {
+        s_current = task;
+        if (setjmp(s_block_jmp) == 0) {
+            task->fn(task->arg);
+            task->deleted = true;   // returned without vTaskDelete()
+        }
+        s_current = NULL;
+    }
+}
+
+// Called where a real task would block with nothing to do.
+static void host_block(void)
+{
+    if (s_current != NULL) {
+        longjmp(s_block_jmp, 1);
+    }
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn,
+                       const char *name,
+                       uint32_t stack_depth,
+                       void *arg,
+                       UBaseType_t priority,
+                       TaskHandle_t *out_handle)
+{
+    (void)stack_depth;
+    (void)priority;
+    if ((fn == NULL) || (s_task_count >= HOST_MAX_TASKS)) {
+        return pdFAIL;
+    }
+
+    struct host_task *task = &s_tasks[s_task_count++];
+    *task = (struct host_task){ .fn = fn, .arg = arg, .name = name };
+    if (out_handle != NULL) {
+        *out_handle = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) {
+        task = s_current;
+    }
+    if (task != NULL) {
+        task->deleted = true;
+        if (task == s_current) {
+            host_block();
+        }
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    // Lower priority tasks run while the caller sleeps; whatever time they
+    // spend on the bus past the delay pushes the caller's wake-up out.
+    const int64_t wake_us = s_now_us + (int64_t)ticks * HOST_TICK_US;
+    host_rtos_idle();
+    if (s_now_us < wake_us) {
+        s_now_us = wake_us;
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_current;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    (void)ticks;
+    struct host_task *task = s_current;
+    if (task == NULL) {
+        return 0U;
+    }
+    if (task->notify == 0U) {
+        host_block();
+    }
+
+    const uint32_t value = task->notify;
+    task->notify = (clear_on_exit != pdFALSE) ? 0U : (value - 1U);
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    if (task != NULL) {
+        task->notify++;
+    }
+    return pdPASS;
+}
+
+/* =========================================================================
+   SECTION: Semaphores
+   ========================================================================= */
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+    if (sem != NULL) {
+        sem->in_use = true;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf)
+{
+    if (buf == NULL) {
+        return NULL;
+    }
+    *buf = (StaticSemaphore_t){ .in_use = true, .is_static = true };
+    return buf;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (sem == NULL) {
+        return pdFALSE;
+    }
+    // Contexts only switch where they block, never inside a lock, so a
+    // held mutex here means a missing give: report the timeout.
+    if (sem->held != 0U) {
+        host_clock_advance_us((ticks == portMAX_DELAY) ? 0 : (int64_t)ticks * HOST_TICK_US);
+        return pdFALSE;
+    }
+    sem->held = 1U;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if ((sem == NULL) || (sem->held == 0U)) {
+        return pdFALSE;
+    }
+    sem->held = 0U;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if ((sem != NULL) && !sem->is_static) {
+        free(sem);
+    }
+}
+
+/* =========================================================================
+   SECTION: Event Groups
+   ========================================================================= */
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buf)
+{
+    if (buf != NULL) {
+        buf->bits = 0U;
+    }
+    return buf;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    group->bits |= bits;
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    const EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group,
+                                EventBits_t bits,
+                                BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all,
+                                TickType_t ticks)
+{
+    const int64_t deadline_us = s_now_us + (int64_t)ticks * HOST_TICK_US;
+    host_rtos_idle();
+
+    const EventBits_t value = group->bits;
+    const bool met = (wait_for_all != pdFALSE) ? ((value & bits) == bits) : ((value & bits) != 0U);
+    if (!met) {
+        // Nothing else can set the bits, so the wait runs into its timeout.
+        if ((ticks != portMAX_DELAY) && (s_now_us < deadline_us)) {
+            s_now_us = deadline_us;
+        }
+        return value;
+    }
+    if (clear_on_exit != pdFALSE) {
+        group->bits &= ~bits;
+    }
+    return value;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+// Minimal checks for the host tests: report every failure, exit non-zero.
+static unsigned s_host_check_failures;
+
+#define HOST_CHECK(cond) do {                                                          \
+        if (!(cond)) {                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);  \
+            s_host_check_failures++;                                                   \
+        }                                                                              \
+    } while (0)
+
+#define HOST_CHECK_EQ(actual, expected) do {                                           \
+        const long long a_ = (long long)(actual);                                      \
+        const long long e_ = (long long)(expected);                                    \
+        if (a_ != e_) {                                                                \
+            fprintf(stderr, "%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__,  \
+                    #actual, a_, e_);                                                  \
+            s_host_check_failures++;                                                   \
+        }                                                                              \
+    } while (0)
+
+#define HOST_CHECK_RESULT() ((s_host_check_failures == 0U) ? 0 : 1)
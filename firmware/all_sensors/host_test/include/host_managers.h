@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "app_events.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+// Stand-ins for the managers a state callback calls into: events are
+// recorded instead of queued, power policy is fixed by the test.
+void host_managers_reset(void);
+uint32_t host_fsm_event_count(void);
+app_event_id_t host_fsm_last_event(void);
+void host_power_set_display_allowed(bool allowed);
+uint16_t host_power_last_battery_mv(void);
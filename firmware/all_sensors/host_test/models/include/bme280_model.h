@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "host_bus.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+// Register-level BME280 over I2C: trimming NVM, soft reset, sleep/forced
+// mode with the datasheet maximum conversion time, shadowed data registers.
+// Calibration words default to the BMP280 datasheet (section 3.12) worked
+// example, so a reading can be checked by hand.
+typedef struct {
+    host_i2c_model_t base;
+    uint8_t regs[256];
+    uint8_t ptr;
+    uint16_t calib_tp[12];          // dig_T1..dig_P9 as burned into NVM, copied in on reset
+    // Scripted ADC outputs, latched into the data registers when a
+    // conversion finishes.
+    int32_t adc_t;
+    int32_t adc_p;
+    int32_t adc_h;
+    uint32_t conv_extra_us;         // a slow part: added to the datasheet maximum
+    bool converting;
+    int64_t conv_start_us;
+    int64_t conv_end_us;
+    int64_t nvm_ready_us;
+    // What the driver did, for tests.
+    uint32_t conversions;
+    uint32_t resets;
+    uint32_t normal_mode_writes;
+    uint32_t data_reads;
+    uint32_t stale_reads;           // data burst read while a conversion ran
+    uint32_t status_reads;
+    int64_t last_conv_us;           // length of the last conversion
+    int64_t last_data_read_us;
+} bme280_model_t;
+
+#define BME280_MODEL_ADDR        0x76U
+#define BME280_MODEL_ADC_T_REF   519888    // 25.08 degC with the example trimming
+#define BME280_MODEL_ADC_P_REF   415148    // 100653.27 Pa at the same temperature
+
+void bme280_model_init(bme280_model_t *m, uint8_t bus);
+void bme280_model_set_adc(bme280_model_t *m, int32_t adc_t, int32_t adc_p, int32_t adc_h);
+// Datasheet section 9.1 maximum, for the oversampling now in ctrl_meas/ctrl_hum.
+uint32_t bme280_model_conv_time_us(const bme280_model_t *m);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "bsp_bus.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+#define HOST_BUS_MAX_MODELS    6
+#define HOST_BUS_ADC_CHANNELS  10
+
+typedef struct host_i2c_model host_i2c_model_t;
+
+// One scripted device. Concrete models embed this as their first member.
+struct host_i2c_model {
+    uint8_t bus;    // bsp_i2c_bus_id_t
+    uint16_t addr;
+    // One I2C transaction from the master, without the address byte.
+    esp_err_t (*write)(host_i2c_model_t *model, const uint8_t *buf, size_t len);
+    esp_err_t (*read)(host_i2c_model_t *model, uint8_t *buf, size_t len);
+};
+
+typedef struct {
+    bsp_bus_backend_t backend;   // install with bsp_bus_set_backend()
+    host_i2c_model_t *models[HOST_BUS_MAX_MODELS];
+    size_t model_count;
+    int adc_raw[HOST_BUS_ADC_CHANNELS];
+} host_bus_t;
+
+/* =========================================================================
+   SECTION: API
+   ========================================================================= */
+// Transfers advance the virtual clock by their wire time; an address with
+// no model NACKs.
+void host_bus_init(host_bus_t *hb);
+esp_err_t host_bus_attach(host_bus_t *hb, host_i2c_model_t *model);
+// The device is gone from the bus: its address NACKs until attached again.
+void host_bus_detach(host_bus_t *hb, host_i2c_model_t *model);
+void host_bus_set_adc(host_bus_t *hb, adc_channel_t channel, int raw);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "host_bus.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+// SSD1306 controller over I2C: control byte parsing (Co, D/C#), the
+// fundamental/addressing/hardware command set with argument counts, and
+// the 128x64 GDDRAM in page, horizontal and vertical addressing modes.
+// Scrolling is accepted but not rendered.
+#define SSD1306_MODEL_ADDR   0x3CU
+#define SSD1306_MODEL_PAGES  8U
+#define SSD1306_MODEL_COLS   128U
+
+typedef struct {
+    host_i2c_model_t base;
+    uint8_t gddram[SSD1306_MODEL_PAGES][SSD1306_MODEL_COLS];
+    uint8_t addr_mode;      // 0 horizontal, 1 vertical, 2 page
+    uint8_t col_start;
+    uint8_t col_end;
+    uint8_t page_start;
+    uint8_t page_end;
+    uint8_t col;
+    uint8_t page;
+    bool display_on;
+    bool charge_pump;
+    uint8_t contrast;
+    // Command being assembled; arguments may follow in a later transaction.
+    uint8_t cmd[8];
+    uint8_t cmd_len;
+    uint8_t cmd_need;
+    // Traffic since the last reset_stats.
+    uint32_t transactions;
+    uint32_t bytes;         // payload incl. control bytes, excl. address
+    uint32_t cmd_bytes;
+    uint32_t data_bytes;
+    uint32_t unknown_cmds;
+} ssd1306_model_t;
+
+void ssd1306_model_init(ssd1306_model_t *m, uint8_t bus);
+void ssd1306_model_reset_stats(ssd1306_model_t *m);
+bool ssd1306_model_pixel(const ssd1306_model_t *m, uint8_t x, uint8_t y);
+// Lit pixels in pages [page0, page1].
+uint32_t ssd1306_model_lit(const ssd1306_model_t *m, uint8_t page0, uint8_t page1);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "host_bus.h"
+
+#ifdef __cplusplus
+#error "This project uses C only."
+#endif
+
+// VEML7700 ambient light sensor: 16-bit little endian registers, ALS result
+// updated at the end of each integration period while powered on.
+typedef struct {
+    host_i2c_model_t base;
+    uint16_t regs[8];
+    uint8_t ptr;
+    float lux;                  // scripted scene
+    int64_t it_start_us;        // integration restarted by the last ALS_CONF write
+    uint32_t conf_writes;
+    uint32_t early_reads;       // ALS read before any integration finished
+} veml7700_model_t;
+
+#define VEML7700_MODEL_ADDR 0x10U
+
+void veml7700_model_init(veml7700_model_t *m, uint8_t bus, float lux);
+// Counts the current config would report for `lux`, saturating at 0xFFFF.
+uint16_t veml7700_model_counts(const veml7700_model_t *m, float lux);
@@ -0,0 +1,231 @@
+#include <string.h>
+#include "host_idf.h"
+#include "bme280_model.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define REG_CALIB_TP     0x88U
+#define REG_CHIP_ID      0xD0U
+#define REG_RESET        0xE0U
+#define REG_CALIB_H      0xE1U
+#define REG_CTRL_HUM     0xF2U
+#define REG_STATUS       0xF3U
+#define REG_CTRL_MEAS    0xF4U
+#define REG_CONFIG       0xF5U
+#define REG_DATA         0xF7U
+#define REG_DATA_END     0xFEU
+
+#define CHIP_ID          0x60U
+#define RESET_CMD        0xB6U
+#define STATUS_MEASURING 0x08U
+#define STATUS_IM_UPDATE 0x01U
+#define MODE_MASK        0x03U
+#define MODE_SLEEP       0x00U
+#define MODE_NORMAL      0x03U
+
+#define NVM_COPY_US      1500    // datasheet start-up time is 2 ms max
+
+/* =========================================================================
+   SECTION: Static Data
+   ========================================================================= */
+// dig_T1..T3, dig_P1..P9 (little endian words), BMP280 datasheet 3.12.
+static const uint16_t s_calib_tp[12] = {
+    27504U, 26435U, (uint16_t)-1000,
+    36477U, (uint16_t)-10685, 3024U, 2855U, 140U, (uint16_t)-7, 15500U, (uint16_t)-14600, 6000U,
+};
+
+// dig_H1 at 0xA1, dig_H2..H6 at 0xE1..0xE7: typical values off a real part.
+static const uint8_t s_calib_h1 = 75U;
+static const uint8_t s_calib_h[7] = { 0x6A, 0x01, 0x00, 0x13, 0x2B, 0x03, 0x1E };
+
+// osrs field to sample count, 0 = skipped.
+static const uint8_t s_osr[8] = { 0U, 1U, 2U, 4U, 8U, 16U, 16U, 16U };
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void model_latch(bme280_model_t *m)
+{
+    const uint8_t ctrl_meas = m->regs[REG_CTRL_MEAS];
+    const uint8_t osr_t = s_osr[(ctrl_meas >> 5) & 0x07U];
+    const uint8_t osr_p = s_osr[(ctrl_meas >> 2) & 0x07U];
+    const uint8_t osr_h = s_osr[m->regs[REG_CTRL_HUM] & 0x07U];
+
+    // A skipped measurement reads as 0x80000 (0x8000 for humidity).
+    const uint32_t p = (osr_p != 0U) ? (uint32_t)m->adc_p : 0x80000U;
+    const uint32_t t = (osr_t != 0U) ? (uint32_t)m->adc_t : 0x80000U;
+    const uint32_t h = (osr_h != 0U) ? (uint32_t)m->adc_h : 0x8000U;
+    m->regs[REG_DATA + 0] = (uint8_t)(p >> 12);
+    m->regs[REG_DATA + 1] = (uint8_t)(p >> 4);
+    m->regs[REG_DATA + 2] = (uint8_t)((p & 0x0FU) << 4);
+    m->regs[REG_DATA + 3] = (uint8_t)(t >> 12);
+    m->regs[REG_DATA + 4] = (uint8_t)(t >> 4);
+    m->regs[REG_DATA + 5] = (uint8_t)((t & 0x0FU) << 4);
+    m->regs[REG_DATA + 6] = (uint8_t)(h >> 8);
+    m->regs[REG_DATA + 7] = (uint8_t)h;
+}
+
+// Brings the register file up to the current virtual time.
+static void model_tick(bme280_model_t *m)
+{
+    const int64_t now = host_clock_now_us();
+    if ((m->regs[REG_STATUS] & STATUS_IM_UPDATE) && (now >= m->nvm_ready_us)) {
+        m->regs[REG_STATUS] &= (uint8_t)~STATUS_IM_UPDATE;
+    }
+    if (m->converting && (now >= m->conv_end_us)) {
+        model_latch(m);
+        m->converting = false;
+        m->regs[REG_STATUS] &= (uint8_t)~STATUS_MEASURING;
+        if ((m->regs[REG_CTRL_MEAS] & MODE_MASK) != MODE_NORMAL) {
+            m->regs[REG_CTRL_MEAS] &= (uint8_t)~MODE_MASK;   // forced mode ends in sleep
+        }
+    }
+}
+
+static void model_load_nvm(bme280_model_t *m)
+{
+    for (size_t i = 0; i < 12U; ++i) {
+        m->regs[REG_CALIB_TP + 2U * i] = (uint8_t)m->calib_tp[i];
+        m->regs[REG_CALIB_TP + 2U * i + 1U] = (uint8_t)(m->calib_tp[i] >> 8);
+    }
+    m->regs[0xA1] = s_calib_h1;
+    memcpy(&m->regs[REG_CALIB_H], s_calib_h, sizeof(s_calib_h));
+    m->regs[REG_CHIP_ID] = CHIP_ID;
+}
+
+static void model_reset(bme280_model_t *m)
+{
+    m->regs[REG_CTRL_HUM] = 0U;
+    m->regs[REG_CTRL_MEAS] = 0U;
+    m->regs[REG_CONFIG] = 0U;
+    m->regs[REG_STATUS] = STATUS_IM_UPDATE;
+    m->converting = false;
+    m->nvm_ready_us = host_clock_now_us() + NVM_COPY_US;
+    // Data registers read back as "skipped" until the first conversion.
+    static const uint8_t reset_data[8] = { 0x80, 0x00, 0x00, 0x80, 0x00, 0x00, 0x80, 0x00 };
+    memcpy(&m->regs[REG_DATA], reset_data, sizeof(reset_data));
+    model_load_nvm(m);
+    m->resets++;
+}
+
+static void model_write_reg(bme280_model_t *m, uint8_t reg, uint8_t value)
+{
+    switch (reg) {
+        case REG_RESET:
+            if (value == RESET_CMD) {
+                model_reset(m);
+            }
+            break;
+        case REG_CTRL_HUM:
+            m->regs[reg] = value & 0x07U;
+            break;
+        case REG_CTRL_MEAS:
+            m->regs[reg] = value;
+            if ((value & MODE_MASK) == MODE_NORMAL) {
+                m->normal_mode_writes++;
+            }
+            if (((value & MODE_MASK) != MODE_SLEEP) && !m->converting) {
+                const uint32_t conv_us = bme280_model_conv_time_us(m) + m->conv_extra_us;
+                m->converting = true;
+                m->conv_start_us = host_clock_now_us();
+                m->conv_end_us = m->conv_start_us + conv_us;
+                m->last_conv_us = conv_us;
+                m->regs[REG_STATUS] |= STATUS_MEASURING;
+                m->conversions++;
+            }
+            break;
+        case REG_CONFIG:
+            m->regs[reg] = value;
+            break;
+        default:
+            break;   // read-only
+    }
+}
+
+/* =========================================================================
+   SECTION: Bus Callbacks
+   ========================================================================= */
+// Burst write is register/value pairs; a lone byte only sets the pointer.
+static esp_err_t model_write(host_i2c_model_t *base, const uint8_t *buf, size_t len)
+{
+    bme280_model_t *m = (bme280_model_t *)base;
+    model_tick(m);
+    if (len == 1U) {
+        m->ptr = buf[0];
+        return ESP_OK;
+    }
+    if ((len % 2U) != 0U) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (size_t i = 0; i < len; i += 2U) {
+        model_write_reg(m, buf[i], buf[i + 1U]);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t model_read(host_i2c_model_t *base, uint8_t *buf, size_t len)
+{
+    bme280_model_t *m = (bme280_model_t *)base;
+    model_tick(m);
+    if (m->ptr == REG_STATUS) {
+        m->status_reads++;
+    }
+    if ((m->ptr >= REG_DATA) && (m->ptr <= REG_DATA_END)) {
+        m->data_reads++;
+        m->last_data_read_us = host_clock_now_us();
+        if (m->converting) {
+            m->stale_reads++;
+        }
+    }
+    for (size_t i = 0; i < len; ++i) {
+        buf[i] = m->regs[m->ptr++];
+    }
+    return ESP_OK;
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+void bme280_model_init(bme280_model_t *m, uint8_t bus)
+{
+    memset(m, 0, sizeof(*m));
+    m->base = (host_i2c_model_t){
+        .bus = bus,
+        .addr = BME280_MODEL_ADDR,
+        .write = model_write,
+        .read = model_read,
+    };
+    m->adc_t = BME280_MODEL_ADC_T_REF;
+    m->adc_p = BME280_MODEL_ADC_P_REF;
+    m->adc_h = 0x6000;
+    memcpy(m->calib_tp, s_calib_tp, sizeof(m->calib_tp));
+    model_reset(m);
+    // Power-on: NVM is copied long before the firmware gets here.
+    m->regs[REG_STATUS] = 0U;
+    m->resets = 0U;
+}
+
+void bme280_model_set_adc(bme280_model_t *m, int32_t adc_t, int32_t adc_p, int32_t adc_h)
+{
+    m->adc_t = adc_t;
+    m->adc_p = adc_p;
+    m->adc_h = adc_h;
+}
+
+uint32_t bme280_model_conv_time_us(const bme280_model_t *m)
+{
+    const uint8_t ctrl_meas = m->regs[REG_CTRL_MEAS];
+    const uint32_t osr_t = s_osr[(ctrl_meas >> 5) & 0x07U];
+    const uint32_t osr_p = s_osr[(ctrl_meas >> 2) & 0x07U];
+    const uint32_t osr_h = s_osr[m->regs[REG_CTRL_HUM] & 0x07U];
+
+    uint32_t us = 1250U + 2300U * osr_t;
+    if (osr_p != 0U) {
+        us += 2300U * osr_p + 575U;
+    }
+    if (osr_h != 0U) {
+        us += 2300U * osr_h + 575U;
+    }
+    return us;
+}
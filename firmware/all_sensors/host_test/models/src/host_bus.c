@@ -0,0 +1,145 @@
+#include <string.h>
+#include "host_idf.h"
+#include "host_bus.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define HOST_BUS_BITS_PER_BYTE   9U   // 8 data + ACK
+#define HOST_BUS_BITS_START_STOP 2U
+#define HOST_BUS_PROBE_HZ        100000U
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static host_i2c_model_t *host_bus_find(host_bus_t *hb, uint8_t bus, uint16_t addr)
+{
+    for (size_t i = 0; i < hb->model_count; ++i) {
+        if ((hb->models[i]->bus == bus) && (hb->models[i]->addr == addr)) {
+            return hb->models[i];
+        }
+    }
+    return NULL;
+}
+
+// Same bit count as the recorder, so trace time and virtual time agree.
+// Probes carry no device speed and are timed at standard mode.
+static void host_bus_spend(uint32_t bytes, uint32_t extra_bits, uint32_t scl_hz)
+{
+    const uint32_t hz = (scl_hz != 0U) ? scl_hz : HOST_BUS_PROBE_HZ;
+    const uint64_t bits = (uint64_t)bytes * HOST_BUS_BITS_PER_BYTE + HOST_BUS_BITS_START_STOP + extra_bits;
+    host_clock_advance_us((int64_t)((bits * 1000000ULL + hz - 1U) / hz));
+}
+
+/* =========================================================================
+   SECTION: Backend
+   ========================================================================= */
+static esp_err_t host_bus_probe(void *ctx, i2c_master_bus_handle_t bus, const bsp_bus_target_t *target, int timeout_ms)
+{
+    (void)bus;
+    (void)timeout_ms;
+    host_bus_spend(1U, 0U, target->scl_speed_hz);
+    return (host_bus_find(ctx, target->bus, target->addr) != NULL) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+static esp_err_t host_bus_transfer(void *ctx,
+                                   i2c_master_dev_handle_t dev,
+                                   const bsp_bus_target_t *target,
+                                   const uint8_t *tx_buf,
+                                   size_t tx_len,
+                                   uint8_t *rx_buf,
+                                   size_t rx_len,
+                                   int timeout_ms)
+{
+    (void)dev;
+    (void)timeout_ms;
+    host_i2c_model_t *model = host_bus_find(ctx, target->bus, target->addr);
+    if (model == NULL) {
+        host_bus_spend(1U, 0U, target->scl_speed_hz);
+        return ESP_ERR_INVALID_STATE;   // address NACK, as the IDF driver reports it
+    }
+
+    const bool both = (tx_len != 0U) && (rx_len != 0U);
+    host_bus_spend((uint32_t)(tx_len + rx_len) + (both ? 2U : 1U), both ? 1U : 0U, target->scl_speed_hz);
+
+    esp_err_t err = ESP_OK;
+    if (tx_len != 0U) {
+        err = model->write(model, tx_buf, tx_len);
+    }
+    if ((err == ESP_OK) && (rx_len != 0U)) {
+        err = (model->read != NULL) ? model->read(model, rx_buf, rx_len) : ESP_ERR_INVALID_STATE;
+    }
+    return err;
+}
+
+static esp_err_t host_bus_adc_read(void *ctx, adc_oneshot_unit_handle_t unit, adc_channel_t channel, int *out_raw)
+{
+    host_bus_t *hb = ctx;
+    (void)unit;
+    if (((unsigned)channel >= HOST_BUS_ADC_CHANNELS) || (out_raw == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_raw = hb->adc_raw[channel];
+    return ESP_OK;
+}
+
+static esp_err_t host_bus_adc_dma_read(void *ctx,
+                                       adc_continuous_handle_t handle,
+                                       uint8_t *buf,
+                                       uint32_t len,
+                                       uint32_t *out_len,
+                                       uint32_t timeout_ms)
+{
+    (void)ctx;
+    (void)handle;
+    (void)buf;
+    (void)len;
+    (void)out_len;
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+void host_bus_init(host_bus_t *hb)
+{
+    memset(hb, 0, sizeof(*hb));
+    hb->backend = (bsp_bus_backend_t){
+        .i2c_probe = host_bus_probe,
+        .i2c_transfer = host_bus_transfer,
+        .adc_read = host_bus_adc_read,
+        .adc_dma_read = host_bus_adc_dma_read,
+        .ctx = hb,
+    };
+}
+
+esp_err_t host_bus_attach(host_bus_t *hb, host_i2c_model_t *model)
+{
+    if ((model == NULL) || (model->write == NULL)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (hb->model_count >= HOST_BUS_MAX_MODELS) {
+        return ESP_ERR_NO_MEM;
+    }
+    hb->models[hb->model_count++] = model;
+    return ESP_OK;
+}
+
+void host_bus_detach(host_bus_t *hb, host_i2c_model_t *model)
+{
+    for (size_t i = 0; i < hb->model_count; ++i) {
+        if (hb->models[i] == model) {
+            hb->models[i] = hb->models[--hb->model_count];
+            hb->models[hb->model_count] = NULL;
+            return;
+        }
+    }
+}
+
+void host_bus_set_adc(host_bus_t *hb, adc_channel_t channel, int raw)
+{
+    if ((unsigned)channel < HOST_BUS_ADC_CHANNELS) {
+        hb->adc_raw[channel] = raw;
+    }
+}
@@ -0,0 +1,202 @@
+#include <string.h>
+#include "ssd1306_model.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define CTRL_CO          0x80U   // one byte follows, then another control byte
+#define CTRL_DC          0x40U   // data (GDDRAM) rather than command
+
+#define MODE_HORIZONTAL  0U
+#define MODE_VERTICAL    1U
+#define MODE_PAGE        2U
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+// Argument bytes after the opcode, datasheet section 9 command table.
+static uint8_t model_cmd_args(uint8_t op)
+{
+    switch (op) {
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1U;
+        case 0x21: case 0x22: case 0xA3:
+            return 2U;
+        case 0x29: case 0x2A:
+            return 5U;
+        case 0x26: case 0x27:
+            return 6U;
+        default:
+            return 0U;
+    }
+}
+
+static bool model_cmd_known(uint8_t op)
+{
+    return (op <= 0x22U) || ((op >= 0x26U) && (op <= 0x2FU)) || ((op >= 0x40U) && (op <= 0x7FU)) ||
+           (op == 0x81U) || (op == 0x8DU) || ((op >= 0xA0U) && (op <= 0xA8U)) || (op == 0xAEU) ||
+           (op == 0xAFU) || ((op >= 0xB0U) && (op <= 0xB7U)) || (op == 0xC0U) || (op == 0xC8U) ||
+           (op == 0xD3U) || (op == 0xD5U) || (op == 0xD9U) || (op == 0xDAU) || (op == 0xDBU) || (op == 0xE3U);
+}
+
+static void model_exec(ssd1306_model_t *m)
+{
+    const uint8_t op = m->cmd[0];
+    if (!model_cmd_known(op)) {
+        m->unknown_cmds++;
+        return;
+    }
+
+    if (op <= 0x0FU) {
+        m->col = (uint8_t)((m->col & 0xF0U) | op);
+    } else if (op <= 0x1FU) {
+        m->col = (uint8_t)((m->col & 0x0FU) | ((op & 0x07U) << 4));
+    } else if ((op >= 0xB0U) && (op <= 0xB7U)) {
+        m->page = op & 0x07U;
+    } else {
+        switch (op) {
+            case 0x20:
+                m->addr_mode = m->cmd[1] & 0x03U;
+                break;
+            case 0x21:
+                m->col_start = m->cmd[1] & 0x7FU;
+                m->col_end = m->cmd[2] & 0x7FU;
+                m->col = m->col_start;
+                break;
+            case 0x22:
+                m->page_start = m->cmd[1] & 0x07U;
+                m->page_end = m->cmd[2] & 0x07U;
+                m->page = m->page_start;
+                break;
+            case 0x81:
+                m->contrast = m->cmd[1];
+                break;
+            case 0x8D:
+                m->charge_pump = (m->cmd[1] & 0x04U) != 0U;
+                break;
+            case 0xAE:
+            case 0xAF:
+                m->display_on = (op == 0xAFU);
+                break;
+            default:
+                break;   // hardware configuration the pixel view does not need
+        }
+    }
+}
+
+static void model_command_byte(ssd1306_model_t *m, uint8_t value)
+{
+    m->cmd_bytes++;
+    if (m->cmd_need == 0U) {
+        m->cmd[0] = value;
+        m->cmd_len = 1U;
+        m->cmd_need = model_cmd_args(value);
+    } else {
+        m->cmd[m->cmd_len++] = value;
+        m->cmd_need--;
+    }
+    if (m->cmd_need == 0U) {
+        model_exec(m);
+    }
+}
+
+static void model_data_byte(ssd1306_model_t *m, uint8_t value)
+{
+    m->data_bytes++;
+    m->gddram[m->page & 0x07U][m->col & 0x7FU] = value;
+
+    switch (m->addr_mode) {
+        case MODE_HORIZONTAL:
+            if (m->col++ >= m->col_end) {
+                m->col = m->col_start;
+                m->page = (m->page >= m->page_end) ? m->page_start : (uint8_t)(m->page + 1U);
+            }
+            break;
+        case MODE_VERTICAL:
+            if (m->page++ >= m->page_end) {
+                m->page = m->page_start;
+                m->col = (m->col >= m->col_end) ? m->col_start : (uint8_t)(m->col + 1U);
+            }
+            break;
+        default:
+            // Page mode: the column wraps, the page stays.
+            m->col = (uint8_t)((m->col + 1U) & 0x7FU);
+            break;
+    }
+}
+
+/* =========================================================================
+   SECTION: Bus Callbacks
+   ========================================================================= */
+static esp_err_t model_write(host_i2c_model_t *base, const uint8_t *buf, size_t len)
+{
+    ssd1306_model_t *m = (ssd1306_model_t *)base;
+    m->transactions++;
+    m->bytes += (uint32_t)len;
+
+    size_t i = 0;
+    while (i < len) {
+        const uint8_t ctrl = buf[i++];
+        if ((ctrl & (uint8_t)~(CTRL_CO | CTRL_DC)) != 0U) {
+            return ESP_ERR_INVALID_ARG;   // not a control byte
+        }
+        // Co set: a single byte, then the next control byte.
+        const size_t end = ((ctrl & CTRL_CO) != 0U) ? ((i < len) ? i + 1U : i) : len;
+        for (; i < end; ++i) {
+            if ((ctrl & CTRL_DC) != 0U) {
+                model_data_byte(m, buf[i]);
+            } else {
+                model_command_byte(m, buf[i]);
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+void ssd1306_model_init(ssd1306_model_t *m, uint8_t bus)
+{
+    memset(m, 0, sizeof(*m));
+    m->base = (host_i2c_model_t){
+        .bus = bus,
+        .addr = SSD1306_MODEL_ADDR,
+        .write = model_write,
+        .read = NULL,   // the I2C interface is write-only
+    };
+    // Reset state, datasheet section 10.
+    m->addr_mode = MODE_PAGE;
+    m->col_end = SSD1306_MODEL_COLS - 1U;
+    m->page_end = SSD1306_MODEL_PAGES - 1U;
+    m->contrast = 0x7FU;
+}
+
+void ssd1306_model_reset_stats(ssd1306_model_t *m)
+{
+    m->transactions = 0;
+    m->bytes = 0;
+    m->cmd_bytes = 0;
+    m->data_bytes = 0;
+    m->unknown_cmds = 0;
+}
+
+bool ssd1306_model_pixel(const ssd1306_model_t *m, uint8_t x, uint8_t y)
+{
+    if ((x >= SSD1306_MODEL_COLS) || (y >= SSD1306_MODEL_PAGES * 8U)) {
+        return false;
+    }
+    return (m->gddram[y / 8U][x] & (1U << (y % 8U))) != 0U;
+}
+
+uint32_t ssd1306_model_lit(const ssd1306_model_t *m, uint8_t page0, uint8_t page1)
+{
+    uint32_t lit = 0;
+    for (uint8_t page = page0; (page <= page1) && (page < SSD1306_MODEL_PAGES); ++page) {
+        for (uint8_t x = 0; x < SSD1306_MODEL_COLS; ++x) {
+            lit += (uint32_t)__builtin_popcount(m->gddram[page][x]);
+        }
+    }
+    return lit;
+}
@@ -0,0 +1,123 @@
+#include <string.h>
+#include "host_idf.h"
+#include "veml7700_model.h"
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define REG_ALS_CONF   0x00U
+#define REG_ALS        0x04U
+#define REG_WHITE      0x05U
+#define REG_COUNT      8U
+
+#define CONF_SD        0x0001U
+#define CONF_IT_SHIFT  6
+#define CONF_SM_SHIFT  11
+#define CONF_DEFAULT   CONF_SD    // power-on: gain x1, 100 ms, shut down
+
+// Lux per count at gain x2 and 800 ms, the same constant the driver's
+// resolution table is built from.
+#define RES_X2_800MS   0.0288f
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static uint32_t model_it_ms(uint16_t conf)
+{
+    switch ((conf >> CONF_IT_SHIFT) & 0x0FU) {
+        case 0x0CU: return 25U;
+        case 0x08U: return 50U;
+        case 0x01U: return 200U;
+        case 0x02U: return 400U;
+        case 0x03U: return 800U;
+        default: return 100U;
+    }
+}
+
+// Gain x8 so x1/8 stays an integer.
+static uint32_t model_gain_x8(uint16_t conf)
+{
+    static const uint32_t gain_x8[4] = { 8U, 16U, 1U, 2U };   // x1, x2, x1/8, x1/4
+    return gain_x8[(conf >> CONF_SM_SHIFT) & 0x03U];
+}
+
+// The result register moves on once per finished integration period.
+static void model_tick(veml7700_model_t *m)
+{
+    const uint16_t conf = m->regs[REG_ALS_CONF];
+    if ((conf & CONF_SD) != 0U) {
+        return;
+    }
+    const int64_t it_us = (int64_t)model_it_ms(conf) * 1000;
+    if (host_clock_now_us() >= m->it_start_us + it_us) {
+        m->regs[REG_ALS] = veml7700_model_counts(m, m->lux);
+        m->regs[REG_WHITE] = m->regs[REG_ALS];
+    }
+}
+
+/* =========================================================================
+   SECTION: Bus Callbacks
+   ========================================================================= */
+static esp_err_t model_write(host_i2c_model_t *base, const uint8_t *buf, size_t len)
+{
+    veml7700_model_t *m = (veml7700_model_t *)base;
+    model_tick(m);
+    m->ptr = buf[0];
+    if (len == 1U) {
+        return ESP_OK;
+    }
+    if ((len != 3U) || (buf[0] >= REG_COUNT)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    const uint16_t value = (uint16_t)(buf[1] | (buf[2] << 8));
+    if (buf[0] == REG_ALS_CONF) {
+        m->regs[REG_ALS_CONF] = value;
+        m->it_start_us = host_clock_now_us();
+        m->conf_writes++;
+    } else if ((buf[0] != REG_ALS) && (buf[0] != REG_WHITE)) {
+        m->regs[buf[0]] = value;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t model_read(host_i2c_model_t *base, uint8_t *buf, size_t len)
+{
+    veml7700_model_t *m = (veml7700_model_t *)base;
+    model_tick(m);
+    if ((len != 2U) || (m->ptr >= REG_COUNT)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    if ((m->ptr == REG_ALS) && (m->regs[REG_ALS] == 0U)) {
+        m->early_reads++;
+    }
+    buf[0] = (uint8_t)m->regs[m->ptr];
+    buf[1] = (uint8_t)(m->regs[m->ptr] >> 8);
+    return ESP_OK;
+}
+
+/* =========================================================================
+   SECTION: Public API
+   ========================================================================= */
+void veml7700_model_init(veml7700_model_t *m, uint8_t bus, float lux)
+{
+    memset(m, 0, sizeof(*m));
+    m->base = (host_i2c_model_t){
+        .bus = bus,
+        .addr = VEML7700_MODEL_ADDR,
+        .write = model_write,
+        .read = model_read,
+    };
+    m->regs[REG_ALS_CONF] = CONF_DEFAULT;
+    m->lux = lux;
+}
+
+uint16_t veml7700_model_counts(const veml7700_model_t *m, float lux)
+{
+    const uint16_t conf = m->regs[REG_ALS_CONF];
+    // resolution = RES_X2_800MS * (2 / gain) * (800 / it)
+    const float res = RES_X2_800MS * (16.0f / (float)model_gain_x8(conf)) * (800.0f / (float)model_it_ms(conf));
+    const float counts = lux / res;
+    return (counts >= 65535.0f) ? 0xFFFFU : (uint16_t)counts;
+}
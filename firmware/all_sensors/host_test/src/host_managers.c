@@ -0,0 +1,71 @@
+#include "fsm_manager.h"
+#include "power_manager.h"
+#include "host_managers.h"
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static uint32_t s_event_count;
+static app_event_id_t s_last_event;
+static bool s_display_allowed = true;
+static uint16_t s_battery_mv;
+
+/* =========================================================================
+   SECTION: FSM Manager
+   ========================================================================= */
+esp_err_t fsm_manager_post_event(app_event_id_t event_id,
+                                 const void *event_data,
+                                 size_t event_data_size,
+                                 uint32_t timeout_ms)
+{
+    (void)event_data;
+    (void)event_data_size;
+    (void)timeout_ms;
+    s_event_count++;
+    s_last_event = event_id;
+    return ESP_OK;
+}
+
+/* =========================================================================
+   SECTION: Power Manager
+   ========================================================================= */
+bool power_manager_display_allowed(void)
+{
+    return s_display_allowed;
+}
+
+void power_manager_note_battery(uint16_t mv)
+{
+    s_battery_mv = mv;
+}
+
+/* =========================================================================
+   SECTION: Test Access
+   ========================================================================= */
+void host_managers_reset(void)
+{
+    s_event_count = 0;
+    s_last_event = (app_event_id_t)0;
+    s_display_allowed = true;
+    s_battery_mv = 0;
+}
+
+uint32_t host_fsm_event_count(void)
+{
+    return s_event_count;
+}
+
+app_event_id_t host_fsm_last_event(void)
+{
+    return s_last_event;
+}
+
+void host_power_set_display_allowed(bool allowed)
+{
+    s_display_allowed = allowed;
+}
+
+uint16_t host_power_last_battery_mv(void)
+{
+    return s_battery_mv;
+}
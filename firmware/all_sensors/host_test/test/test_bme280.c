@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "bsp_bus.h"
+#include "bsp_init.h"
+#include "bme280_task.h"
+#include "sensor_task_context.h"
+#include "host_idf.h"
+#include "host_bus.h"
+#include "host_check.h"
+#include "bme280_model.h"
+
+// The BME280 task against the register-level model: one forced conversion,
+// the wait computed once by bme280_cal_meas_delay() and spent blocked, then
+// one burst read of the data registers.
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define TICK_US             (1000000 / configTICK_RATE_HZ)
+#define MEAS_DELAY_US       7000     // bme280_cal_meas_delay(): T x1, P x1, H off
+#define REF_TEMP_CENTI_C    2508     // BMP280 datasheet 3.12 example
+#define REF_PRESS_CENTI_PA  10065328U // 64-bit integer path; the float example gives 100653.27 Pa
+#define TRACE_LEN           128
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static host_bus_t s_bus;
+static bme280_model_t s_bme;
+static bsp_bus_record_t s_records[TRACE_LEN];
+static bsp_bus_recorder_t s_rec;
+static i2c_master_bus_handle_t s_i2c;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void fresh_bus(bool with_sensor)
+{
+    host_bus_init(&s_bus);
+    bme280_model_init(&s_bme, BSP_I2C_BUS_SENSORS);
+    if (with_sensor) {
+        (void)host_bus_attach(&s_bus, &s_bme.base);
+    }
+    bsp_bus_recorder_init(&s_rec, &s_bus.backend, s_records, TRACE_LEN, NULL);
+    bsp_bus_set_backend(&s_rec.backend);
+}
+
+// Transfers to the sensor that started at or after `t_us`.
+static size_t records_since(int64_t t_us, bsp_bus_record_t *out, size_t cap)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < s_rec.count; ++i) {
+        if (((int64_t)s_records[i].t_us >= t_us) && (s_records[i].addr == BME280_MODEL_ADDR) && (n < cap)) {
+            out[n++] = s_records[i];
+        }
+    }
+    return n;
+}
+
+/* =========================================================================
+   SECTION: Tests
+   ========================================================================= */
+static void test_read_once_forced_sequence(void)
+{
+    fresh_bus(true);
+    sensor_data_t data = {0};
+    sensor_task_context_t shared = { .data = &data, .bus = s_i2c };
+    const int64_t spin0 = host_clock_spin_us();
+
+    HOST_CHECK_EQ(bme280_read_once(&shared), ESP_OK);
+
+    // Init soft-resets once; the conversion is the only one and forced.
+    HOST_CHECK_EQ(s_bme.resets, 1);
+    HOST_CHECK_EQ(s_bme.conversions, 1);
+    HOST_CHECK_EQ(s_bme.normal_mode_writes, 0);
+    HOST_CHECK((s_bme.regs[0xF4] & 0x03U) == 0U);
+    HOST_CHECK_EQ(s_bme.regs[0xF4] >> 2, (1U << 3) | 1U);   // osrs_t x1, osrs_p x1
+    HOST_CHECK_EQ(s_bme.regs[0xF2], 0);                     // humidity skipped
+
+    // Waited out the computed delay blocked: data read after the
+    // conversion ended, within the delay plus tick rounding.
+    const int64_t waited_us = s_bme.last_data_read_us - s_bme.conv_start_us;
+    HOST_CHECK_EQ(s_bme.stale_reads, 0);
+    HOST_CHECK(waited_us >= (int64_t)bme280_model_conv_time_us(&s_bme));
+    HOST_CHECK(waited_us <= MEAS_DELAY_US + 2 * TICK_US);
+    HOST_CHECK_EQ(host_clock_spin_us() - spin0, 0);
+
+    // After the trigger: one status check, then all data registers in one read.
+    bsp_bus_record_t after[8];
+    const size_t n = records_since(s_bme.conv_start_us, after, 8);
+    HOST_CHECK_EQ(n, 2);
+    HOST_CHECK_EQ(after[0].op, BSP_BUS_OP_WRITE_READ);
+    HOST_CHECK_EQ(after[0].rx_len, 1);
+    HOST_CHECK_EQ(after[1].op, BSP_BUS_OP_WRITE_READ);
+    HOST_CHECK_EQ(after[1].rx_len, 8);
+    HOST_CHECK_EQ(s_bme.data_reads, 1);
+
+    HOST_CHECK_EQ(data.temperature, 2982);
+    HOST_CHECK_EQ(data.pressure_cpa, REF_PRESS_CENTI_PA);
+}
+
+static void test_burst_overlaps_conversion(void)
+{
+    fresh_bus(true);
+    sensor_data_t data = {0};
+    sensor_task_context_t shared = { .data = &data, .bus = s_i2c };
+    HOST_CHECK_EQ(bme280_burst_begin(&shared), ESP_OK);
+
+    for (uint32_t i = 0; i < 3U; ++i) {
+        HOST_CHECK_EQ(bme280_burst_trigger(), ESP_OK);
+        // Other sensors use the conversion time; collect then has nothing
+        // left to wait for and goes straight to the status check.
+        host_clock_advance_us(MEAS_DELAY_US);
+        const int64_t t0 = host_clock_now_us();
+
+        int32_t temp = 0;
+        uint32_t press = 0;
+        HOST_CHECK_EQ(bme280_burst_collect(&temp, &press), ESP_OK);
+        HOST_CHECK(host_clock_now_us() - t0 < 1000);
+        HOST_CHECK_EQ(temp, REF_TEMP_CENTI_C);
+        HOST_CHECK_EQ(press, REF_PRESS_CENTI_PA);
+    }
+
+    // Forced mode sleeps after each conversion, so a trigger never has to
+    // reset the part first.
+    HOST_CHECK_EQ(s_bme.conversions, 3);
+    HOST_CHECK_EQ(s_bme.resets, 1);
+    HOST_CHECK_EQ(s_bme.data_reads, 3);
+    HOST_CHECK_EQ(s_bme.stale_reads, 0);
+}
+
+static void test_slow_part_is_polled(void)
+{
+    fresh_bus(true);
+    // Conversion runs past the rounded-up wait: the status bit holds the read back.
+    s_bme.conv_extra_us = 15000U;
+    sensor_data_t data = {0};
+    sensor_task_context_t shared = { .data = &data, .bus = s_i2c };
+    const uint32_t status_before = s_bme.status_reads;
+
+    HOST_CHECK_EQ(bme280_read_once(&shared), ESP_OK);
+    HOST_CHECK_EQ(s_bme.stale_reads, 0);
+    HOST_CHECK(s_bme.status_reads - status_before >= 3U);   // reset poll + at least two waits
+    HOST_CHECK(s_bme.last_data_read_us >= s_bme.conv_end_us);
+    HOST_CHECK_EQ(data.temperature, 2982);
+}
+
+static void test_stuck_part_times_out(void)
+{
+    fresh_bus(true);
+    // Never finishes within the polls: no reading may come from the
+    // registers, which still hold the reset value.
+    s_bme.conv_extra_us = 10U * 1000U * 1000U;
+    sensor_data_t data = {0};
+    sensor_task_context_t shared = { .data = &data, .bus = s_i2c };
+
+    HOST_CHECK(bme280_read_once(&shared) != ESP_OK);
+    HOST_CHECK_EQ(s_bme.data_reads, 0);
+    HOST_CHECK_EQ(data.temperature, 0);
+    HOST_CHECK_EQ(data.pressure_cpa, 0);
+
+    int32_t temp = 0;
+    uint32_t press = 0;
+    HOST_CHECK_EQ(bme280_burst_begin(&shared), ESP_OK);
+    HOST_CHECK_EQ(bme280_burst_trigger(), ESP_OK);
+    HOST_CHECK_EQ(bme280_burst_collect(&temp, &press), ESP_ERR_TIMEOUT);
+}
+
+static void test_missing_sensor_fails_fast(void)
+{
+    fresh_bus(false);
+    sensor_data_t data = {0};
+    sensor_task_context_t shared = { .data = &data, .bus = s_i2c };
+
+    HOST_CHECK(bme280_read_once(&shared) != ESP_OK);
+    HOST_CHECK_EQ(s_rec.total_transfers, 1);
+    HOST_CHECK_EQ(s_records[0].op, BSP_BUS_OP_PROBE);
+    HOST_CHECK(s_records[0].err != ESP_OK);
+}
+
+/* =========================================================================
+   SECTION: Main
+   ========================================================================= */
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    esp_log_level_set("BME_TASK", ESP_LOG_NONE);   // the failure cases log on purpose
+
+    fresh_bus(true);
+    HOST_CHECK_EQ(bsp_init(), ESP_OK);
+    HOST_CHECK_EQ(bsp_i2c_bus_acquire(BSP_I2C_BUS_SENSORS, &s_i2c), ESP_OK);
+
+    test_read_once_forced_sequence();
+    test_burst_overlaps_conversion();
+    test_slow_part_is_polled();
+    test_stuck_part_times_out();
+    test_missing_sensor_fails_fast();
+
+    (void)bsp_i2c_bus_release(BSP_I2C_BUS_SENSORS);
+    return HOST_CHECK_RESULT();
+}
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "board_pins.h"
+#include "bsp_bus.h"
+#include "bsp_init.h"
+#include "app_context.h"
+#include "fsm_state_callbacks.h"
+#include "host_idf.h"
+#include "host_bus.h"
+#include "host_check.h"
+#include "host_managers.h"
+#include "bme280_model.h"
+#include "veml7700_model.h"
+
+// Sensor health: a BME280 missing from the bus is retried on the next cycle
+// up to the failure threshold, then skipped for 1, 2, 4 ... cycles up to the
+// maximum, reported with SENSOR_FLAG_ENV_FAULT throughout. Once it answers
+// again the backoff and the flag clear and the regular period resumes.
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define HEALTH_LUX        450.0f
+#define HEALTH_SOIL_RAW   300
+#define HEALTH_SOIL_DRY   400U
+#define HEALTH_SOIL_WET   150U
+#define HEALTH_TRACE_LEN  256
+#define HEALTH_ENV_PERIOD 6U
+
+// Cycles the missing sensor is tried on: two retries, then gaps of 2, 3, 5
+// ... cycles as the skip doubles, capped at 64 skipped (a gap of 65).
+static const uint32_t s_fail_attempts[] = { 0, 1, 3, 6, 11, 20, 37, 70, 135, 200 };
+#define HEALTH_REATTACH_CYCLE  201U
+#define HEALTH_RECOVER_CYCLE   265U   // 200 + 64 skipped + 1
+#define HEALTH_LAST_CYCLE      280U
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static host_bus_t s_bus;
+static bme280_model_t s_bme;
+static veml7700_model_t s_veml;
+static bsp_bus_record_t s_records[HEALTH_TRACE_LEN];
+static bsp_bus_recorder_t s_rec;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void health_setup(void)
+{
+    esp_log_level_set("*", ESP_LOG_NONE);   // every failed probe logs on purpose
+    host_sleep_set_wakeup_cause(ESP_SLEEP_WAKEUP_TIMER);
+    host_managers_reset();
+    host_power_set_display_allowed(false);
+
+    host_bus_init(&s_bus);
+    bme280_model_init(&s_bme, BSP_I2C_BUS_SENSORS);
+    veml7700_model_init(&s_veml, BSP_I2C_BUS_SENSORS, HEALTH_LUX);
+    (void)host_bus_attach(&s_bus, &s_veml.base);   // BME280 not fitted yet
+    host_bus_set_adc(&s_bus, BSP_ADC_CHANNEL, HEALTH_SOIL_RAW);
+    bsp_bus_recorder_init(&s_rec, &s_bus.backend, s_records, HEALTH_TRACE_LEN, NULL);
+    bsp_bus_set_backend(&s_rec.backend);
+
+    HOST_CHECK_EQ(app_context_init(), ESP_OK);
+    config_t cfg = {0};
+    (void)app_context_get_config(&cfg);
+    cfg.soil_adc_dry = HEALTH_SOIL_DRY;
+    cfg.soil_adc_wet = HEALTH_SOIL_WET;
+    HOST_CHECK_EQ(app_context_set_config(&cfg), ESP_OK);
+}
+
+// One sensing cycle; true when it put anything on the wire to the BME280.
+static bool health_cycle(sensor_data_t *out_data)
+{
+    bsp_bus_recorder_reset(&s_rec);
+    state_sensing_on_enter();
+    state_sensing_on_exit(EXIT_MODE_DEFAULT);
+    HOST_CHECK_EQ(app_context_get_sensor_data(out_data), ESP_OK);
+
+    HOST_CHECK_EQ(s_rec.dropped, 0);
+    for (size_t i = 0; i < s_rec.count; ++i) {
+        if ((s_rec.records[i].bus == BSP_I2C_BUS_SENSORS) && (s_rec.records[i].addr == BME280_MODEL_ADDR)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_fail_attempt(uint32_t cycle)
+{
+    for (size_t i = 0; i < (sizeof(s_fail_attempts) / sizeof(s_fail_attempts[0])); ++i) {
+        if (s_fail_attempts[i] == cycle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* =========================================================================
+   SECTION: Tests
+   ========================================================================= */
+static void test_backoff_and_recovery(void)
+{
+    unsigned mismatches = 0;
+    for (uint32_t cycle = 0; cycle <= HEALTH_LAST_CYCLE; ++cycle) {
+        if (cycle == HEALTH_REATTACH_CYCLE) {
+            HOST_CHECK_EQ(host_bus_attach(&s_bus, &s_bme.base), ESP_OK);
+        }
+
+        sensor_data_t data = {0};
+        const bool tried = health_cycle(&data);
+        const bool recovered = (cycle >= HEALTH_RECOVER_CYCLE);
+        bool expect_try;
+        uint8_t expect_flags;
+        if (!recovered) {
+            // Never read yet: due every cycle, kept out only by the backoff.
+            expect_try = is_fail_attempt(cycle);
+            expect_flags = SENSOR_FLAG_ENV_FAULT | SENSOR_FLAG_ENV_STALE;
+        } else {
+            expect_try = (cycle == HEALTH_RECOVER_CYCLE) || ((cycle % HEALTH_ENV_PERIOD) == 0U);
+            expect_flags = expect_try ? 0U : SENSOR_FLAG_ENV_STALE;
+        }
+        if ((cycle % 2U) != 0U) {
+            expect_flags |= SENSOR_FLAG_LUX_STALE;
+        }
+
+        if ((tried != expect_try) || (data.flags != expect_flags)) {
+            if (mismatches < 5U) {
+                fprintf(stderr, "cycle %u: tried=%d flags=0x%02x, expected tried=%d flags=0x%02x\n",
+                        (unsigned)cycle, (int)tried, (unsigned)data.flags, (int)expect_try,
+                        (unsigned)expect_flags);
+            }
+            mismatches++;
+        }
+        if (cycle == HEALTH_RECOVER_CYCLE) {
+            HOST_CHECK_EQ(data.temperature, 2982);
+        }
+    }
+    HOST_CHECK_EQ(mismatches, 0);
+    HOST_CHECK_EQ(s_bme.conversions, 3);   // 265, then every 6th: 270 and 276
+}
+
+/* =========================================================================
+   SECTION: Main
+   ========================================================================= */
+int main(void)
+{
+    health_setup();
+    test_backoff_and_recovery();
+    return HOST_CHECK_RESULT();
+}
@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "bsp_bus.h"
+#include "bsp_init.h"
+#include "bme280_task.h"
+#include "sensor_burst.h"
+#include "sensor_task_context.h"
+#include "nvs_manager.h"
+#include "host_idf.h"
+#include "host_bus.h"
+#include "host_check.h"
+#include "bme280_model.h"
+
+// Temperature and pressure reach sensor_data_t without going through float:
+// register bytes -> Bosch integer compensation -> deci-Kelvin and 0.01 Pa,
+// bit for bit, and flash records written by the float build still read back.
+// Burst statistics survive a trip through flash.
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define CENTI_C_ZERO_K      27315
+#define REF_PRESS_CENTI_PA  10065328U   // datasheet example, 64-bit path
+
+// Raw ADC sweep: -40..85 degC plus both clamps, 300..1100 hPa plus both clamps.
+#define ADC_T_FIRST   380000
+#define ADC_T_LAST    640000
+#define ADC_T_STEP      6007
+#define ADC_P_FIRST   150000
+#define ADC_P_LAST    650000
+#define ADC_P_STEP     12011
+
+/* =========================================================================
+   SECTION: Types
+   ========================================================================= */
+// dig_T1..T3, dig_P1..P9 in NVM order.
+typedef struct {
+    uint16_t t1;
+    int16_t t2, t3;
+    uint16_t p1;
+    int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+} calib_t;
+
+// sensor_sample_t as flash held it before burst statistics (versions 1, 2).
+typedef struct {
+    uint32_t sample_seq;
+    uint32_t timestamp;
+    sensor_data_t data;
+} sample_v1_t;
+
+typedef struct {
+    uint32_t version;
+    sample_v1_t sample;
+} sample_record_v2_t;
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static host_bus_t s_bus;
+static bme280_model_t s_bme;
+static i2c_master_bus_handle_t s_i2c;
+
+// The datasheet example, and the trimming read off a real BME280.
+static const calib_t s_calibs[] = {
+    { 27504U, 26435, -1000, 36477U, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000 },
+    { 28485U, 26735, 50, 36738U, -10635, 3024, 6980, -4, -7, 9900, -10230, 4285 },
+};
+
+/* =========================================================================
+   SECTION: Reference
+   ========================================================================= */
+// Bosch Sensortec BME280 API v3.5.1 integer compensation (32-bit temperature,
+// 64-bit pressure), restated here so the driver is checked against it rather
+// than against itself. Note it divides where the datasheet listing shifts:
+// the two differ by one LSB for negative intermediates.
+static int32_t ref_temp_centi_c(const calib_t *c, int32_t adc_t, int32_t *out_t_fine)
+{
+    int32_t var1 = (int32_t)((adc_t / 8) - ((int32_t)c->t1 * 2));
+    var1 = (var1 * ((int32_t)c->t2)) / 2048;
+    int32_t var2 = (int32_t)((adc_t / 16) - ((int32_t)c->t1));
+    var2 = (((var2 * var2) / 4096) * ((int32_t)c->t3)) / 16384;
+    *out_t_fine = var1 + var2;
+
+    const int32_t t = (*out_t_fine * 5 + 128) / 256;
+    return (t < -4000) ? -4000 : ((t > 8500) ? 8500 : t);
+}
+
+static uint32_t ref_press_centi_pa(const calib_t *c, int32_t t_fine, int32_t adc_p)
+{
+    int64_t var1 = ((int64_t)t_fine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)c->p6;
+    var2 = var2 + ((var1 * (int64_t)c->p5) * 131072);
+    var2 = var2 + (((int64_t)c->p4) * 34359738368);
+    var1 = ((var1 * var1 * (int64_t)c->p3) / 256) + ((var1 * ((int64_t)c->p2) * 4096));
+    var1 = (((int64_t)1) * 140737488355328 + var1) * ((int64_t)c->p1) / 8589934592;
+    if (var1 == 0) {
+        return 3000000U;
+    }
+
+    int64_t var4 = 1048576 - adc_p;
+    var4 = (((var4 * INT64_C(2147483648)) - var2) * 3125) / var1;
+    var1 = (((int64_t)c->p9) * (var4 / 8192) * (var4 / 8192)) / 33554432;
+    var2 = (((int64_t)c->p8) * var4) / 524288;
+    var4 = ((var4 + var1 + var2) / 256) + (((int64_t)c->p7) * 16);
+    const uint32_t p = (uint32_t)(((var4 / 2) * 100) / 128);
+    return (p < 3000000U) ? 3000000U : ((p > 11000000U) ? 11000000U : p);
+}
+
+static uint16_t ref_temp_dk(int32_t temp_centi_c)
+{
+    return (uint16_t)((temp_centi_c + CENTI_C_ZERO_K + 5) / 10);
+}
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void fresh_sensor(const calib_t *c)
+{
+    host_bus_init(&s_bus);
+    bme280_model_init(&s_bme, BSP_I2C_BUS_SENSORS);
+    memcpy(s_bme.calib_tp, c, sizeof(s_bme.calib_tp));
+    (void)host_bus_attach(&s_bus, &s_bme.base);
+    bsp_bus_set_backend(&s_bus.backend);
+}
+
+/* =========================================================================
+   SECTION: Tests
+   ========================================================================= */
+static void test_burst_matches_reference(const calib_t *c)
+{
+    fresh_sensor(c);
+    sensor_data_t data = {0};
+    sensor_task_context_t shared = { .data = &data, .bus = s_i2c };
+    HOST_CHECK_EQ(bme280_burst_begin(&shared), ESP_OK);
+
+    unsigned mismatches = 0;
+    for (int32_t adc_t = ADC_T_FIRST; adc_t <= ADC_T_LAST; adc_t += ADC_T_STEP) {
+        for (int32_t adc_p = ADC_P_FIRST; adc_p <= ADC_P_LAST; adc_p += ADC_P_STEP) {
+            bme280_model_set_adc(&s_bme, adc_t, adc_p, 0);
+            int32_t temp = 0;
+            uint32_t press = 0;
+            if ((bme280_burst_trigger() != ESP_OK) || (bme280_burst_collect(&temp, &press) != ESP_OK)) {
+                mismatches++;
+                continue;
+            }
+
+            int32_t t_fine = 0;
+            const int32_t ref_t = ref_temp_centi_c(c, adc_t, &t_fine);
+            const uint32_t ref_p = ref_press_centi_pa(c, t_fine, adc_p);
+            if ((temp != ref_t) || (press != ref_p)) {
+                if (mismatches == 0U) {
+                    fprintf(stderr, "adc_t=%d adc_p=%d: %d cC %u cPa, reference %d cC %u cPa\n",
+                            (int)adc_t, (int)adc_p, (int)temp, (unsigned)press, (int)ref_t, (unsigned)ref_p);
+                }
+                mismatches++;
+            }
+        }
+    }
+    HOST_CHECK_EQ(mismatches, 0);
+}
+
+static void test_read_once_units(const calib_t *c)
+{
+    fresh_sensor(c);
+    unsigned mismatches = 0;
+    for (int32_t adc_t = ADC_T_FIRST; adc_t <= ADC_T_LAST; adc_t += 8 * ADC_T_STEP) {
+        for (int32_t adc_p = ADC_P_FIRST; adc_p <= ADC_P_LAST; adc_p += 8 * ADC_P_STEP) {
+            bme280_model_set_adc(&s_bme, adc_t, adc_p, 0);
+            sensor_data_t data = {0};
+            sensor_task_context_t shared = { .data = &data, .bus = s_i2c };
+            if (bme280_read_once(&shared) != ESP_OK) {
+                mismatches++;
+                continue;
+            }
+
+            int32_t t_fine = 0;
+            const int32_t ref_t = ref_temp_centi_c(c, adc_t, &t_fine);
+            if ((data.temperature != ref_temp_dk(ref_t)) ||
+                (data.pressure_cpa != ref_press_centi_pa(c, t_fine, adc_p))) {
+                mismatches++;
+            }
+        }
+    }
+    HOST_CHECK_EQ(mismatches, 0);
+}
+
+static void test_burst_mean_keeps_resolution(void)
+{
+    fresh_sensor(&s_calibs[0]);
+    sensor_data_t data = {0};
+    sensor_stats_t stats = {0};
+    sensor_task_context_t shared = { .data = &data, .bus = s_i2c };
+
+    HOST_CHECK_EQ(sensor_burst_run(&shared, SENSOR_MASK_ENV, 4U, &stats), SENSOR_MASK_ENV);
+    // Summed in 0.01 Pa, not rounded to Pa per reading first.
+    HOST_CHECK_EQ(data.pressure_cpa, REF_PRESS_CENTI_PA);
+    HOST_CHECK_EQ(data.temperature, 2982);
+    HOST_CHECK_EQ(stats.pressure.n, 4);
+    HOST_CHECK_EQ(stats.pressure.min, 10065);   // 0.1 hPa
+    HOST_CHECK_EQ(stats.pressure.max, 10065);
+    HOST_CHECK_EQ(stats.pressure.sd10, 0);
+}
+
+static void test_nvs_reads_float_records(void)
+{
+    host_nvs_erase_all();
+    HOST_CHECK_EQ(nvs_manager_init(), ESP_OK);
+
+    // A sample queued by the float build: no header, hPa float.
+    sample_v1_t v1 = { .sample_seq = 0U, .timestamp = 1700000000U };
+    v1.data.temperature = 2982U;
+    v1.data.flags = SENSOR_FLAG_LUX_STALE;
+    const float v1_hpa = 1006.5328f;
+    memcpy(&v1.data.pressure_cpa, &v1_hpa, sizeof(v1_hpa));
+    nvs_handle_t h = 0;
+    HOST_CHECK_EQ(nvs_open("app", NVS_READWRITE, &h), ESP_OK);
+    HOST_CHECK_EQ(nvs_set_blob(h, "s000", &v1, sizeof(v1)), ESP_OK);
+    HOST_CHECK_EQ(nvs_set_u32(h, "meta_next", 1U), ESP_OK);
+    HOST_CHECK_EQ(nvs_set_u32(h, "meta_cnt", 1U), ESP_OK);
+
+    sensor_sample_t v2 = { .timestamp = 1700000600U };
+    v2.data.temperature = 2990U;
+    v2.data.pressure_cpa = REF_PRESS_CENTI_PA + 1U;
+    HOST_CHECK_EQ(nvs_manager_store_sample(&v2), ESP_OK);
+
+    sensor_sample_t out[2];
+    size_t count = 0;
+    HOST_CHECK_EQ(nvs_manager_peek_oldest_samples(out, 2U, &count), ESP_OK);
+    HOST_CHECK_EQ(count, 2);
+    HOST_CHECK(abs((int)out[0].data.pressure_cpa - (int)REF_PRESS_CENTI_PA) <= 1);
+    HOST_CHECK_EQ(out[0].timestamp, 1700000000U);
+    HOST_CHECK_EQ(out[0].data.temperature, 2982);
+    HOST_CHECK_EQ(out[0].data.flags, SENSOR_FLAG_LUX_STALE);
+    HOST_CHECK_EQ(out[1].sample_seq, 1);
+    HOST_CHECK_EQ(out[1].data.pressure_cpa, REF_PRESS_CENTI_PA + 1U);
+
+    // A record from a newer build is reported, not misread.
+    const uint8_t unknown[40] = {0};
+    HOST_CHECK_EQ(nvs_set_blob(h, "s000", unknown, sizeof(unknown)), ESP_OK);
+    HOST_CHECK_EQ(nvs_manager_peek_oldest_samples(out, 2U, &count), ESP_ERR_INVALID_VERSION);
+}
+
+static void test_nvs_keeps_burst_stats(void)
+{
+    host_nvs_erase_all();
+    HOST_CHECK_EQ(nvs_manager_init(), ESP_OK);
+
+    // A version 2 record: header, no statistics.
+    const sample_record_v2_t v2 = {
+        .version = 2U,
+        .sample = { .timestamp = 1700000000U, .data = { .pressure_cpa = REF_PRESS_CENTI_PA } },
+    };
+    nvs_handle_t h = 0;
+    HOST_CHECK_EQ(nvs_open("app", NVS_READWRITE, &h), ESP_OK);
+    HOST_CHECK_EQ(nvs_set_blob(h, "s000", &v2, sizeof(v2)), ESP_OK);
+    HOST_CHECK_EQ(nvs_set_u32(h, "meta_next", 1U), ESP_OK);
+    HOST_CHECK_EQ(nvs_set_u32(h, "meta_cnt", 1U), ESP_OK);
+
+    sensor_sample_t burst = { .timestamp = 1700000600U };
+    burst.data.pressure_cpa = REF_PRESS_CENTI_PA;
+    burst.stats.pressure = (sensor_stat_t){ .min = 10064, .max = 10066, .sd10 = 7, .n = 4 };
+    burst.stats.soil = (sensor_stat_t){ .min = 39, .max = 41, .sd10 = 8, .n = 4 };
+    HOST_CHECK_EQ(nvs_manager_store_sample(&burst), ESP_OK);
+
+    // Single reads carry no statistics and stay in the shorter record.
+    sensor_sample_t single = { .timestamp = 1700001200U };
+    HOST_CHECK_EQ(nvs_manager_store_sample(&single), ESP_OK);
+    size_t len = 0;
+    HOST_CHECK_EQ(nvs_get_blob(h, "s002", NULL, &len), ESP_OK);
+    HOST_CHECK_EQ(len, sizeof(v2));
+
+    sensor_sample_t out[3];
+    size_t count = 0;
+    HOST_CHECK_EQ(nvs_manager_peek_oldest_samples(out, 3U, &count), ESP_OK);
+    HOST_CHECK_EQ(count, 3);
+    HOST_CHECK_EQ(out[0].data.pressure_cpa, REF_PRESS_CENTI_PA);
+    HOST_CHECK_EQ(out[0].stats.pressure.n, 0);
+    HOST_CHECK(memcmp(&out[1].stats, &burst.stats, sizeof(burst.stats)) == 0);
+    HOST_CHECK_EQ(out[1].timestamp, 1700000600U);
+    HOST_CHECK_EQ(out[2].timestamp, 1700001200U);
+    HOST_CHECK_EQ(out[2].stats.soil.n, 0);
+}
+
+/* =========================================================================
+   SECTION: Main
+   ========================================================================= */
+int main(void)
+{
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    esp_log_level_set("NVS_MGR", ESP_LOG_NONE);   // the unknown record logs on purpose
+
+    host_bus_init(&s_bus);
+    bsp_bus_set_backend(&s_bus.backend);
+    HOST_CHECK_EQ(bsp_init(), ESP_OK);
+    HOST_CHECK_EQ(bsp_i2c_bus_acquire(BSP_I2C_BUS_SENSORS, &s_i2c), ESP_OK);
+
+    for (size_t i = 0; i < (sizeof(s_calibs) / sizeof(s_calibs[0])); ++i) {
+        test_burst_matches_reference(&s_calibs[i]);
+        test_read_once_units(&s_calibs[i]);
+    }
+    test_burst_mean_keeps_resolution();
+    test_nvs_reads_float_records();
+    test_nvs_keeps_burst_stats();
+
+    (void)bsp_i2c_bus_release(BSP_I2C_BUS_SENSORS);
+    return HOST_CHECK_RESULT();
+}
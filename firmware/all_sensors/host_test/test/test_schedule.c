@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "board_pins.h"
+#include "bsp_bus.h"
+#include "bsp_init.h"
+#include "app_context.h"
+#include "fsm_state_callbacks.h"
+#include "host_idf.h"
+#include "host_bus.h"
+#include "host_check.h"
+#include "host_managers.h"
+#include "bme280_model.h"
+#include "veml7700_model.h"
+
+// Sensing cycles against the schedule: soil every cycle, lux every 2nd, env
+// every 6th, skipped fields carried forward and flagged stale, and a button
+// wake reading everything. Runs over three deep sleep wakes; the stage lives
+// in RTC memory like the schedule itself.
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define SCHED_LUX_A       450.0f   // level 1
+#define SCHED_LUX_B       150.0f   // level 2
+#define SCHED_SOIL_A      300      // 40 %
+#define SCHED_SOIL_B      250      // 60 %
+#define SCHED_ADC_T_B     530000
+#define SCHED_ADC_P_B     400000
+#define SCHED_SOIL_DRY    400U
+#define SCHED_SOIL_WET    150U
+#define SCHED_FIRST_WAKE_CYCLES 7U   // cycles 0..6, then sleep
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static host_bus_t s_bus;
+static bme280_model_t s_bme;
+static veml7700_model_t s_veml;
+
+RTC_DATA_ATTR static uint32_t s_stage;
+RTC_DATA_ATTR static uint16_t s_button_temp;   // read on the button wake
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void sched_setup(void)
+{
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    host_managers_reset();
+    host_power_set_display_allowed(false);
+
+    host_bus_init(&s_bus);
+    bme280_model_init(&s_bme, BSP_I2C_BUS_SENSORS);
+    veml7700_model_init(&s_veml, BSP_I2C_BUS_SENSORS, SCHED_LUX_A);
+    (void)host_bus_attach(&s_bus, &s_bme.base);
+    (void)host_bus_attach(&s_bus, &s_veml.base);
+    host_bus_set_adc(&s_bus, BSP_ADC_CHANNEL, SCHED_SOIL_A);
+    bsp_bus_set_backend(&s_bus.backend);
+
+    HOST_CHECK_EQ(app_context_init(), ESP_OK);
+    config_t cfg = {0};
+    (void)app_context_get_config(&cfg);
+    cfg.soil_adc_dry = SCHED_SOIL_DRY;
+    cfg.soil_adc_wet = SCHED_SOIL_WET;
+    HOST_CHECK_EQ(app_context_set_config(&cfg), ESP_OK);
+}
+
+static uint8_t stale_flags(uint32_t cycle)
+{
+    uint8_t flags = 0;
+    flags |= ((cycle % 2U) != 0U) ? SENSOR_FLAG_LUX_STALE : 0U;
+    flags |= ((cycle % 6U) != 0U) ? SENSOR_FLAG_ENV_STALE : 0U;
+    return flags;
+}
+
+// One sensing cycle; reports which I2C sensors were actually read.
+static sensor_data_t sched_cycle(bool *out_env_read, bool *out_lux_read)
+{
+    const uint32_t conversions = s_bme.conversions;
+    const uint32_t conf_writes = s_veml.conf_writes;
+    state_sensing_on_enter();
+    state_sensing_on_exit(EXIT_MODE_DEFAULT);
+    *out_env_read = (s_bme.conversions != conversions);
+    *out_lux_read = (s_veml.conf_writes != conf_writes);
+
+    sensor_data_t data = {0};
+    HOST_CHECK_EQ(app_context_get_sensor_data(&data), ESP_OK);
+    return data;
+}
+
+/* =========================================================================
+   SECTION: Tests
+   ========================================================================= */
+// Power-on timer wake, then connected-mode cycles without sleeping.
+static void test_periods_and_carry(void)
+{
+    bool env = false;
+    bool lux = false;
+    sensor_data_t data = sched_cycle(&env, &lux);
+    HOST_CHECK(env && lux);
+    HOST_CHECK_EQ(data.flags, 0);
+    HOST_CHECK_EQ(data.temperature, 2982);
+    HOST_CHECK_EQ(data.lux_level, 1);
+    HOST_CHECK_EQ(data.soil_moisture, 40);
+
+    // A new scene: only the sensors due in a cycle may show it.
+    s_veml.lux = SCHED_LUX_B;
+    bme280_model_set_adc(&s_bme, SCHED_ADC_T_B, SCHED_ADC_P_B, 0);
+    host_bus_set_adc(&s_bus, BSP_ADC_CHANNEL, SCHED_SOIL_B);
+
+    for (uint32_t cycle = 1; cycle < SCHED_FIRST_WAKE_CYCLES; ++cycle) {
+        data = sched_cycle(&env, &lux);
+        const uint8_t stale = stale_flags(cycle);
+        HOST_CHECK_EQ(data.flags, stale);
+        HOST_CHECK_EQ(env, (stale & SENSOR_FLAG_ENV_STALE) == 0U);
+        HOST_CHECK_EQ(lux, (stale & SENSOR_FLAG_LUX_STALE) == 0U);
+        HOST_CHECK_EQ(data.soil_moisture, 60);
+        HOST_CHECK_EQ(data.lux_level, (cycle == 1U) ? 1 : 2);
+        HOST_CHECK((data.temperature == 2982U) == (cycle < 6U));
+    }
+}
+
+// Cycle 7 would read soil only; a button wake reads everything.
+static void test_button_wake_reads_all(void)
+{
+    bool env = false;
+    bool lux = false;
+    const sensor_data_t data = sched_cycle(&env, &lux);
+    HOST_CHECK(env && lux);
+    HOST_CHECK_EQ(data.flags, 0);
+    HOST_CHECK_EQ(data.temperature, 2982);
+    HOST_CHECK_EQ(data.lux_level, 1);
+    s_button_temp = data.temperature;
+}
+
+// Cycle 8 on a timer wake: soil and lux due, env carried over deep sleep.
+static void test_timer_wake_carries_over_sleep(void)
+{
+    bme280_model_set_adc(&s_bme, SCHED_ADC_T_B, SCHED_ADC_P_B, 0);
+
+    bool env = false;
+    bool lux = false;
+    sensor_data_t data = sched_cycle(&env, &lux);
+    HOST_CHECK(!env && lux);
+    HOST_CHECK_EQ(data.flags, SENSOR_FLAG_ENV_STALE);
+    HOST_CHECK_EQ(data.temperature, s_button_temp);
+    HOST_CHECK_EQ(data.pressure_cpa, 10065328U);
+
+    data = sched_cycle(&env, &lux);
+    HOST_CHECK(!env && !lux);
+    HOST_CHECK_EQ(data.flags, stale_flags(9U));
+    HOST_CHECK_EQ(data.soil_moisture, 40);
+}
+
+/* =========================================================================
+   SECTION: Main
+   ========================================================================= */
+int main(int argc, char **argv)
+{
+    (void)argc;
+    sched_setup();
+
+    const uint32_t stage = s_stage++;
+    switch (stage) {
+        case 0:
+            host_sleep_set_wakeup_cause(ESP_SLEEP_WAKEUP_TIMER);
+            test_periods_and_carry();
+            if (s_host_check_failures == 0U) {
+                host_deep_sleep_restart(argv, ESP_SLEEP_WAKEUP_EXT0);
+            }
+            break;
+        case 1:
+            HOST_CHECK_EQ(esp_sleep_get_wakeup_cause(), ESP_SLEEP_WAKEUP_EXT0);
+            test_button_wake_reads_all();
+            if (s_host_check_failures == 0U) {
+                host_deep_sleep_restart(argv, ESP_SLEEP_WAKEUP_TIMER);
+            }
+            break;
+        default:
+            test_timer_wake_carries_over_sleep();
+            printf("schedule: %u wakes, %u cycles\n", (unsigned)(stage + 1U), (unsigned)(SCHED_FIRST_WAKE_CYCLES + 3U));
+            return HOST_CHECK_RESULT();
+    }
+    // Only reached when a stage failed or the restart did.
+    HOST_CHECK(stage >= 2U);
+    return HOST_CHECK_RESULT();
+}
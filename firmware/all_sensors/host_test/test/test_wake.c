@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "board_pins.h"
+#include "bsp_bus.h"
+#include "bsp_init.h"
+#include "app_context.h"
+#include "fsm_manager.h"
+#include "fsm_state_callbacks.h"
+#include "host_idf.h"
+#include "host_bus.h"
+#include "host_check.h"
+#include "host_managers.h"
+#include "bme280_model.h"
+#include "veml7700_model.h"
+#include "ssd1306_model.h"
+
+// One timer wake through the sensing state: the drivers, schedule and
+// display task run unchanged against device models on a virtual clock.
+// The bus trace goes to argv[1] for compare_bus_trace.py and the golden.
+
+/* =========================================================================
+   SECTION: Constants
+   ========================================================================= */
+#define WAKE_LUX          450.0f   // one count step in the default range, no auto-range
+#define WAKE_SOIL_RAW     300
+#define WAKE_SOIL_DRY     400U
+#define WAKE_SOIL_WET     150U
+#define WAKE_TRACE_LEN    256
+
+/* =========================================================================
+   SECTION: Static State
+   ========================================================================= */
+static host_bus_t s_bus;
+static bme280_model_t s_bme;
+static veml7700_model_t s_veml;
+static ssd1306_model_t s_oled;
+static bsp_bus_record_t s_records[WAKE_TRACE_LEN];
+static bsp_bus_recorder_t s_rec;
+
+/* =========================================================================
+   SECTION: Helpers
+   ========================================================================= */
+static void wake_setup(void)
+{
+    esp_log_level_set("*", ESP_LOG_WARN);
+    host_sleep_set_wakeup_cause(ESP_SLEEP_WAKEUP_TIMER);
+    host_managers_reset();
+
+    host_bus_init(&s_bus);
+    bme280_model_init(&s_bme, BSP_I2C_BUS_SENSORS);
+    veml7700_model_init(&s_veml, BSP_I2C_BUS_SENSORS, WAKE_LUX);
+    ssd1306_model_init(&s_oled, BSP_I2C_BUS_DISPLAY);
+    (void)host_bus_attach(&s_bus, &s_bme.base);
+    (void)host_bus_attach(&s_bus, &s_veml.base);
+    (void)host_bus_attach(&s_bus, &s_oled.base);
+    host_bus_set_adc(&s_bus, BSP_ADC_CHANNEL, WAKE_SOIL_RAW);
+
+    // esp_timer is the virtual clock on the host, so the default clock will do.
+    bsp_bus_recorder_init(&s_rec, &s_bus.backend, s_records, WAKE_TRACE_LEN, NULL);
+    bsp_bus_set_backend(&s_rec.backend);
+
+    HOST_CHECK_EQ(app_context_init(), ESP_OK);
+    config_t cfg = {0};
+    (void)app_context_get_config(&cfg);
+    cfg.soil_adc_dry = WAKE_SOIL_DRY;
+    cfg.soil_adc_wet = WAKE_SOIL_WET;
+    HOST_CHECK_EQ(app_context_set_config(&cfg), ESP_OK);
+}
+
+static void wake_check_readings(void)
+{
+    sensor_data_t data = {0};
+    HOST_CHECK_EQ(app_context_get_sensor_data(&data), ESP_OK);
+
+    // 25.08 degC from the datasheet example, in 0.1 K.
+    HOST_CHECK_EQ(data.temperature, 2982);
+    HOST_CHECK_EQ(data.pressure_cpa, 10065328U);   // Bosch 64-bit output, unrounded
+    HOST_CHECK_EQ(data.lux_level, 1);
+    HOST_CHECK_EQ(data.soil_moisture, 40);
+    HOST_CHECK_EQ(data.flags, 0);
+
+    HOST_CHECK_EQ(host_fsm_event_count(), 1);
+    HOST_CHECK_EQ(host_fsm_last_event(), APP_EVENT_SENSORS_DATA_READY);
+}
+
+static void wake_check_devices(void)
+{
+    // One forced conversion, read after it finished.
+    HOST_CHECK_EQ(s_bme.conversions, 1);
+    HOST_CHECK_EQ(s_bme.stale_reads, 0);
+    HOST_CHECK_EQ(s_bme.data_reads, 1);
+    HOST_CHECK((s_bme.regs[0xF4] & 0x03U) == 0U);   // back in sleep mode
+
+    // Configured once, shut down once, never read before integrating.
+    HOST_CHECK_EQ(s_veml.conf_writes, 2);
+    HOST_CHECK_EQ(s_veml.early_reads, 0);
+    HOST_CHECK((s_veml.regs[0] & 0x0001U) != 0U);
+
+    HOST_CHECK_EQ(s_oled.unknown_cmds, 0);
+    HOST_CHECK_EQ(s_rec.dropped, 0);
+}
+
+static void wake_dump_trace(const char *path)
+{
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        perror(path);
+        HOST_CHECK(out != NULL);
+        return;
+    }
+    host_log_set_output(out);
+    bsp_bus_recorder_dump(&s_rec);
+    host_log_set_output(NULL);
+    (void)fclose(out);
+}
+
+/* =========================================================================
+   SECTION: Main
+   ========================================================================= */
+int main(int argc, char **argv)
+{
+    wake_setup();
+
+    state_sensing_on_enter();
+    // The FSM waits for its next event; the display task gets the CPU.
+    host_rtos_idle();
+    HOST_CHECK(s_oled.display_on);
+    HOST_CHECK(s_oled.charge_pump);
+    HOST_CHECK(ssd1306_model_lit(&s_oled, 0, 5) > 0U);
+    HOST_CHECK_EQ(ssd1306_model_lit(&s_oled, 6, 7), 0);
+
+    state_sensing_on_exit(EXIT_MODE_DEFAULT);
+    host_rtos_idle();
+    HOST_CHECK(!s_oled.display_on);
+
+    wake_check_readings();
+    wake_check_devices();
+
+    printf("wake: %u transfers, %u bytes, %u us on the bus, %u ms virtual\n",
+           (unsigned)s_rec.total_transfers, (unsigned)s_rec.total_bytes,
+           (unsigned)s_rec.total_bus_us, (unsigned)(host_clock_now_us() / 1000));
+
+    if (argc > 1) {
+        wake_dump_trace(argv[1]);
+    }
+    return HOST_CHECK_RESULT();
+}
@@ -59,7 +59,8 @@ void app_main(void)
 {
     i2c_master_bus_handle_t disp_bus = NULL;
 
-    ESP_ERROR_CHECK(bsp_i2c_create_display_bus(&disp_bus));
+    ESP_ERROR_CHECK(bsp_init());
+    ESP_ERROR_CHECK(bsp_i2c_bus_acquire(BSP_I2C_BUS_DISPLAY, &disp_bus));
     ESP_ERROR_CHECK(ssd1306_create(disp_bus, &s_display));
     draw_event("Waiting...");
 
@@ -1,5 +1,8 @@
+#include "sdkconfig.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "app_boot_profile.h"
+#include "app_bus_trace.h"
 #include "app_context.h"
 #include "nvs_manager.h"
 #include "fsm_manager.h"
@@ -8,9 +11,16 @@ static const char *TAG = "APP";
 
 void app_main(void)
 {
+	app_boot_profile_mark(APP_BOOT_MARK_APP_MAIN);
+#if CONFIG_APP_FAST_BOOT
+	// Quiet logs otherwise; the boot breakdown is what this profile is judged by.
+	esp_log_level_set("BOOT", ESP_LOG_INFO);
+#endif
 	ESP_LOGI(TAG, "booting");
 
+	app_bus_trace_start();
 	ESP_ERROR_CHECK(app_context_init());
 	ESP_ERROR_CHECK(nvs_manager_init());
+	app_boot_profile_mark(APP_BOOT_MARK_NVS_READY);
 	ESP_ERROR_CHECK(fsm_manager_init(NULL));
 }
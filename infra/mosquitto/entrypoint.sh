@@ -1,6 +1,16 @@
 #!/bin/sh
 set -e
 
+# The broker key is generated on the host by gen_dev_certs.sh and is readable
+# by its owner only. Mosquitto drops to its own user, so hand the key over.
+KEY=/mosquitto/config/certs/server.key
+if [ ! -f "$KEY" ]; then
+    echo "missing $KEY, run infra/mosquitto/gen_dev_certs.sh on the host first" >&2
+    exit 1
+fi
+chown mosquitto:mosquitto "$KEY"
+chmod 600 "$KEY"
+
 /opt/venv/bin/python /mosquitto/agent/main.py &
 
 exec mosquitto -c /mosquitto/config/mosquitto.conf
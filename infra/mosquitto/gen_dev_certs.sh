@@ -0,0 +1,49 @@
+#!/bin/sh
+# Issues the broker key and certificate for the TLS listener on port 8883.
+# Run it on the machine that hosts the broker, before the first
+# `docker-compose up`. Keys stay on that machine: config/certs/*.key and
+# server.crt are git-ignored, only ca.crt is committed.
+#
+# The development CA is reused while config/certs/ca.key exists, so the
+# ca.crt embedded in the firmware stays valid. Without it (fresh checkout,
+# or NEW_CA=1) a new CA is created; copy config/certs/ca.crt to
+# firmware/all_sensors/components/managers/mqtt_manager/certs/ca.crt and
+# reflash the devices.
+set -e
+
+CERT_DIR="$(dirname "$0")/config/certs"
+BROKER_IP="${BROKER_IP:-172.20.10.2}"
+
+mkdir -p "$CERT_DIR"
+cd "$CERT_DIR"
+umask 077
+
+# P-256 keeps certificates small and the handshake cheap on the ESP32.
+if [ ! -f ca.key ] || [ "${NEW_CA:-0}" = "1" ]; then
+    openssl ecparam -name prime256v1 -genkey -noout -out ca.key
+    openssl req -x509 -new -key ca.key -sha256 -days 3650 \
+        -subj "/O=Smart Pot Dev/CN=Smart Pot Dev CA" -out ca.crt
+    chmod 644 ca.crt
+    echo "New CA created: copy $CERT_DIR/ca.crt into the firmware." >&2
+fi
+
+# mbedTLS in older ESP-IDF releases only matches dNSName entries, so the
+# broker IP is listed both as DNS and IP subject alternative name.
+cat > server.ext <<EXT
+basicConstraints = CA:FALSE
+keyUsage = digitalSignature
+extendedKeyUsage = serverAuth
+subjectAltName = DNS:localhost, DNS:${BROKER_IP}, IP:${BROKER_IP}, IP:127.0.0.1
+EXT
+
+# A previous key may belong to the container's mosquitto user by now.
+rm -f server.key
+openssl ecparam -name prime256v1 -genkey -noout -out server.key
+openssl req -new -key server.key -subj "/O=Smart Pot Dev/CN=${BROKER_IP}" -out server.csr
+openssl x509 -req -in server.csr -CA ca.crt -CAkey ca.key -CAcreateserial \
+    -days 3650 -sha256 -extfile server.ext -out server.crt
+chmod 644 server.crt
+
+# Owner-only; the container entrypoint hands the key to the mosquitto user.
+chmod 600 ca.key server.key
+rm -f server.csr server.ext ca.srl
@@ -0,0 +1,75 @@
+"""Before/after boot breakdown from two serial logs.
+
+Each log should hold several boots of one firmware build; every "BOOT:"
+breakdown line counts as one boot and the per-step median is compared, so
+one slow flash read or Wi-Fi retry does not decide the result.
+"""
+
+import argparse
+import re
+import statistics
+import sys
+from pathlib import Path
+
+LINE_RE = re.compile(
+    r"BOOT: rom\+bootloader ~(\d+) ms \(approx\.\), startup (\d+) ms, nvs \+(\d+), "
+    r"fsm \+(\d+), first sensor \+(\d+), app total (\d+) ms \(fast_boot=(\d)\)",
+)
+STEPS = (
+    "rom+bootloader (approx.)",
+    "startup",
+    "nvs",
+    "fsm",
+    "first sensor",
+    "app total",
+)
+
+
+def parse_log(path: Path) -> tuple[list[list[int]], set[int]]:
+    boots: list[list[int]] = []
+    profiles: set[int] = set()
+    for line in path.read_text(encoding="utf-8", errors="replace").splitlines():
+        match = LINE_RE.search(line)
+        if match is None:
+            continue
+        values = [int(v) for v in match.groups()]
+        boots.append(values[: len(STEPS)])
+        profiles.add(values[len(STEPS)])
+    return boots, profiles
+
+
+def medians(boots: list[list[int]]) -> list[float]:
+    return [statistics.median(step) for step in zip(*boots)]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("before", type=Path, help="serial log of the baseline build")
+    parser.add_argument("after", type=Path, help="serial log of the changed build")
+    args = parser.parse_args()
+
+    runs = {}
+    for name in ("before", "after"):
+        boots, profiles = parse_log(getattr(args, name))
+        if not boots:
+            print(
+                f"{name}: no BOOT breakdown line (BOOT tag below INFO?)",
+                file=sys.stderr,
+            )
+            return 2
+        runs[name] = (boots, profiles)
+
+    (before, before_fast), (after, after_fast) = runs["before"], runs["after"]
+    print(
+        f"boots: before {len(before)} (fast_boot={sorted(before_fast)}), "
+        f"after {len(after)} (fast_boot={sorted(after_fast)})"
+    )
+    print(f"{'step':26} {'before':>8} {'after':>8} {'delta':>8}")
+    for step, was, now in zip(STEPS, medians(before), medians(after)):
+        print(f"{step:26} {was:8.0f} {now:8.0f} {now - was:+8.0f}")
+    print("ms, median per step; the ROM + bootloader row is a lower bound")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
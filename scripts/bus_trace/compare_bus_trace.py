@@ -0,0 +1,97 @@
+"""Compare one wake's bus traffic against a reference trace.
+
+Input is a serial log of a firmware built with CONFIG_APP_BUS_TRACE. The
+last "BUS_TRACE: S,..." summary and the "T,..." records after it are used,
+so a log that spans several wakes compares the most recent one.
+"""
+
+import argparse
+import json
+import re
+import sys
+from collections import defaultdict
+from pathlib import Path
+
+LINE_RE = re.compile(r"BUS_TRACE: ([ST]),([^\s\x1b]*)")
+OPS = ["probe", "write", "read", "write_read", "adc", "adc_dma"]
+METRICS = ("transfers", "bytes", "bus_us")
+
+
+def parse_log(path: Path) -> tuple[list[int], list[list[int]]]:
+    summary: list[int] = []
+    records: list[list[int]] = []
+    for line in path.read_text(encoding="utf-8", errors="replace").splitlines():
+        match = LINE_RE.search(line)
+        if match is None:
+            continue
+        fields = [int(v, 0) for v in match.group(2).split(",")]
+        if match.group(1) == "S":
+            summary, records = fields, []
+        else:
+            records.append(fields)
+    return summary, records
+
+
+def summarize(summary: list[int], records: list[list[int]]) -> dict:
+    total = dict(zip(METRICS + ("dropped",), summary))
+    devices: dict[str, dict[str, int]] = defaultdict(lambda: dict.fromkeys(METRICS, 0))
+    for _t_us, bus, addr, op, tx_len, rx_len, bus_us, _err in records:
+        name = "adc" if bus == 0xFF else f"i2c{bus}/0x{addr:02x}"
+        key = f"{name} {OPS[op] if op < len(OPS) else op}"
+        devices[key]["transfers"] += 1
+        devices[key]["bytes"] += tx_len + rx_len
+        devices[key]["bus_us"] += bus_us
+    return {"total": total, "devices": dict(sorted(devices.items()))}
+
+
+def compare(current: dict, golden: dict, tolerance: float) -> bool:
+    ok = True
+    rows = [("total", current["total"], golden["total"])]
+    keys = sorted(set(current["devices"]) | set(golden["devices"]))
+    empty = dict.fromkeys(METRICS, 0)
+    rows += [(k, current["devices"].get(k, empty), golden["devices"].get(k, empty)) for k in keys]
+
+    for name, cur, ref in rows:
+        cells = []
+        for metric in METRICS:
+            now, was = cur.get(metric, 0), ref.get(metric, 0)
+            worse = now > was * (1.0 + tolerance)
+            ok &= not worse
+            mark = " !" if worse else ""
+            cells.append(f"{metric}={now} ({now - was:+d}){mark}")
+        print(f"{name:24} " + "  ".join(cells))
+
+    if current["total"].get("dropped"):
+        print(f"note: {current['total']['dropped']} records dropped, raise CONFIG_APP_BUS_TRACE_LEN")
+    return ok
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("log", type=Path, help="serial log with BUS_TRACE lines")
+    parser.add_argument("--golden", type=Path, help="reference trace summary (JSON)")
+    parser.add_argument("--write-golden", type=Path, help="store this wake as the reference")
+    parser.add_argument("--tolerance", type=float, default=0.0,
+                        help="allowed growth as a fraction, e.g. 0.05")
+    args = parser.parse_args()
+
+    summary, records = parse_log(args.log)
+    if not summary:
+        print("no BUS_TRACE summary in log (CONFIG_APP_BUS_TRACE off?)", file=sys.stderr)
+        return 2
+    current = summarize(summary, records)
+
+    if args.write_golden:
+        args.write_golden.write_text(json.dumps(current, indent=2) + "\n", encoding="utf-8")
+        print(f"wrote {args.write_golden}")
+    if args.golden is None:
+        if not args.write_golden:
+            print(json.dumps(current, indent=2))
+        return 0
+
+    golden = json.loads(args.golden.read_text(encoding="utf-8"))
+    return 0 if compare(current, golden, args.tolerance) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
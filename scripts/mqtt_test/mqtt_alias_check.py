@@ -0,0 +1,355 @@
+"""Check the device's MQTT 5 topic alias use against the local broker.
+
+The device side is spoken over a raw socket so the exact PUBLISH bytes the
+firmware sends, including an outbox resend after a reconnect, can be replayed.
+A paho subscriber checks what reaches the backend.
+"""
+
+import os
+import socket
+import struct
+import sys
+import threading
+import time
+import uuid
+
+import paho.mqtt.client as mqtt_client
+from paho.mqtt import enums
+
+BROKER_HOST = os.environ.get("MQTT_HOST", "localhost")
+BROKER_PORT = int(os.environ.get("MQTT_PORT", "1883"))
+UUID = os.environ.get("MQTT_DEVICE_UUID", "AABBCCDDEEFF")
+PASSWORD = os.environ.get("MQTT_DEVICE_PASSWORD", "device-password")
+BACKEND_USER = os.environ.get("MQTT_USER", "backend")
+BACKEND_PASSWORD = os.environ.get("MQTT_PASSWORD", "backend-password")
+
+TELEMETRY_TOPIC = f"devices/{UUID}/telemetry"
+DIAG_TOPIC = f"devices/{UUID}/diag"
+DIAG_ALIAS = 1  # the only aliased topic: diag is the one sent at QoS 0
+SESSION_EXPIRY_S = 7 * 24 * 3600
+TELEMETRY_EXPIRY_S = 7 * 24 * 3600
+DIAG_EXPIRY_S = 24 * 3600
+TIMEOUT_S = 5.0
+
+PROP_SESSION_EXPIRY = 0x11
+PROP_MESSAGE_EXPIRY = 0x02
+PROP_TOPIC_ALIAS = 0x23
+PROP_TOPIC_ALIAS_MAX = 0x22
+PROP_USER_PROPERTY = 0x26
+# CONNACK properties with a fixed size; the rest are strings or binary data.
+FIXED_PROP_SIZES = {
+    0x11: 4,
+    0x13: 2,
+    0x21: 2,
+    0x24: 1,
+    0x25: 1,
+    0x27: 4,
+    0x28: 1,
+    0x29: 1,
+    0x2A: 1,
+}
+
+
+def encode_varint(value: int) -> bytes:
+    out = bytearray()
+    while True:
+        byte = value % 128
+        value //= 128
+        out.append(byte | (0x80 if value else 0))
+        if not value:
+            return bytes(out)
+
+
+def decode_varint(data: bytes, pos: int) -> tuple[int, int]:
+    value, shift = 0, 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def encode_str(value: str) -> bytes:
+    raw = value.encode()
+    return struct.pack("!H", len(raw)) + raw
+
+
+def packet(first_byte: int, body: bytes) -> bytes:
+    return bytes([first_byte]) + encode_varint(len(body)) + body
+
+
+def connect_packet(client_id: str) -> bytes:
+    props = bytes([PROP_SESSION_EXPIRY]) + struct.pack("!I", SESSION_EXPIRY_S)
+    flags = 0x80 | 0x40  # username, password; clean start off like the firmware
+    body = (
+        encode_str("MQTT")
+        + bytes([5, flags])
+        + struct.pack("!H", 60)
+        + encode_varint(len(props))
+        + props
+        + encode_str(client_id)
+        + encode_str(UUID)
+        + encode_str(PASSWORD)
+    )
+    return packet(0x10, body)
+
+
+def publish_packet(  # noqa: PLR0913
+    topic: str,
+    payload: bytes,
+    qos: int,
+    packet_id: int = 0,
+    alias: int = 0,
+    *,
+    expiry_s: int = TELEMETRY_EXPIRY_S,
+    dup: bool = False,
+) -> bytes:
+    props = bytes([PROP_MESSAGE_EXPIRY]) + struct.pack("!I", expiry_s)
+    if alias:
+        props += bytes([PROP_TOPIC_ALIAS]) + struct.pack("!H", alias)
+    body = encode_str(topic)
+    if qos:
+        body += struct.pack("!H", packet_id)
+    body += encode_varint(len(props)) + props + payload
+    return packet(0x30 | (0x08 if dup else 0) | (qos << 1), body)
+
+
+class Device:
+    """Just enough of an MQTT 5 client to control every byte sent."""
+
+    def __init__(self) -> None:
+        self.sock = socket.create_connection(
+            (BROKER_HOST, BROKER_PORT),
+            timeout=TIMEOUT_S,
+        )
+        self.sock.sendall(connect_packet(UUID))
+        kind, body = self.read_packet()
+        if kind != 0x20 or body[1] != 0:  # noqa: PLR2004
+            msg = f"CONNACK refused: type=0x{kind:02X} body={body.hex()}"
+            raise RuntimeError(msg)
+        self.alias_max = self._alias_max(body)
+
+    @staticmethod
+    def _alias_max(connack: bytes) -> int:
+        props_len, pos = decode_varint(connack, 2)
+        end = pos + props_len
+        while pos < end:
+            prop = connack[pos]
+            pos += 1
+            if prop == PROP_TOPIC_ALIAS_MAX:
+                return struct.unpack_from("!H", connack, pos)[0]
+            if prop in FIXED_PROP_SIZES:
+                pos += FIXED_PROP_SIZES[prop]
+            elif prop == PROP_USER_PROPERTY:
+                for _ in range(2):
+                    pos += 2 + struct.unpack_from("!H", connack, pos)[0]
+            else:  # UTF-8 string or binary data
+                pos += 2 + struct.unpack_from("!H", connack, pos)[0]
+        return 0
+
+    def read_packet(self) -> tuple[int, bytes]:
+        head = self._read_exact(1)
+        length, shift = 0, 0
+        while True:
+            byte = self._read_exact(1)[0]
+            length |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        return head[0] & 0xF0, self._read_exact(length)
+
+    def _read_exact(self, size: int) -> bytes:
+        data = b""
+        while len(data) < size:
+            chunk = self.sock.recv(size - len(data))
+            if not chunk:
+                msg = "connection closed by broker"
+                raise ConnectionError(msg)
+            data += chunk
+        return data
+
+    def expect_puback(self, packet_id: int) -> None:
+        kind, body = self.read_packet()
+        if kind == 0xE0:  # noqa: PLR2004
+            reason = body[0] if body else 0
+            msg = f"broker disconnected, reason 0x{reason:02X}"
+            raise ConnectionError(msg)
+        ack_id = struct.unpack_from("!H", body)[0]
+        reason = body[2] if len(body) > 2 else 0  # noqa: PLR2004
+        if kind != 0x40 or ack_id != packet_id or reason >= 0x80:  # noqa: PLR2004
+            msg = f"bad PUBACK: type=0x{kind:02X} id={ack_id} reason=0x{reason:02X}"
+            raise RuntimeError(msg)
+
+    def ping(self) -> None:
+        self.sock.sendall(packet(0xC0, b""))
+        kind, _ = self.read_packet()
+        if kind == 0xE0:  # noqa: PLR2004
+            msg = "broker disconnected instead of PINGRESP"
+            raise ConnectionError(msg)
+
+    def drop(self) -> None:
+        # Like losing Wi-Fi: no DISCONNECT, so the session and the unacked
+        # PUBLISH stay open.
+        self.sock.close()
+
+    def close(self) -> None:
+        self.sock.sendall(packet(0xE0, b"\x00"))
+        self.sock.close()
+
+
+class Backend:
+    """Subscriber that collects telemetry and diag payloads by marker."""
+
+    def __init__(self) -> None:
+        self.received: list[str] = []
+        self.lock = threading.Lock()
+        self.ready = threading.Event()
+        self.client = mqtt_client.Client(
+            callback_api_version=enums.CallbackAPIVersion.VERSION2,
+            client_id=f"alias-check-{uuid.uuid4().hex[:8]}",
+            protocol=mqtt_client.MQTTv5,
+        )
+        self.client.username_pw_set(BACKEND_USER, BACKEND_PASSWORD)
+        self.client.on_connect = lambda c, *_: c.subscribe(
+            [(TELEMETRY_TOPIC, 1), (DIAG_TOPIC, 1)],
+        )
+        self.client.on_subscribe = lambda *_: self.ready.set()
+        self.client.on_message = self._on_message
+        self.client.connect(BROKER_HOST, BROKER_PORT, keepalive=60)
+        self.client.loop_start()
+        if not self.ready.wait(TIMEOUT_S):
+            msg = "backend subscription timed out"
+            raise RuntimeError(msg)
+
+    def _on_message(
+        self,
+        _c: mqtt_client.Client,
+        _u: object,
+        message: mqtt_client.MQTTMessage,
+    ) -> None:
+        with self.lock:
+            self.received.append(message.payload.decode(errors="replace"))
+
+    def wait_for(self, marker: str) -> bool:
+        deadline = time.monotonic() + TIMEOUT_S
+        while time.monotonic() < deadline:
+            with self.lock:
+                if any(marker in p for p in self.received):
+                    return True
+            time.sleep(0.05)
+        return False
+
+    def stop(self) -> None:
+        self.client.loop_stop()
+        self.client.disconnect()
+
+
+def payload(marker: str) -> bytes:
+    return f'{{"check":"{marker}"}}'.encode()
+
+
+def check_alias_on_one_connection(backend: Backend) -> None:
+    device = Device()
+    if device.alias_max < DIAG_ALIAS:
+        msg = f"broker grants {device.alias_max} aliases; raise max_topic_alias"
+        raise RuntimeError(msg)
+    device.sock.sendall(
+        publish_packet(
+            DIAG_TOPIC,
+            payload("bind"),
+            0,
+            alias=DIAG_ALIAS,
+            expiry_s=DIAG_EXPIRY_S,
+        ),
+    )
+    device.sock.sendall(
+        publish_packet(
+            "",
+            payload("alias-only"),
+            0,
+            alias=DIAG_ALIAS,
+            expiry_s=DIAG_EXPIRY_S,
+        ),
+    )
+    device.ping()
+    device.close()
+    if not (backend.wait_for("bind") and backend.wait_for("alias-only")):
+        msg = "QoS 0 aliased publish not delivered"
+        raise RuntimeError(msg)
+
+
+def check_outbox_resend_across_reconnect(backend: Backend) -> None:
+    # What the firmware sends for QoS 1: the full topic and no alias.
+    marker = f"resend-{uuid.uuid4().hex[:8]}"
+    sent = publish_packet(TELEMETRY_TOPIC, payload(marker), 1, packet_id=42)
+
+    device = Device()
+    device.sock.sendall(sent)
+    device.drop()
+
+    # esp-mqtt replays its outbox entry byte for byte on the next connection.
+    device = Device()
+    device.sock.sendall(bytes([sent[0] | 0x08]) + sent[1:])
+    device.expect_puback(42)
+    device.ping()
+    device.close()
+    if not backend.wait_for(marker):
+        msg = "resent QoS 1 publish not delivered"
+        raise RuntimeError(msg)
+
+
+def check_alias_only_resend_is_rejected() -> None:
+    # Control: an alias-only publish is meaningless on a new connection, which
+    # is why QoS 1 publishes, replayed from the outbox, carry no alias. The
+    # broker must refuse it; if it does not, this check proves nothing.
+    device = Device()
+    device.sock.sendall(
+        publish_packet(
+            "",
+            payload("stale-alias"),
+            1,
+            packet_id=43,
+            alias=DIAG_ALIAS,
+            dup=True,
+        ),
+    )
+    try:
+        device.expect_puback(43)
+    except ConnectionError as err:
+        print(f"  alias-only resend refused as expected ({err})")
+        return
+    finally:
+        device.sock.close()
+    msg = "broker accepted an alias-only publish on a fresh connection"
+    raise RuntimeError(msg)
+
+
+def main() -> int:
+    backend = Backend()
+    checks = [
+        ("alias on one connection", lambda: check_alias_on_one_connection(backend)),
+        (
+            "outbox resend across reconnect",
+            lambda: check_outbox_resend_across_reconnect(backend),
+        ),
+        ("alias-only resend rejected", check_alias_only_resend_is_rejected),
+    ]
+    failed = 0
+    try:
+        for name, check in checks:
+            try:
+                check()
+            except (RuntimeError, OSError) as err:
+                failed += 1
+                print(f"FAIL {name}: {err}")
+            else:
+                print(f"ok   {name}")
+    finally:
+        backend.stop()
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,115 @@
+"""Decode binary RTC log dumps published by the pot on devices/<id>/diag.
+
+Input is either JSON lines as printed by `mosquitto_sub -t 'devices/+/diag'`
+(only {"log": {...}} messages are used, parts are joined in order) or a raw
+binary file with --raw.
+"""
+
+import argparse
+import base64
+import json
+import re
+import struct
+import sys
+from pathlib import Path
+
+FIRMWARE_CORE = (
+    Path(__file__).resolve().parents[2]
+    / "firmware"
+    / "all_sensors"
+    / "components"
+    / "core"
+    / "include"
+)
+RECORD = struct.Struct("<HHI3I")  # app_rtc_log_rec_t, 20 bytes
+SPEC_RE = re.compile(r"%[udxfS]")
+
+
+def load_table(header: Path) -> list[tuple[str, str]]:
+    text = header.read_text(encoding="utf-8")
+    return re.findall(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', text)
+
+
+def load_states(header: Path) -> list[str]:
+    text = header.read_text(encoding="utf-8")
+    body = re.search(r"typedef enum\s*\{(.*?)\}\s*app_state_t", text, re.DOTALL)
+    if body is None:
+        return []
+    return re.findall(r"\b(STATE_\w+)", body.group(1))
+
+
+def format_record(
+    fmt: str,
+    args: tuple[int, int, int],
+    states: list[str],
+) -> str:
+    values = iter(args)
+
+    def convert(match: re.Match[str]) -> str:
+        raw = next(values, 0)
+        spec = match.group(0)[1]
+        if spec == "d":
+            return str(struct.unpack("<i", struct.pack("<I", raw))[0])
+        if spec == "x":
+            return f"{raw:x}"
+        if spec == "f":
+            return f"{struct.unpack('<f', struct.pack('<I', raw))[0]:.2f}"
+        if spec == "S":
+            return states[raw] if raw < len(states) else f"STATE_{raw}"
+        return str(raw)
+
+    return SPEC_RE.sub(convert, fmt)
+
+
+def decode(blob: bytes, table: list[tuple[str, str]], states: list[str]) -> None:
+    usable = len(blob) - len(blob) % RECORD.size
+    for offset in range(0, usable, RECORD.size):
+        msg_id, boot, ms, *args = RECORD.unpack_from(blob, offset)
+        if msg_id < len(table):
+            name, fmt = table[msg_id]
+            text = format_record(fmt, (args[0], args[1], args[2]), states)
+        else:
+            name, text = f"ID{msg_id}", " ".join(f"{a:#x}" for a in args)
+        print(f"boot {boot:5d} {ms:8d} ms  {name:<16} {text}")
+
+
+def collect_parts(lines: list[str]) -> bytes:
+    parts: dict[int, bytes] = {}
+    for line in lines:
+        start = line.find("{")
+        if start < 0:
+            continue
+        try:
+            msg = json.loads(line[start:])
+        except json.JSONDecodeError:
+            continue
+        log = msg.get("log") if isinstance(msg, dict) else None
+        if not isinstance(log, dict):
+            continue
+        if log.get("part") == 0:
+            parts.clear()  # a new dump starts
+        parts[int(log["part"])] = base64.b64decode(log.get("d", ""))
+    return b"".join(parts[i] for i in sorted(parts))
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("input", nargs="?", help="file to read, stdin if omitted")
+    parser.add_argument("--raw", action="store_true", help="input is a raw binary dump")
+    parser.add_argument("--include", type=Path, default=FIRMWARE_CORE)
+    opts = parser.parse_args()
+
+    table = load_table(opts.include / "app_rtc_log_ids.h")
+    states = load_states(opts.include / "app_states.h")
+
+    if opts.raw:
+        blob = Path(opts.input).read_bytes() if opts.input else sys.stdin.buffer.read()
+    else:
+        text = Path(opts.input).read_text(encoding="utf-8") if opts.input else sys.stdin.read()
+        blob = collect_parts(text.splitlines())
+
+    decode(blob, table, states)
+
+
+if __name__ == "__main__":
+    main()